@@ -1,7 +1,36 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <omp.h>
+#include <sys/mman.h>
+#include "mmap_input.h"
+#include "thread_backend.h"
+#include "thread_alloc.h"
+#include "cache_state.h"
+#include "prefault.h"
+
+// Base page size walked by bad-ma-tlb, and the huge page size used to align its array
+#define PAGE_SIZE_BYTES 4096
+#define HUGE_PAGE_SIZE_BYTES (2UL * 1024 * 1024)
+#define CACHE_LINE_SIZE 64
+
+// Per-thread result of the reduction modes, padded to its own cache line
+typedef struct {
+    unsigned long sum;
+    char padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
+} PaddedSum;
+
+// Shared state of the kernel, handed to the per-thread body on every backend
+typedef struct {
+    unsigned long *array;
+    unsigned long size;
+    unsigned long pages;          // bad-ma-tlb page span
+    unsigned long page_elems;
+    PaddedSum *thread_sums;       // reduction modes: each thread's total, combined after the region
+    unsigned long *partial_sums;  // bad-fs: packed accumulators updated on every element
+    ThreadAllocs *allocs;         // alloc modes: accumulators allocated by the threads themselves
+} SumContext;
 
 // Function to initialize the array
 void load_array(unsigned long *array, unsigned long size) {
@@ -10,45 +39,226 @@ void load_array(unsigned long *array, unsigned long size) {
     }
 }
 
+// Per-thread body of the good and bad-ma modes: reduce a static chunk into a private sum
+// (what reduction(+:sum) over a static schedule does), stored once at the end
+void sum_linear_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    backend_static_range(ctx->size, num_threads, tid, &start, &end);
+
+    unsigned long sum = 0;
+    for (unsigned long i = start; i < end; i++) {
+        sum += ctx->array[i];
+    }
+    ctx->thread_sums[tid].sum = sum;
+}
+
+// Per-thread body of bad-fs: accumulate a static chunk straight into a packed slot
+void sum_bad_fs_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    backend_static_range(ctx->size, num_threads, tid, &start, &end);
+
+    for (unsigned long i = start; i < end; i++) {
+        ctx->partial_sums[tid] += ctx->array[i];
+    }
+}
+
+// Per-thread body that allocates the thread's own accumulator (alloc modes)
+void alloc_slot_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    (void) num_threads;
+    thread_alloc_slot(ctx->allocs, tid);
+}
+
+// Per-thread body of the alloc modes: accumulate a static chunk into the thread's own allocation
+void sum_alloc_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    backend_static_range(ctx->size, num_threads, tid, &start, &end);
+
+    unsigned long *slot = ctx->allocs->slots[tid];
+    for (unsigned long i = start; i < end; i++) {
+        *slot += ctx->array[i];
+    }
+}
+
+// Per-thread body of bad-ma-tlb: one element per page over the page span, private sum
+void sum_tlb_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long line_elems = CACHE_LINE_SIZE / sizeof(unsigned long);
+    unsigned long lines_per_page = PAGE_SIZE_BYTES / CACHE_LINE_SIZE;
+    unsigned long start, end;
+    backend_static_range(ctx->size, num_threads, tid, &start, &end);
+
+    unsigned long sum = 0;
+    for (unsigned long i = start; i < end; i++) {
+        unsigned long page = i % ctx->pages;
+        sum += ctx->array[page * ctx->page_elems + (page % lines_per_page) * line_elems];
+    }
+    ctx->thread_sums[tid].sum = sum;
+}
+
 int main(int argc, char *argv[]) {
     // Ensure correct number of arguments
     if (argc < 4) {
-        fprintf(stderr, "Usage: %s <mode> <size> <threads>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <mode> <size> <threads> [options]\n", argv[0]);
         fprintf(stderr, "Modes:\n");
         fprintf(stderr, "  good    : no false sharing, no bad memory access\n");
         fprintf(stderr, "  bad-fs  : with false sharing\n");
         fprintf(stderr, "  bad-ma  : with inefficient memory access\n");
+        fprintf(stderr, "  bad-ma-tlb : one element per 4 KiB page over a page span (TLB pressure)\n");
+        fprintf(stderr, "  bad-fs-alloc : each thread accumulates into its own malloc'd word (allocator packs them)\n");
+        fprintf(stderr, "  good-alloc   : each thread accumulates into its own line-aligned posix_memalign'd line\n");
+        fprintf(stderr, "Options (bad-ma-tlb):\n");
+        fprintf(stderr, "  --pages=N          page span walked (default: every page of the array)\n");
+        fprintf(stderr, "  --hugepages=on|off back the array with transparent huge pages (default off)\n");
+        fprintf(stderr, "Options (input):\n");
+        fprintf(stderr, "  --input=path       map the array from a file (created on first use)\n");
+        fprintf(stderr, "  --madvise=normal|sequential|random|willneed\n");
+        fprintf(stderr, "  --drop-cache       evict the file from the page cache before the run\n");
+        fprintf(stderr, "Options (threading):\n");
+        fprintf(stderr, "  --backend=openmp|pthread|pool  runtime that runs the parallel region (default openmp)\n");
+        fprintf(stderr, "Options (cache):\n");
+        fprintf(stderr, "  --cache=none|warm|cold-stream|cold-flush|mixed  cache state before the kernel (default none)\n");
+        fprintf(stderr, "  --prefault=none|populate|touch                  fault the array in after allocation (default none)\n");
         return 1;
     }
 
     // Parse command-line arguments
-    char *mode = argv[1];           // Mode: good, bad-fs, bad-ma
+    char *mode = argv[1];           // Mode: good, bad-fs, bad-ma, bad-ma-tlb, bad-fs-alloc, good-alloc
     unsigned long size = atol(argv[2]); // Array size
     int threads = atoi(argv[3]);    // Number of threads
 
     // Validate mode
-    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "bad-ma") != 0) {
+    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "bad-ma") != 0 && strcmp(mode, "bad-ma-tlb") != 0 &&
+        strcmp(mode, "bad-fs-alloc") != 0 && strcmp(mode, "good-alloc") != 0) {
         fprintf(stderr, "Invalid mode: %s\n", mode);
         fprintf(stderr, "Modes:\n");
         fprintf(stderr, "  good    : no false sharing, no bad memory access\n");
         fprintf(stderr, "  bad-fs  : with false sharing\n");
         fprintf(stderr, "  bad-ma  : with inefficient memory access\n");
+        fprintf(stderr, "  bad-ma-tlb : one element per 4 KiB page over a page span (TLB pressure)\n");
+        fprintf(stderr, "  bad-fs-alloc : each thread accumulates into its own malloc'd word (allocator packs them)\n");
+        fprintf(stderr, "  good-alloc   : each thread accumulates into its own line-aligned posix_memalign'd line\n");
         return 1;
     }
+    int alloc_mode = strcmp(mode, "bad-fs-alloc") == 0 || strcmp(mode, "good-alloc") == 0;
+
+    // The alloc modes share one malloc arena; this must happen before any thread allocates
+    if (alloc_mode) {
+        thread_alloc_single_arena();
+    }
 
-    // Allocate memory for the array
-    unsigned long *array = (unsigned long*) malloc(size * sizeof(unsigned long));
-    if (!array) {
-        fprintf(stderr, "Memory allocation failed for size %lu\n", size);
+    // Parse optional arguments
+    unsigned long page_elems = PAGE_SIZE_BYTES / sizeof(unsigned long);
+    unsigned long array_pages = size / page_elems;
+    unsigned long pages = array_pages;
+    int hugepages = 0;
+    ThreadBackend backend = BACKEND_OPENMP;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    MmapInput input;
+    mmap_input_init(&input);
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--pages=", 8) == 0) {
+            pages = atol(argv[i] + 8);
+        } else if (strcmp(argv[i], "--hugepages=on") == 0) {
+            hugepages = 1;
+        } else if (strcmp(argv[i], "--hugepages=off") == 0) {
+            hugepages = 0;
+        } else {
+            int parsed = mmap_input_parse_option(argv[i], &input);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            }
+            if (parsed <= 0) {
+                return 1;
+            }
+        }
+    }
+    if (mmap_input_check(&input) != 0) {
+        return 1;
+    }
+    if (input.path && hugepages) {
+        fprintf(stderr, "Error: --hugepages=on applies to anonymous memory only, not to --input files.\n");
+        return 1;
+    }
+    if (threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return 1;
+    }
+    if (strcmp(mode, "bad-ma-tlb") == 0 && (pages == 0 || pages > array_pages)) {
+        fprintf(stderr, "Invalid page span: %lu (the array holds %lu full pages)\n", pages, array_pages);
         return 1;
     }
 
-    // Load the array
-    load_array(array, size);
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    // Allocate memory for the array (huge-page aligned so madvise covers whole huge pages),
+    // or map it from the input file
+    unsigned long *array = NULL;
+    if (input.path) {
+        int needs_fill = 0;
+        array = (unsigned long *) mmap_input_open(&input, "vec_14", "u64 array[i] = i + 1", size, sizeof(unsigned long),
+                                                  &needs_fill);
+        if (needs_fill) load_array(array, size);
+        array = (unsigned long *) mmap_input_ready(&input);
+        prefault_range(prefault, array, size, sizeof(unsigned long), 0, threads, PARTITION_LINE, backend);
+    } else {
+        if (posix_memalign((void **) &array, HUGE_PAGE_SIZE_BYTES, size * sizeof(unsigned long)) != 0) {
+            fprintf(stderr, "Memory allocation failed for size %lu\n", size);
+            return 1;
+        }
+        if (strcmp(mode, "bad-ma-tlb") == 0) {
+            // Must precede the first touch in load_array to take effect
+            madvise(array, size * sizeof(unsigned long), hugepages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+        }
+        prefault_range(prefault, array, size, sizeof(unsigned long), 1, threads, PARTITION_LINE, backend);
+
+        // Load the array
+        load_array(array, size);
+    }
 
     // Set the number of OpenMP threads
     omp_set_num_threads(threads);
 
+    PaddedSum *thread_sums = (PaddedSum *) malloc(threads * sizeof(PaddedSum));
+    if (!thread_sums) {
+        fprintf(stderr, "Memory allocation failed for per-thread sums\n");
+        return 1;
+    }
+    for (int i = 0; i < threads; i++) {
+        thread_sums[i].sum = 0;
+    }
+    ThreadAllocs allocs;
+    SumContext ctx = { .array = array, .size = size, .pages = pages, .page_elems = page_elems, .thread_sums = thread_sums,
+                       .allocs = &allocs };
+
+    printf("Backend: %s\n", backend_name(backend));
+
+    // Put the array in the requested cache state (the serial load_array leaves only its tail cached)
+    CacheRegion array_region = { array, size, sizeof(unsigned long), 0 };
+    cache_state_prepare(cache, &array_region, 1, threads, PARTITION_LINE, backend);
+    cache_state_report(cache);
+    prefault_report(prefault);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+    if (input.path) {
+        mmap_input_begin(&input);
+    }
+
+    // The alloc modes allocate their accumulators in a parallel region of their own, before the timer
+    int aligned = strcmp(mode, "good-alloc") == 0;
+    if (alloc_mode) {
+        thread_allocs_init(&allocs, threads, aligned);
+        backend_run(backend, threads, alloc_slot_body, &ctx);
+    }
+
     unsigned long sum = 0;
     double start_time = omp_get_wtime();
 
@@ -56,10 +266,7 @@ int main(int argc, char *argv[]) {
     if (strcmp(mode, "good") == 0) {
         // Good mode: Linear access pattern, no false sharing or bad memory access
         printf("Mode: good (no false sharing, no bad memory access)\n");
-        #pragma omp parallel for reduction(+:sum)
-        for (unsigned long i = 0; i < size; i++) {
-            sum += array[i];
-        }
+        backend_run(backend, threads, sum_linear_body, &ctx);
     } else if (strcmp(mode, "bad-fs") == 0) {
         // Bad-fs mode: Simulate false sharing
         printf("Mode: bad-fs (with false sharing)\n");
@@ -69,14 +276,8 @@ int main(int argc, char *argv[]) {
             partial_sums[i] = 0;
         }
 
-        #pragma omp parallel shared(partial_sums)
-        {
-            int tid = omp_get_thread_num();
-            #pragma omp for
-            for (unsigned long i = 0; i < size; i++) {
-                partial_sums[tid] += array[i];
-            }
-        }
+        ctx.partial_sums = partial_sums;
+        backend_run(backend, threads, sum_bad_fs_body, &ctx);
 
         // Combine partial sums
         for (int i = 0; i < num_threads; i++) {
@@ -87,23 +288,54 @@ int main(int argc, char *argv[]) {
     } else if (strcmp(mode, "bad-ma") == 0) {
         // Bad-ma mode: Simulate inefficient memory access with stride
         printf("Mode: bad-ma (with inefficient memory access)\n");
-        int stride = 64;
-        #pragma omp parallel for reduction(+:sum)
-        for (unsigned long i = 0; i < size; i++) {
-            sum += array[i]; 
-        }
+        backend_run(backend, threads, sum_linear_body, &ctx);
+    } else if (strcmp(mode, "bad-ma-tlb") == 0) {
+        // Bad-ma-tlb mode: 'size' loads, one element per 4 KiB page, cycling over 'pages' pages.
+        // The line within each page rotates with the page number, so 'pages' distinct lines
+        // (64 bytes per page, spread over all cache sets) are touched. Up to a few thousand pages
+        // those fit in L1/L2 and the misses come from the TLB; larger spans also miss in the
+        // caches (131072 pages touch 8 MiB of lines), so compare against --hugepages=on at the
+        // same span, which touches the same lines with far fewer TLB entries.
+        printf("Mode: bad-ma-tlb (%lu pages, %s)\n", pages, hugepages ? "huge pages" : "4 KiB pages");
+        backend_run(backend, threads, sum_tlb_body, &ctx);
+    } else if (alloc_mode) {
+        // Alloc modes: every thread has allocated its accumulator inside a parallel region, with malloc
+        // (bad-fs-alloc: small chunks packed on shared lines) or a line-aligned posix_memalign
+        // (good-alloc: one line per thread), and accumulates its chunk there
+        printf("Mode: %s (%s)\n", mode, aligned ? "line-aligned per-thread allocation" : "per-thread malloc, false sharing");
+        backend_run(backend, threads, sum_alloc_body, &ctx);
+        sum += thread_allocs_sum(&allocs);
+    }
+
+    // Combine the per-thread results of the reduction modes (all zero for bad-fs and the alloc modes)
+    for (int i = 0; i < threads; i++) {
+        sum += thread_sums[i].sum;
     }
 
     double end_time = omp_get_wtime();
+    fault_phase_report(&faults, "kernel");
 
     // Print out the results
     printf("Size: %lu\n", size);
     printf("Threads: %d\n", threads);
     printf("Sum: %lu\n", sum);
     printf("Execution Time: %f seconds\n", (end_time - start_time));
+    int placement = 0;
+    if (alloc_mode) {
+        placement = thread_allocs_report(&allocs);
+        thread_allocs_free(&allocs);
+    }
+    if (input.path) {
+        mmap_input_report(&input);
+    }
 
     // Free allocated memory
-    free(array);
+    if (input.path) {
+        mmap_input_close(&input);
+    } else {
+        free(array);
+    }
+    free(thread_sums);
 
-    return 0;
+    return placement != 0;
 }
@@ -3,6 +3,13 @@
 #include <string.h>
 #include <omp.h>
 #include <time.h>
+#include "partition.h"
+#include "mmap_input.h"
+#include "thread_backend.h"
+#include "mem_order.h"
+#include "thread_alloc.h"
+#include "cache_state.h"
+#include "prefault.h"
 
 // Define cache line size for padding (typically 64 bytes)
 #define CACHE_LINE_SIZE 64
@@ -13,14 +20,39 @@ typedef struct {
     char padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
 } PaddedSum;
 
-// Function to initialize the array with sequential values
-void load_array(unsigned long *array, unsigned long size) {
-    #pragma omp parallel for schedule(static)
-    for (unsigned long i = 0; i < size; i++) {
-        array[i] = i + 1;
+// Shared state of a sum kernel, handed to the per-thread body on every backend
+typedef struct {
+    unsigned long *array;
+    unsigned long size;
+    PartitionPolicy policy;
+    unsigned long stride;
+    PaddedSum *padded_sums;
+    unsigned long *packed_sums;
+    MemOrder order;
+    ThreadAllocs *allocs;
+} SumContext;
+
+// Per-thread body of load_array: sequential values over the thread's static chunk (with the numa
+// policy, the range it will later sum, so each thread first-touches its own pages)
+void load_array_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    if (ctx->policy == PARTITION_NUMA) {
+        partition_range(ctx->array, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+    } else {
+        backend_static_range(ctx->size, num_threads, tid, &start, &end);
+    }
+    for (unsigned long i = start; i < end; i++) {
+        ctx->array[i] = i + 1;
     }
 }
 
+// Function to initialize the array on the kernel's threading backend
+void load_array(unsigned long *array, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend) {
+    SumContext ctx = { .array = array, .size = size, .policy = policy };
+    backend_run(backend, num_threads, load_array_body, &ctx);
+}
+
 // Function to shuffle an array of indices for random access (if needed in future extensions)
 void shuffle_array(unsigned long *indices, unsigned long size) {
     srand((unsigned)time(NULL));
@@ -32,8 +64,55 @@ void shuffle_array(unsigned long *indices, unsigned long size) {
     }
 }
 
+// Per-thread body of 'good' mode: sum the thread's range into its own padded slot
+void sum_good_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->array, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    unsigned long i;
+    MEM_ORDER_ACCUMULATE(ctx->order, &ctx->padded_sums[tid].sum, i, start, end, 1, ctx->array[i]);
+}
+
+// Per-thread body of 'bad-fs' mode: sum the thread's range into a packed, shared-line slot
+void sum_bad_fs_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->array, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    unsigned long i;
+    MEM_ORDER_ACCUMULATE(ctx->order, &ctx->packed_sums[tid], i, start, end, 1, ctx->array[i]);
+}
+
+// Per-thread body that allocates the thread's own accumulator (alloc modes)
+void alloc_slot_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    (void) num_threads;
+    thread_alloc_slot(ctx->allocs, tid);
+}
+
+// Per-thread body of the alloc modes: sum the thread's range into the accumulator it allocated
+void sum_alloc_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->array, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    unsigned long i;
+    MEM_ORDER_ACCUMULATE(ctx->order, ctx->allocs->slots[tid], i, start, end, 1, ctx->array[i]);
+}
+
+// Per-thread body of 'bad-ma' mode: strided walk over the whole array, cyclic over threads
+void sum_bad_ma_body(int tid, int num_threads, void *arg) {
+    SumContext *ctx = (SumContext *) arg;
+
+    for (unsigned long i = tid; i < ctx->size; i += num_threads) {
+        unsigned long idx = (i * ctx->stride) % ctx->size;
+        ctx->padded_sums[tid].sum += ctx->array[idx];
+    }
+}
+
 // Function to perform the sum operation in 'good' mode (no false sharing, linear access)
-unsigned long sum_good(unsigned long *array, unsigned long size, int num_threads) {
+unsigned long sum_good(unsigned long *array, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend, MemOrder order) {
     unsigned long total_sum = 0;
 
     // Allocate per-thread sums with padding to prevent false sharing
@@ -51,17 +130,8 @@ unsigned long sum_good(unsigned long *array, unsigned long size, int num_threads
     double start_time = omp_get_wtime();
 
     // Perform the sum operation
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        unsigned long chunk_size = size / num_threads;
-        unsigned long start = tid * chunk_size;
-        unsigned long end = (tid == num_threads - 1) ? size : start + chunk_size;
-
-        for (unsigned long i = start; i < end; i++) {
-            partial_sums[tid].sum += array[i];
-        }
-    }
+    SumContext ctx = { .array = array, .size = size, .policy = policy, .padded_sums = partial_sums, .order = order };
+    backend_run(backend, num_threads, sum_good_body, &ctx);
 
     // Aggregate the partial sums
     for (int i = 0; i < num_threads; i++) {
@@ -71,13 +141,14 @@ unsigned long sum_good(unsigned long *array, unsigned long size, int num_threads
     double end_time = omp_get_wtime();
     printf("Good Mode - Total Sum: %lu\n", total_sum);
     printf("Good Mode - Execution Time: %f seconds\n", end_time - start_time);
+    mem_order_report(order, "Good Mode", size, end_time - start_time, total_sum, size * (size + 1) / 2);
 
     free(partial_sums);
     return total_sum;
 }
 
 // Function to perform the sum operation in 'bad-fs' mode (with false sharing, linear access)
-unsigned long sum_bad_fs(unsigned long *array, unsigned long size, int num_threads) {
+unsigned long sum_bad_fs(unsigned long *array, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend, MemOrder order) {
     unsigned long total_sum = 0;
 
     // Allocate per-thread sums without padding to introduce false sharing
@@ -95,17 +166,8 @@ unsigned long sum_bad_fs(unsigned long *array, unsigned long size, int num_threa
     double start_time = omp_get_wtime();
 
     // Perform the sum operation
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        unsigned long chunk_size = size / num_threads;
-        unsigned long start = tid * chunk_size;
-        unsigned long end = (tid == num_threads - 1) ? size : start + chunk_size;
-
-        for (unsigned long i = start; i < end; i++) {
-            partial_sums[tid] += array[i];
-        }
-    }
+    SumContext ctx = { .array = array, .size = size, .policy = policy, .packed_sums = partial_sums, .order = order };
+    backend_run(backend, num_threads, sum_bad_fs_body, &ctx);
 
     // Aggregate the partial sums
     for (int i = 0; i < num_threads; i++) {
@@ -115,13 +177,45 @@ unsigned long sum_bad_fs(unsigned long *array, unsigned long size, int num_threa
     double end_time = omp_get_wtime();
     printf("Bad-FS Mode - Total Sum: %lu\n", total_sum);
     printf("Bad-FS Mode - Execution Time: %f seconds\n", end_time - start_time);
+    mem_order_report(order, "Bad-FS Mode", size, end_time - start_time, total_sum, size * (size + 1) / 2);
 
     free(partial_sums);
     return total_sum;
 }
 
+// Function to perform the sum operation in the alloc modes: every thread allocates its own
+// accumulator inside a parallel region, with malloc ('bad-fs-alloc', small chunks packed on shared
+// lines) or with a line-aligned posix_memalign ('good-alloc', one line per thread)
+unsigned long sum_alloc(unsigned long *array, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend, MemOrder order, int aligned) {
+    const char *label = aligned ? "Good-Alloc Mode" : "Bad-FS-Alloc Mode";
+    ThreadAllocs allocs;
+    thread_allocs_init(&allocs, num_threads, aligned);
+
+    // Each thread allocates its accumulator from its own thread
+    SumContext ctx = { .array = array, .size = size, .policy = policy, .order = order, .allocs = &allocs };
+    backend_run(backend, num_threads, alloc_slot_body, &ctx);
+
+    double start_time = omp_get_wtime();
+
+    // Perform the sum operation
+    backend_run(backend, num_threads, sum_alloc_body, &ctx);
+
+    // Aggregate the partial sums
+    unsigned long total_sum = thread_allocs_sum(&allocs);
+
+    double end_time = omp_get_wtime();
+    printf("%s - Total Sum: %lu\n", label, total_sum);
+    printf("%s - Execution Time: %f seconds\n", label, end_time - start_time);
+    mem_order_report(order, label, size, end_time - start_time, total_sum, size * (size + 1) / 2);
+    int placement = thread_allocs_report(&allocs);
+
+    thread_allocs_free(&allocs);
+    if (placement != 0) exit(EXIT_FAILURE);
+    return total_sum;
+}
+
 // Function to perform the sum operation in 'bad-ma' mode (inefficient memory access, strided access)
-unsigned long sum_bad_ma(unsigned long *array, unsigned long size, int num_threads, unsigned long stride){
+unsigned long sum_bad_ma(unsigned long *array, unsigned long size, int num_threads, unsigned long stride, ThreadBackend backend){
     unsigned long total_sum = 0;
 
     // Ensure stride is co-prime with size to cover all elements
@@ -149,15 +243,9 @@ unsigned long sum_bad_ma(unsigned long *array, unsigned long size, int num_threa
     double start_time = omp_get_wtime();
 
     // Perform the sum operation with strided access
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-
-        for(unsigned long i = tid; i < size; i += num_threads){
-            unsigned long idx = (i * stride) % size;
-            partial_sums[tid].sum += array[idx];
-        }
-    }
+    SumContext ctx = { .array = array, .size = size, .policy = PARTITION_NAIVE, .stride = stride, .padded_sums = partial_sums,
+                       .order = MEM_ORDER_PLAIN };
+    backend_run(backend, num_threads, sum_bad_ma_body, &ctx);
 
     // Aggregate the partial sums
     for(int i=0;i<num_threads;i++) total_sum += partial_sums[i].sum;
@@ -171,8 +259,8 @@ unsigned long sum_bad_ma(unsigned long *array, unsigned long size, int num_threa
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
-        fprintf(stderr, "Usage: %s [good|bad-fs|bad-ma] [size] [threads]\n", argv[0]);
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s [good|bad-fs|bad-ma|bad-fs-alloc|good-alloc] [size] [threads] [--partition=naive|line|page|numa] [--backend=openmp|pthread|pool] [--order=plain|store|relaxed|seq_cst|cas] [--input=path [--madvise=normal|sequential|random|willneed] [--drop-cache]] [--cache=none|warm|cold-stream|cold-flush|mixed] [--prefault=none|populate|touch]\n", argv[0]);
         return EXIT_FAILURE;
     }
 
@@ -182,9 +270,47 @@ int main(int argc, char *argv[]) {
     int num_threads = atoi(argv[3]);
 
     // Validate mode
-    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "bad-ma") != 0) {
+    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "bad-ma") != 0 &&
+        strcmp(mode, "bad-fs-alloc") != 0 && strcmp(mode, "good-alloc") != 0) {
         fprintf(stderr, "Invalid mode: %s\n", mode);
-        fprintf(stderr, "Valid modes are: good, bad-fs, bad-ma\n");
+        fprintf(stderr, "Valid modes are: good, bad-fs, bad-ma, bad-fs-alloc, good-alloc\n");
+        return EXIT_FAILURE;
+    }
+    int alloc_mode = strcmp(mode, "bad-fs-alloc") == 0 || strcmp(mode, "good-alloc") == 0;
+
+    // The alloc modes share one malloc arena; this must happen before any thread allocates
+    if (alloc_mode) {
+        thread_alloc_single_arena();
+    }
+
+    // Parse optional arguments
+    PartitionPolicy policy = PARTITION_LINE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    MemOrder order = MEM_ORDER_PLAIN;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    MmapInput input;
+    mmap_input_init(&input);
+    for (int i = 4; i < argc; i++) {
+        int parsed = partition_parse_option(argv[i], &policy);
+        if (parsed == 0) parsed = mmap_input_parse_option(argv[i], &input);
+        if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+        if (parsed == 0) parsed = mem_order_parse_option(argv[i], &order);
+        if (parsed == 0) parsed = cache_state_parse_option(argv[i], &cache);
+        if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+        if (parsed == 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        if (parsed < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (mmap_input_check(&input) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (order != MEM_ORDER_PLAIN && strcmp(mode, "bad-ma") == 0) {
+        fprintf(stderr, "Error: --order does not apply to the bad-ma mode.\n");
         return EXIT_FAILURE;
     }
 
@@ -201,30 +327,70 @@ int main(int argc, char *argv[]) {
     // Set the number of threads for OpenMP
     omp_set_num_threads(num_threads);
 
-    // Allocate memory for the array
-    unsigned long *array = (unsigned long *) malloc(size * sizeof(unsigned long));
-    if (!array) {
-        fprintf(stderr, "Memory allocation failed for the array.\n");
-        return EXIT_FAILURE;
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    // Allocate memory for the array, or map it from the input file
+    unsigned long *array = NULL;
+    if (input.path) {
+        int needs_fill = 0;
+        array = (unsigned long *) mmap_input_open(&input, "sc_28", "u64 array[i] = i + 1", size, sizeof(unsigned long),
+                                                  &needs_fill);
+        if (needs_fill) load_array(array, size, num_threads, policy, backend);
+        array = (unsigned long *) mmap_input_ready(&input);
+        prefault_range(prefault, array, size, sizeof(unsigned long), 0, num_threads, policy, backend);
+    } else {
+        array = (unsigned long *) malloc(size * sizeof(unsigned long));
+        if (!array) {
+            fprintf(stderr, "Memory allocation failed for the array.\n");
+            return EXIT_FAILURE;
+        }
+        prefault_range(prefault, array, size, sizeof(unsigned long), 1, num_threads, policy, backend);
+
+        // Initialize the array
+        load_array(array, size, num_threads, policy, backend);
     }
 
-    // Initialize the array
-    load_array(array, size);
+    printf("Partition: %s\n", partition_policy_name(policy));
+    printf("Backend: %s\n", backend_name(backend));
+
+    // Put the array in the requested cache state, in the kernel's own partition
+    CacheRegion array_region = { array, size, sizeof(unsigned long), 0 };
+    cache_state_prepare(cache, &array_region, 1, num_threads, policy, backend);
+    cache_state_report(cache);
+    prefault_report(prefault);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+    if (input.path) {
+        mmap_input_begin(&input);
+    }
 
     // Perform the sum operation based on the mode
     if (strcmp(mode, "good") == 0) {
-        sum_good(array, size, num_threads);
+        sum_good(array, size, num_threads, policy, backend, order);
     }
     else if (strcmp(mode, "bad-fs") == 0) {
-        sum_bad_fs(array, size, num_threads);
+        sum_bad_fs(array, size, num_threads, policy, backend, order);
     }
     else if (strcmp(mode, "bad-ma") == 0) {
         unsigned long stride = 7;
-        sum_bad_ma(array, size, num_threads, stride);
+        sum_bad_ma(array, size, num_threads, stride, backend);
+    }
+    else if (alloc_mode) {
+        sum_alloc(array, size, num_threads, policy, backend, order, strcmp(mode, "good-alloc") == 0);
+    }
+    fault_phase_report(&faults, "kernel");
+
+    if (input.path) {
+        mmap_input_report(&input);
     }
 
     // Free allocated memory
-    free(array);
+    if (input.path) {
+        mmap_input_close(&input);
+    } else {
+        free(array);
+    }
 
     return EXIT_SUCCESS;
 }
@@ -3,6 +3,9 @@
 #include <omp.h>
 #include <time.h>
 #include <string.h>
+#include "mmap_input.h"
+#include "cache_state.h"
+#include "prefault.h"
 
 // This program demonstrates:
 // - Reading data element-wise from an array
@@ -81,7 +84,7 @@ void modify_and_sum(unsigned long *array, unsigned long size) {
 
 int main(int argc, char *argv[]) {
     if (argc < 3) {
-        printf("Usage: %s [good|bad] [size]\n", argv[0]);
+        printf("Usage: %s [good|bad] [size] [threads] [--input=path [--madvise=normal|sequential|random|willneed] [--drop-cache]] [--cache=none|warm|cold-stream|cold-flush|mixed] [--prefault=none|populate|touch]\n", argv[0]);
         return 1;
     }
 
@@ -93,14 +96,64 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // Allocate memory for the array
-    unsigned long *array = (unsigned long *)malloc(size * sizeof(unsigned long));
-    if (!array) {
-        fprintf(stderr, "Memory allocation failed for the array.\n");
+    // Parse optional arguments
+    MmapInput input;
+    mmap_input_init(&input);
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    // A thread count after the size (as perf_data.sh passes to every program) is accepted and
+    // ignored: this program is single-threaded
+    int first_option = 3;
+    if (argc > 3 && strncmp(argv[3], "--", 2) != 0) {
+        char *end;
+        long threads = strtol(argv[3], &end, 10);
+        if (*end != '\0' || threads <= 0) {
+            fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+            return 1;
+        }
+        if (threads > 1) {
+            fprintf(stderr, "Note: this program is single-threaded; ignoring %ld threads.\n", threads);
+        }
+        first_option = 4;
+    }
+    for (int i = first_option; i < argc; i++) {
+        int parsed = mmap_input_parse_option(argv[i], &input);
+        if (parsed == 0) parsed = cache_state_parse_option(argv[i], &cache);
+        if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+        if (parsed == 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+        }
+        if (parsed <= 0) {
+            return 1;
+        }
+    }
+    if (mmap_input_check(&input) != 0) {
         return 1;
     }
 
-    load_array(array, size);
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    // Allocate memory for the array, or map it from the input file
+    // (the mapping is private, so modify_and_sum never writes back to the file)
+    unsigned long *array = NULL;
+    if (input.path) {
+        int needs_fill = 0;
+        array = (unsigned long *) mmap_input_open(&input, "seq_10", "u64 array[i] = i + 1", size, sizeof(unsigned long),
+                                                  &needs_fill);
+        if (needs_fill) load_array(array, size);
+        array = (unsigned long *) mmap_input_ready(&input);
+        prefault_range(prefault, array, size, sizeof(unsigned long), strcmp(mode, "good") == 0, 1, PARTITION_LINE, BACKEND_OPENMP);
+    } else {
+        array = (unsigned long *)malloc(size * sizeof(unsigned long));
+        if (!array) {
+            fprintf(stderr, "Memory allocation failed for the array.\n");
+            return 1;
+        }
+        prefault_range(prefault, array, size, sizeof(unsigned long), 1, 1, PARTITION_LINE, BACKEND_OPENMP);
+
+        load_array(array, size);
+    }
 
     // Prepare indices for random access (only needed if mode == bad)
     unsigned long *indices = NULL;
@@ -108,32 +161,54 @@ int main(int argc, char *argv[]) {
         indices = (unsigned long*)malloc(size * sizeof(unsigned long));
         if (!indices) {
             fprintf(stderr, "Memory allocation failed for indices.\n");
-            free(array);
+            if (input.path) mmap_input_close(&input); else free(array);
             return 1;
         }
+        prefault_range(prefault, indices, size, sizeof(unsigned long), 1, 1, PARTITION_LINE, BACKEND_OPENMP);
         for (unsigned long i = 0; i < size; i++) {
             indices[i] = i;
         }
         shuffle_array(indices, size);
     }
 
+    // Each timed phase starts from the requested cache state (single-threaded)
+    CacheRegion array_region = { array, size, sizeof(unsigned long), 0 };
+    CacheRegion random_regions[] = { { array, size, sizeof(unsigned long), 0 },
+                                     { indices, size, sizeof(unsigned long), 0 } };
+    prefault_report(prefault);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+    if (input.path) {
+        mmap_input_begin(&input);
+    }
     if (strcmp(mode, "good") == 0) {
         // Good memory access: linear and modify
+        cache_state_prepare(cache, &array_region, 1, 1, PARTITION_LINE, BACKEND_OPENMP);
         sum_linear(array, size);
+        array_region.written = 1;
+        cache_state_prepare(cache, &array_region, 1, 1, PARTITION_LINE, BACKEND_OPENMP);
         modify_and_sum(array, size);
     } else if (strcmp(mode, "bad") == 0) {
         // Bad memory access: random and strided
+        cache_state_prepare(cache, random_regions, 2, 1, PARTITION_LINE, BACKEND_OPENMP);
         sum_random(array, indices, size);
+        cache_state_prepare(cache, &array_region, 1, 1, PARTITION_LINE, BACKEND_OPENMP);
         sum_strided(array, size, 5);
     } else {
         printf("Invalid mode: %s\n", mode);
-        printf("Usage: %s [good|bad] [size]\n", argv[0]);
-        free(array);
+        printf("Usage: %s [good|bad] [size] [threads] [options]\n", argv[0]);
+        if (input.path) mmap_input_close(&input); else free(array);
         if (indices) free(indices);
         return 1;
     }
+    fault_phase_report(&faults, "kernel");
+
+    cache_state_report(cache);
+    if (input.path) {
+        mmap_input_report(&input);
+    }
 
-    free(array);
+    if (input.path) mmap_input_close(&input); else free(array);
     if (indices) free(indices);
 
     return 0;
@@ -7,7 +7,20 @@ files=(
   "array_sum_performance_variation_10.c seq_10"
   "matrix_compare_memory_modes_31.c mc_31"
   "matrix_init_access_modes_23.c vec_23"
+  "matrix_transpose_modes_61.c tr_61"
   "matrix_init_access_variation_29.c sc_29"
+  "lock_striping_contention_51.c lk_51"
+  "stats_counter_sharding_52.c ct_52"
+  "sparse_matvec_csr_53.c sp_53"
+  "jacobi_stencil_boundary_54.c st_54"
+  "pointer_chase_latency_56.c pc_56"
+  "concurrent_hash_map_58.c hm_58"
+  "reduction_strategies_59.c rd_59"
+  "dense_matmul_variants_60.c mm_60"
+  "read_write_sharing_67.c rw_67"
+  "hot_cold_fields_68.c hc_68"
+  "multiprocess_sharing_70.c mp_70"
+  "core_latency_72.c cl_72"
 )
 
 # Loop through each file and compile
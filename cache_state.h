@@ -0,0 +1,261 @@
+#ifndef CACHE_STATE_H
+#define CACHE_STATE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "partition.h"
+#include "thread_backend.h"
+
+// Explicit cache state before the timed kernel.
+//
+// Whether a kernel starts with its data in cache otherwise depends on what ran before it: a
+// parallel initialisation leaves each thread's chunk in that core's caches, a serial one leaves
+// the tail of the array in one core's caches, and a small array may stay resident from either.
+// --cache sets the state right before the kernel:
+//   none        - leave the caches as initialisation left them (the original behaviour)
+//   warm        - each thread re-touches its own partition of the kernel's data (one access per
+//                 line, a write for data the kernel writes), so the data starts cache-resident
+//                 wherever it fits and every page is faulted in
+//   cold-stream - touch as for warm, then evict by streaming a buffer of twice the LLC size
+//   cold-flush  - touch as for warm, then clflush every line of the kernel's data (x86; other
+//                 targets fall back to cold-stream)
+//   mixed       - cold-stream, then re-touch the first half of each thread's partition
+// The touch and eviction passes run on the kernel's threading backend with the kernel's partition
+// of each region, before the timer starts, so no other runtime's threads are left behind and the
+// pool backend warms the caches of the threads that run the kernel. Kernels whose threads each own
+// a private allocation use cache_state_prepare_private(), where every region belongs to one thread.
+
+// Define cache line size used for the touch and flush strides
+#define CACHE_STATE_LINE_SIZE 64
+// LLC size assumed when neither sysconf nor sysfs reports one
+#define CACHE_STATE_DEFAULT_LLC (32UL * 1024 * 1024)
+
+typedef enum {
+    CACHE_NONE,
+    CACHE_WARM,
+    CACHE_COLD_STREAM,
+    CACHE_COLD_FLUSH,
+    CACHE_MIXED
+} CacheState;
+
+// One array the kernel reads (or writes, when 'written' is set)
+typedef struct {
+    void *base;
+    unsigned long count;
+    size_t elem_size;
+    int written;
+} CacheRegion;
+
+static inline const char *cache_state_name(CacheState state) {
+    switch (state) {
+    case CACHE_NONE: return "none";
+    case CACHE_WARM: return "warm";
+    case CACHE_COLD_STREAM: return "cold-stream";
+    case CACHE_COLD_FLUSH: return "cold-flush";
+    case CACHE_MIXED: return "mixed";
+    }
+    return "unknown";
+}
+
+// Function to parse a --cache=<state> argument.
+// Returns 1 if the argument was consumed, 0 if it is not a cache option, -1 if invalid.
+static inline int cache_state_parse_option(const char *arg, CacheState *state) {
+    if (strncmp(arg, "--cache=", 8) != 0) return 0;
+    const char *value = arg + 8;
+    if (strcmp(value, "none") == 0) *state = CACHE_NONE;
+    else if (strcmp(value, "warm") == 0) *state = CACHE_WARM;
+    else if (strcmp(value, "cold-stream") == 0) *state = CACHE_COLD_STREAM;
+    else if (strcmp(value, "cold-flush") == 0) *state = CACHE_COLD_FLUSH;
+    else if (strcmp(value, "mixed") == 0) *state = CACHE_MIXED;
+    else {
+        fprintf(stderr, "Invalid cache state: %s (expected none, warm, cold-stream, cold-flush or mixed)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+// Function to read the last-level cache size: sysconf, then sysfs, then the default
+static inline unsigned long cache_state_llc_bytes(void) {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (bytes > 0) return (unsigned long) bytes;
+#endif
+    FILE *f = fopen("/sys/devices/system/cpu/cpu0/cache/index3/size", "r");
+    if (f) {
+        unsigned long value = 0;
+        char unit = 0;
+        int fields = fscanf(f, "%lu%c", &value, &unit);
+        fclose(f);
+        if (fields >= 1 && value > 0) {
+            if (unit == 'K') value *= 1024;
+            else if (unit == 'M') value *= 1024 * 1024;
+            return value;
+        }
+    }
+    return CACHE_STATE_DEFAULT_LLC;
+}
+
+// Size of the eviction buffer streamed by cold-stream and mixed
+static inline unsigned long cache_state_evict_bytes(void) {
+    return 2 * cache_state_llc_bytes();
+}
+
+// Function to access one byte in every line of [begin, end), each within the range, so that
+// neighbouring partitions never write the same byte
+static inline void cache_state_touch(unsigned char *begin, unsigned char *end, int written) {
+    for (unsigned char *p = begin; p < end;
+         p = (unsigned char *) (((uintptr_t) p & ~(uintptr_t) (CACHE_STATE_LINE_SIZE - 1)) + CACHE_STATE_LINE_SIZE)) {
+        volatile unsigned char *q = p;
+        if (written) {
+            *q = *q;
+        } else {
+            (void) *q;
+        }
+    }
+}
+
+// Function to flush every line of [begin, end) from all cache levels
+static inline void cache_state_flush(unsigned char *begin, unsigned char *end) {
+#if defined(__x86_64__) || defined(__i386__)
+    for (unsigned char *p = begin; p < end;
+         p = (unsigned char *) (((uintptr_t) p & ~(uintptr_t) (CACHE_STATE_LINE_SIZE - 1)) + CACHE_STATE_LINE_SIZE)) {
+        _mm_clflush(p);
+    }
+    _mm_mfence();
+#else
+    (void) begin;
+    (void) end;
+#endif
+}
+
+static inline int cache_state_has_clflush(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Byte range of thread 'tid's partition of a region
+static inline void cache_state_part(const CacheRegion *region, PartitionPolicy policy, int num_threads, int tid,
+                                    unsigned char **begin, unsigned char **end) {
+    unsigned long start, stop;
+    partition_range(region->base, region->count, region->elem_size, policy, num_threads, tid, &start, &stop);
+    *begin = (unsigned char *) region->base + start * region->elem_size;
+    *end = (unsigned char *) region->base + stop * region->elem_size;
+}
+
+// Passes of cache_state_prepare(), each a parallel region of its own (the join separates them)
+typedef enum {
+    CACHE_PASS_TOUCH,        // touch the own partition of every region
+    CACHE_PASS_EVICT,        // stream the own part of the eviction buffer
+    CACHE_PASS_FLUSH,        // clflush the own partition of every region
+    CACHE_PASS_TOUCH_HALF    // touch the first half of the own partition of every region
+} CachePass;
+
+typedef struct {
+    const CacheRegion *regions;
+    int num_regions;
+    PartitionPolicy policy;
+    CacheRegion evict_region;
+    CachePass pass;
+    int private_regions;     // region r belongs whole to thread r % num_threads
+} CachePassContext;
+
+// Per-thread body of one pass
+static void cache_pass_body(int tid, int num_threads, void *arg) {
+    CachePassContext *ctx = (CachePassContext *) arg;
+    unsigned char *begin, *end;
+
+    if (ctx->pass == CACHE_PASS_EVICT) {
+        cache_state_part(&ctx->evict_region, PARTITION_LINE, num_threads, tid, &begin, &end);
+        cache_state_touch(begin, end, 1);
+        return;
+    }
+    for (int r = 0; r < ctx->num_regions; r++) {
+        if (ctx->private_regions) {
+            if (r % num_threads != tid) continue;
+            begin = (unsigned char *) ctx->regions[r].base;
+            end = begin + ctx->regions[r].count * ctx->regions[r].elem_size;
+        } else {
+            cache_state_part(&ctx->regions[r], ctx->policy, num_threads, tid, &begin, &end);
+        }
+        if (ctx->pass == CACHE_PASS_TOUCH) {
+            cache_state_touch(begin, end, ctx->regions[r].written);
+        } else if (ctx->pass == CACHE_PASS_FLUSH) {
+            cache_state_flush(begin, end);
+        } else {
+            cache_state_touch(begin, begin + (end - begin) / 2, ctx->regions[r].written);
+        }
+    }
+}
+
+// Function to run the passes of 'state' over the regions, split by 'policy' or, with
+// 'private_regions', each region whole on its own thread
+static inline void cache_state_run(CacheState state, const CacheRegion *regions, int num_regions, int num_threads,
+                                   PartitionPolicy policy, ThreadBackend backend, int private_regions) {
+    if (state == CACHE_NONE) return;
+
+    int stream = state == CACHE_COLD_STREAM || state == CACHE_MIXED ||
+                 (state == CACHE_COLD_FLUSH && !cache_state_has_clflush());
+    unsigned long evict_bytes = stream ? cache_state_evict_bytes() : 0;
+    unsigned char *evict = NULL;
+    if (stream) {
+        evict = (unsigned char *) malloc(evict_bytes);
+        if (!evict) {
+            fprintf(stderr, "Memory allocation failed for the %lu-byte eviction buffer.\n", evict_bytes);
+            exit(EXIT_FAILURE);
+        }
+    }
+    CachePassContext ctx = { regions, num_regions, policy, { evict, evict_bytes, 1, 1 }, CACHE_PASS_TOUCH,
+                             private_regions };
+
+    // Touch the own partition first: every page is faulted in and the lines are resident
+    backend_run(backend, num_threads, cache_pass_body, &ctx);
+    if (state != CACHE_WARM) {
+        ctx.pass = stream ? CACHE_PASS_EVICT : CACHE_PASS_FLUSH;
+        backend_run(backend, num_threads, cache_pass_body, &ctx);
+    }
+    if (state == CACHE_MIXED) {
+        ctx.pass = CACHE_PASS_TOUCH_HALF;
+        backend_run(backend, num_threads, cache_pass_body, &ctx);
+    }
+
+    free(evict);
+}
+
+// Function to put the regions in the requested state before the kernel. 'policy' is the
+// partition the kernel uses (programs without --partition pass PARTITION_LINE, the balanced
+// split of their static schedule) and 'backend' the threading backend it runs on.
+static inline void cache_state_prepare(CacheState state, const CacheRegion *regions, int num_regions,
+                                       int num_threads, PartitionPolicy policy, ThreadBackend backend) {
+    cache_state_run(state, regions, num_regions, num_threads, policy, backend, 0);
+}
+
+// Function to put per-thread private regions in the requested state: region r is touched,
+// flushed and half re-touched whole by thread r % num_threads, the thread that owns it
+static inline void cache_state_prepare_private(CacheState state, const CacheRegion *regions, int num_regions,
+                                               int num_threads, ThreadBackend backend) {
+    cache_state_run(state, regions, num_regions, num_threads, PARTITION_LINE, backend, 1);
+}
+
+// Function to print the cache state the kernel started from (nothing for none)
+static inline void cache_state_report(CacheState state) {
+    if (state == CACHE_NONE) return;
+    if (state == CACHE_COLD_STREAM || state == CACHE_MIXED ||
+        (state == CACHE_COLD_FLUSH && !cache_state_has_clflush())) {
+        printf("Cache State: %s (evicted with a %lu KiB buffer%s)\n", cache_state_name(state),
+               cache_state_evict_bytes() / 1024,
+               state == CACHE_COLD_FLUSH ? ", no clflush on this target" : "");
+    } else {
+        printf("Cache State: %s\n", cache_state_name(state));
+    }
+}
+
+#endif // CACHE_STATE_H
@@ -0,0 +1,557 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - A lock-free concurrent hash map, either open addressing (linear probing) or chained
+// - Bucket layouts: packed (several buckets per cache line), line-aligned (one bucket per line)
+//   and split (compact key metadata probed by lookups, values on their own lines)
+// - Configurable insert/lookup ratio and uniform or Zipf-skewed keys
+// - Reporting ops/s, so insert-heavy packed layouts show false sharing between buckets
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Per-thread ring of precomputed operations (power of two)
+#define OP_RING_SIZE 4096
+
+// Key 0 marks an empty bucket; keys are 1..num_keys
+#define EMPTY_KEY 0UL
+
+typedef enum {
+    TABLE_OPEN,     // open addressing with linear probing
+    TABLE_CHAINED   // bucket heads pointing to linked nodes
+} TableKind;
+
+typedef enum {
+    LAYOUT_PACKED,  // key and value back-to-back, entries back-to-back
+    LAYOUT_ALIGNED, // each entry on its own cache line
+    LAYOUT_SPLIT    // packed key metadata, values in a separate line-aligned array
+} BucketLayout;
+
+typedef enum {
+    SKEW_UNIFORM,
+    SKEW_ZIPF
+} KeySkew;
+
+// Entry i has its metadata at meta + i * meta_stride (key, then next for chained nodes)
+// and its value at vals + i * val_stride. Packed and aligned layouts point vals into meta.
+typedef struct {
+    TableKind kind;
+    BucketLayout layout;
+    unsigned long num_buckets;
+    int shift;                  // hash >> shift selects the bucket
+    unsigned long num_entries;  // buckets (open) or node pool size (chained)
+    char *meta;
+    size_t meta_stride;
+    char *vals;
+    size_t val_stride;
+    char *heads;                // chained only: node index + 1, 0 = empty chain
+    size_t head_stride;
+    _Atomic unsigned long next_node;
+    void *meta_alloc;
+    void *val_alloc;
+} HashMap;
+
+static inline _Atomic unsigned long *key_at(HashMap *map, unsigned long i) {
+    return (_Atomic unsigned long *) (map->meta + i * map->meta_stride);
+}
+
+static inline _Atomic unsigned long *next_at(HashMap *map, unsigned long i) {
+    return (_Atomic unsigned long *) (map->meta + i * map->meta_stride + sizeof(unsigned long));
+}
+
+static inline _Atomic unsigned long *value_at(HashMap *map, unsigned long i) {
+    return (_Atomic unsigned long *) (map->vals + i * map->val_stride);
+}
+
+static inline _Atomic unsigned long *head_at(HashMap *map, unsigned long b) {
+    return (_Atomic unsigned long *) (map->heads + b * map->head_stride);
+}
+
+static inline unsigned long bucket_of(HashMap *map, unsigned long key) {
+    return (key * 0x9E3779B97F4A7C15UL) >> map->shift;
+}
+
+// Function to allocate cache-line-aligned memory, prefaulted as requested and zeroed, exiting on failure
+void *alloc_zeroed(size_t bytes, const char *what, PrefaultMode prefault, int num_threads, ThreadBackend backend) {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, bytes) != 0) {
+        fprintf(stderr, "Memory allocation failed for %s.\n", what);
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, ptr, bytes, 1, 1, num_threads, PARTITION_LINE, backend);
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+// Function to allocate the map: open tables get twice as many buckets as keys, chained
+// tables one bucket per key and a node pool with one spare node per thread. There are at least
+// two buckets, so the hash shift in bucket_of() stays below 64.
+void init_hash_map(HashMap *map, TableKind kind, BucketLayout layout, unsigned long num_keys, int num_threads,
+                   PrefaultMode prefault, ThreadBackend backend) {
+    unsigned long wanted = (kind == TABLE_OPEN) ? 2 * num_keys : num_keys;
+    map->num_buckets = 2;
+    map->shift = 63;
+    while (map->num_buckets < wanted) {
+        map->num_buckets <<= 1;
+        map->shift--;
+    }
+
+    map->kind = kind;
+    map->layout = layout;
+    map->num_entries = (kind == TABLE_OPEN) ? map->num_buckets : num_keys + (unsigned long) num_threads;
+    atomic_init(&map->next_node, 0);
+
+    // Metadata is the key, plus the next link for chained nodes
+    size_t meta_bytes = (kind == TABLE_OPEN ? 1 : 2) * sizeof(unsigned long);
+    switch (layout) {
+    case LAYOUT_PACKED:
+        map->meta_stride = meta_bytes + sizeof(unsigned long);
+        break;
+    case LAYOUT_ALIGNED:
+        map->meta_stride = CACHE_LINE_SIZE;
+        break;
+    case LAYOUT_SPLIT:
+        map->meta_stride = meta_bytes;
+        break;
+    }
+
+    map->meta_alloc = alloc_zeroed(map->num_entries * map->meta_stride, "hash map entries", prefault, num_threads,
+                                   backend);
+    map->meta = (char *) map->meta_alloc;
+    if (layout == LAYOUT_SPLIT) {
+        map->val_stride = CACHE_LINE_SIZE;
+        map->val_alloc = alloc_zeroed(map->num_entries * map->val_stride, "hash map values", prefault, num_threads,
+                                      backend);
+        map->vals = (char *) map->val_alloc;
+    } else {
+        map->val_stride = map->meta_stride;
+        map->val_alloc = NULL;
+        map->vals = map->meta + meta_bytes;
+    }
+
+    map->heads = NULL;
+    map->head_stride = 0;
+    if (kind == TABLE_CHAINED) {
+        map->head_stride = (layout == LAYOUT_ALIGNED) ? CACHE_LINE_SIZE : sizeof(unsigned long);
+        map->heads = (char *) alloc_zeroed(map->num_buckets * map->head_stride, "bucket heads", prefault,
+                                           num_threads, backend);
+    }
+}
+
+// Function to release the map
+void free_hash_map(HashMap *map) {
+    free(map->meta_alloc);
+    free(map->val_alloc);
+    free(map->heads);
+}
+
+// Function to add 'delta' to the value of 'key' in an open-addressing map, inserting it if absent
+void open_upsert(HashMap *map, unsigned long key, unsigned long delta) {
+    unsigned long mask = map->num_buckets - 1;
+    for (unsigned long i = bucket_of(map, key);; i = (i + 1) & mask) {
+        _Atomic unsigned long *slot = key_at(map, i);
+        unsigned long cur = atomic_load_explicit(slot, memory_order_acquire);
+        if (cur == EMPTY_KEY) {
+            if (atomic_compare_exchange_strong_explicit(slot, &cur, key, memory_order_acq_rel, memory_order_acquire)) {
+                cur = key;
+            }
+        }
+        if (cur == key) {
+            atomic_fetch_add_explicit(value_at(map, i), delta, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+// Function to look up 'key' in an open-addressing map (0 if absent)
+unsigned long open_lookup(HashMap *map, unsigned long key) {
+    unsigned long mask = map->num_buckets - 1;
+    for (unsigned long i = bucket_of(map, key);; i = (i + 1) & mask) {
+        unsigned long cur = atomic_load_explicit(key_at(map, i), memory_order_acquire);
+        if (cur == key) return atomic_load_explicit(value_at(map, i), memory_order_relaxed);
+        if (cur == EMPTY_KEY) return 0;
+    }
+}
+
+// Function to find 'key' in the chain starting at node link 'link' (node index + 1, 0 = none)
+unsigned long chain_find(HashMap *map, unsigned long link, unsigned long key) {
+    while (link != 0) {
+        if (atomic_load_explicit(key_at(map, link - 1), memory_order_relaxed) == key) return link;
+        link = atomic_load_explicit(next_at(map, link - 1), memory_order_acquire);
+    }
+    return 0;
+}
+
+// Function to add 'delta' to the value of 'key' in a chained map, pushing a new node if absent.
+// A node that loses the race to another thread inserting the same key is kept in *spare.
+void chained_upsert(HashMap *map, unsigned long key, unsigned long delta, unsigned long *spare) {
+    _Atomic unsigned long *head = head_at(map, bucket_of(map, key));
+    unsigned long first = atomic_load_explicit(head, memory_order_acquire);
+    unsigned long link = chain_find(map, first, key);
+    if (link != 0) {
+        atomic_fetch_add_explicit(value_at(map, link - 1), delta, memory_order_relaxed);
+        return;
+    }
+
+    unsigned long node = *spare;
+    if (node == 0) {
+        node = atomic_fetch_add_explicit(&map->next_node, 1, memory_order_relaxed) + 1;
+        if (node > map->num_entries) {
+            fprintf(stderr, "Node pool exhausted.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    atomic_store_explicit(key_at(map, node - 1), key, memory_order_relaxed);
+    atomic_store_explicit(value_at(map, node - 1), delta, memory_order_relaxed);
+
+    for (;;) {
+        atomic_store_explicit(next_at(map, node - 1), first, memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(head, &first, node, memory_order_release, memory_order_acquire)) {
+            *spare = 0;
+            return;
+        }
+        // The head moved: another thread may have inserted the same key meanwhile
+        link = chain_find(map, first, key);
+        if (link != 0) {
+            atomic_fetch_add_explicit(value_at(map, link - 1), delta, memory_order_relaxed);
+            *spare = node;
+            return;
+        }
+    }
+}
+
+// Function to look up 'key' in a chained map (0 if absent)
+unsigned long chained_lookup(HashMap *map, unsigned long key) {
+    unsigned long first = atomic_load_explicit(head_at(map, bucket_of(map, key)), memory_order_acquire);
+    unsigned long link = chain_find(map, first, key);
+    return link ? atomic_load_explicit(value_at(map, link - 1), memory_order_relaxed) : 0;
+}
+
+// Function to sum every stored value
+unsigned long sum_values(HashMap *map) {
+    unsigned long total = 0;
+    if (map->kind == TABLE_OPEN) {
+        for (unsigned long i = 0; i < map->num_buckets; i++) {
+            if (atomic_load_explicit(key_at(map, i), memory_order_relaxed) != EMPTY_KEY) {
+                total += atomic_load_explicit(value_at(map, i), memory_order_relaxed);
+            }
+        }
+    } else {
+        for (unsigned long b = 0; b < map->num_buckets; b++) {
+            unsigned long link = atomic_load_explicit(head_at(map, b), memory_order_relaxed);
+            while (link != 0) {
+                total += atomic_load_explicit(value_at(map, link - 1), memory_order_relaxed);
+                link = atomic_load_explicit(next_at(map, link - 1), memory_order_relaxed);
+            }
+        }
+    }
+    return total;
+}
+
+// Function to precompute per-thread operations: entry = key << 1 | is_insert
+void build_op_rings(unsigned long *rings, int num_threads, unsigned long num_keys, KeySkew skew, int insert_pct) {
+    double *cdf = NULL;
+    if (skew == SKEW_ZIPF) {
+        cdf = (double *) malloc(num_keys * sizeof(double));
+        if (!cdf) {
+            fprintf(stderr, "Memory allocation failed for skew table.\n");
+            exit(EXIT_FAILURE);
+        }
+        double total = 0.0;
+        for (unsigned long k = 0; k < num_keys; k++) {
+            total += 1.0 / (double) (k + 1);
+            cdf[k] = total;
+        }
+        for (unsigned long k = 0; k < num_keys; k++) {
+            cdf[k] /= total;
+        }
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        unsigned int seed = (unsigned) time(NULL) ^ (unsigned) (t * 2654435761u);
+        for (unsigned long i = 0; i < OP_RING_SIZE; i++) {
+            unsigned long idx;
+            if (skew == SKEW_UNIFORM) {
+                idx = (unsigned long) rand_r(&seed) % num_keys;
+            } else {
+                double u = (double) rand_r(&seed) / ((double) RAND_MAX + 1.0);
+                unsigned long lo = 0, hi = num_keys - 1;
+                while (lo < hi) {
+                    unsigned long mid = (lo + hi) / 2;
+                    if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+                }
+                idx = lo;
+            }
+            unsigned long is_insert = (rand_r(&seed) % 100) < insert_pct;
+            rings[(unsigned long) t * OP_RING_SIZE + i] = ((idx + 1) << 1) | is_insert;
+        }
+    }
+
+    free(cdf);
+}
+
+// Per-thread operation counts, one cache line each
+typedef struct {
+    unsigned long inserts;
+    unsigned long found;
+} __attribute__((aligned(CACHE_LINE_SIZE))) OpCounts;
+
+// Shared state of the workload, handed to the per-thread body on every backend
+typedef struct {
+    HashMap *map;
+    unsigned long *rings;
+    unsigned long size;
+    OpCounts *counts;
+} OpContext;
+
+// Per-thread body: 'size' operations from the thread's own ring
+void operations_body(int tid, int num_threads, void *arg) {
+    (void) num_threads;
+    OpContext *ctx = (OpContext *) arg;
+    HashMap *map = ctx->map;
+    unsigned long *ring = ctx->rings + (unsigned long) tid * OP_RING_SIZE;
+    unsigned long spare = 0;
+    unsigned long inserts = 0;
+    unsigned long found = 0;
+
+    for (unsigned long i = 0; i < ctx->size; i++) {
+        unsigned long op = ring[i & (OP_RING_SIZE - 1)];
+        unsigned long key = op >> 1;
+        if (op & 1) {
+            if (map->kind == TABLE_OPEN) {
+                open_upsert(map, key, 1);
+            } else {
+                chained_upsert(map, key, 1, &spare);
+            }
+            inserts++;
+        } else {
+            found += (map->kind == TABLE_OPEN) ? open_lookup(map, key) : chained_lookup(map, key);
+        }
+    }
+
+    ctx->counts[tid].inserts = inserts;
+    ctx->counts[tid].found = found;
+}
+
+// Function to run the workload: each thread performs 'size' operations; returns the elapsed time
+double run_operations(HashMap *map, unsigned long *rings, unsigned long size, int num_threads, ThreadBackend backend,
+                      unsigned long *total_inserts, unsigned long *checksum) {
+    OpCounts *counts = NULL;
+    if (posix_memalign((void **) &counts, CACHE_LINE_SIZE, num_threads * sizeof(OpCounts)) != 0) {
+        fprintf(stderr, "Memory allocation failed for per-thread counts.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    OpContext ctx = { map, rings, size, counts };
+    double start_time = omp_get_wtime();
+    backend_run(backend, num_threads, operations_body, &ctx);
+    double elapsed = omp_get_wtime() - start_time;
+
+    unsigned long inserts = 0;
+    unsigned long found = 0;
+    for (int t = 0; t < num_threads; t++) {
+        inserts += counts[t].inserts;
+        found += counts[t].found;
+    }
+    free(counts);
+
+    *total_inserts = inserts;
+    *checksum = found;
+    return elapsed;
+}
+
+const char *table_name(TableKind kind) {
+    return kind == TABLE_OPEN ? "open" : "chained";
+}
+
+const char *layout_name(BucketLayout layout) {
+    switch (layout) {
+    case LAYOUT_PACKED: return "packed";
+    case LAYOUT_ALIGNED: return "aligned";
+    case LAYOUT_SPLIT: return "split";
+    }
+    return "unknown";
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good    : line-aligned buckets (one bucket per cache line)\n");
+    fprintf(stderr, "  bad-fs  : packed buckets (several buckets per cache line, false sharing)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --table=open|chained            open addressing or chaining (default open)\n");
+    fprintf(stderr, "  --layout=packed|aligned|split   override the bucket layout implied by the mode\n");
+    fprintf(stderr, "  --insert-pct=P                  percentage of operations that are inserts (default 50)\n");
+    fprintf(stderr, "  --skew=uniform|zipf             key distribution (default uniform)\n");
+    fprintf(stderr, "  --keys=N                        key space size (default 4096)\n");
+    fprintf(stderr, "  --cache=STATE                   cache state the operations start from: none, warm, cold-stream,\n");
+    fprintf(stderr, "                                  cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=none|populate|touch  fault the map and rings in before initialisation (default none)\n");
+    fprintf(stderr, "  --backend=openmp|pthread|pool   runtime that runs the operations (default openmp)\n");
+    fprintf(stderr, "size is the number of operations per thread.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    BucketLayout layout;
+    if (strcmp(mode, "good") == 0) {
+        layout = LAYOUT_ALIGNED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        layout = LAYOUT_PACKED;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    TableKind kind = TABLE_OPEN;
+    KeySkew skew = SKEW_UNIFORM;
+    int insert_pct = 50;
+    unsigned long num_keys = 4096;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--table=open") == 0) {
+            kind = TABLE_OPEN;
+        } else if (strcmp(argv[i], "--table=chained") == 0) {
+            kind = TABLE_CHAINED;
+        } else if (strcmp(argv[i], "--layout=packed") == 0) {
+            layout = LAYOUT_PACKED;
+        } else if (strcmp(argv[i], "--layout=aligned") == 0) {
+            layout = LAYOUT_ALIGNED;
+        } else if (strcmp(argv[i], "--layout=split") == 0) {
+            layout = LAYOUT_SPLIT;
+        } else if (strncmp(argv[i], "--insert-pct=", 13) == 0) {
+            insert_pct = atoi(argv[i] + 13);
+        } else if (strcmp(argv[i], "--skew=uniform") == 0) {
+            skew = SKEW_UNIFORM;
+        } else if (strcmp(argv[i], "--skew=zipf") == 0) {
+            skew = SKEW_ZIPF;
+        } else if (strncmp(argv[i], "--keys=", 7) == 0) {
+            num_keys = atol(argv[i] + 7);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (insert_pct < 0 || insert_pct > 100) {
+        fprintf(stderr, "Error: --insert-pct must be between 0 and 100.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_keys == 0) {
+        fprintf(stderr, "Error: --keys must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    HashMap map;
+    init_hash_map(&map, kind, layout, num_keys, num_threads, prefault, backend);
+
+    // Pre-populate half of the key space so lookups hit from the start
+    unsigned long spare = 0;
+    unsigned long prefilled = num_keys / 2;
+    for (unsigned long key = 1; key <= prefilled; key++) {
+        if (kind == TABLE_OPEN) {
+            open_upsert(&map, key, 1);
+        } else {
+            chained_upsert(&map, key, 1, &spare);
+        }
+    }
+
+    unsigned long *rings = (unsigned long *) malloc((unsigned long) num_threads * OP_RING_SIZE * sizeof(unsigned long));
+    if (!rings) {
+        fprintf(stderr, "Memory allocation failed for operation rings.\n");
+        free_hash_map(&map);
+        return EXIT_FAILURE;
+    }
+    prefault_range(prefault, rings, (unsigned long) num_threads * OP_RING_SIZE, sizeof(unsigned long), 1, num_threads,
+                   PARTITION_LINE, backend);
+    build_op_rings(rings, num_threads, num_keys, skew, insert_pct);
+
+    // Put the map and the operation rings in the requested cache state
+    CacheRegion regions[4];
+    int num_regions = 0;
+    regions[num_regions++] = (CacheRegion) { map.meta_alloc, map.num_entries, map.meta_stride, 1 };
+    if (map.val_alloc) {
+        regions[num_regions++] = (CacheRegion) { map.val_alloc, map.num_entries, map.val_stride, 1 };
+    }
+    if (map.heads) {
+        regions[num_regions++] = (CacheRegion) { map.heads, map.num_buckets, map.head_stride, 1 };
+    }
+    regions[num_regions++] = (CacheRegion) { rings, (unsigned long) num_threads * OP_RING_SIZE, sizeof(unsigned long), 0 };
+    cache_state_prepare(cache, regions, num_regions, num_threads, PARTITION_LINE, backend);
+    fault_phase_report(&faults, "setup");
+
+    unsigned long inserts = 0;
+    unsigned long checksum = 0;
+    fault_phase_begin(&faults);
+    double elapsed = run_operations(&map, rings, size, num_threads, backend, &inserts, &checksum);
+    fault_phase_report(&faults, "kernel");
+
+    unsigned long expected = prefilled + inserts;
+    unsigned long total = sum_values(&map);
+    unsigned long ops = (unsigned long) num_threads * size;
+
+    printf("Mode: %s (%s table, %s buckets, %d%% inserts, %s keys)\n", mode, table_name(kind),
+           layout_name(layout), insert_pct, skew == SKEW_ZIPF ? "zipf" : "uniform");
+    printf("Size: %lu\n", size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Keys: %lu (%lu buckets)\n", num_keys, map.num_buckets);
+    printf("Value Total: %lu (%s)\n", total, total == expected ? "ok" : "MISMATCH");
+    printf("Lookup Checksum: %lu\n", checksum);
+    printf("Ops/s: %.0f\n", ops / elapsed);
+    printf("Ops/s per Thread: %.0f\n", ops / elapsed / num_threads);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(rings);
+    free_hash_map(&map);
+
+    return total == expected ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,354 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+// This program demonstrates:
+// - The cost of moving one cache line between two cores: a ping-pong on a single line between
+//   two pinned threads, for every pair of CPUs (or one chosen pair)
+// - How that cost depends on where the cores are: SMT siblings share the L1, cores of one die
+//   share the LLC, cores on different sockets go over the interconnect
+// - A latency matrix (one-way ns per transfer) and a bandwidth matrix (MB/s when a 4 KiB block
+//   is handed back and forth), optionally saved as CSV so other tools can reuse the calibration
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Lines handed over per bandwidth round (4 KiB)
+#define BANDWIDTH_LINES 64
+
+// Round trips run before timing, so both threads are running and the line is warm
+#define WARMUP_ROUND_TRIPS 1000
+
+// Spins on a flag before yielding the CPU (only matters when both threads share one CPU)
+#define SPINS_BEFORE_YIELD (1UL << 16)
+
+// The ping-pong flag, alone on its cache line
+typedef struct {
+    _Atomic unsigned long value;
+    char padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
+} PaddedFlag;
+
+// State shared by the two threads of one pair
+typedef struct {
+    PaddedFlag *flag;
+    unsigned long *block;           // BANDWIDTH_LINES lines for the bandwidth rounds
+    unsigned long round_trips;
+    unsigned long bandwidth_rounds;
+    pthread_barrier_t start;
+    double latency_seconds;         // measured by the initiator
+    double bandwidth_seconds;
+    int check_ok;                   // cleared by the responder if a block held stale data
+} PairState;
+
+typedef struct {
+    PairState *state;
+    int initiator;
+} PairThread;
+
+// Result of one pair
+typedef struct {
+    double latency_ns;              // one-way: half a round trip
+    double bandwidth_mbs;           // block bytes delivered to the responder per second
+    int ok;
+} PairResult;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Function to wait until the flag holds 'value'
+static inline void wait_for(_Atomic unsigned long *flag, unsigned long value) {
+    unsigned long spins = 0;
+    while (atomic_load_explicit(flag, memory_order_acquire) != value) {
+        if (++spins % SPINS_BEFORE_YIELD == 0) sched_yield();
+    }
+}
+
+// Function run by both threads of a pair. The initiator stores odd values and waits for the
+// next even one; the responder waits for each odd value and answers with the next even one,
+// so each round trip moves the flag's line there and back.
+static void *pair_thread(void *arg) {
+    PairThread *self = (PairThread *) arg;
+    PairState *state = self->state;
+    _Atomic unsigned long *flag = &state->flag->value;
+    unsigned long seq = 0;
+
+    pthread_barrier_wait(&state->start);
+
+    // Latency: warm-up round trips, then the timed ones
+    for (int timed = 0; timed < 2; timed++) {
+        unsigned long count = timed ? state->round_trips : WARMUP_ROUND_TRIPS;
+        double start_time = now_seconds();
+        for (unsigned long i = 0; i < count; i++, seq += 2) {
+            if (self->initiator) {
+                atomic_store_explicit(flag, seq + 1, memory_order_release);
+                wait_for(flag, seq + 2);
+            } else {
+                wait_for(flag, seq + 1);
+                atomic_store_explicit(flag, seq + 2, memory_order_release);
+            }
+        }
+        if (timed && self->initiator) state->latency_seconds = now_seconds() - start_time;
+    }
+
+    // Bandwidth: the initiator writes every line of the block, the responder reads them all
+    double start_time = now_seconds();
+    for (unsigned long r = 0; r < state->bandwidth_rounds; r++, seq += 2) {
+        if (self->initiator) {
+            for (int l = 0; l < BANDWIDTH_LINES; l++) {
+                state->block[l * (CACHE_LINE_SIZE / sizeof(unsigned long))] = r + 1;
+            }
+            atomic_store_explicit(flag, seq + 1, memory_order_release);
+            wait_for(flag, seq + 2);
+        } else {
+            wait_for(flag, seq + 1);
+            for (int l = 0; l < BANDWIDTH_LINES; l++) {
+                if (state->block[l * (CACHE_LINE_SIZE / sizeof(unsigned long))] != r + 1) state->check_ok = 0;
+            }
+            atomic_store_explicit(flag, seq + 2, memory_order_release);
+        }
+    }
+    if (self->initiator) state->bandwidth_seconds = now_seconds() - start_time;
+
+    return NULL;
+}
+
+// Function to run the ping-pong between 'cpu_a' (initiator) and 'cpu_b' (responder)
+PairResult measure_pair(int cpu_a, int cpu_b, unsigned long round_trips) {
+    PairResult result = { 0.0, 0.0, 0 };
+    PairState state;
+    memset(&state, 0, sizeof(state));
+    state.round_trips = round_trips;
+    state.bandwidth_rounds = round_trips / 16 > 0 ? round_trips / 16 : 1;
+    state.check_ok = 1;
+    if (posix_memalign((void **) &state.flag, CACHE_LINE_SIZE, sizeof(PaddedFlag)) != 0 ||
+        posix_memalign((void **) &state.block, CACHE_LINE_SIZE, BANDWIDTH_LINES * CACHE_LINE_SIZE) != 0) {
+        fprintf(stderr, "Memory allocation failed for the ping-pong lines.\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&state.flag->value, 0);
+    memset(state.block, 0, BANDWIDTH_LINES * CACHE_LINE_SIZE);
+    pthread_barrier_init(&state.start, NULL, 2);
+
+    int cpus[2] = { cpu_a, cpu_b };
+    PairThread threads[2];
+    pthread_t handles[2];
+    for (int t = 0; t < 2; t++) {
+        threads[t].state = &state;
+        threads[t].initiator = t == 0;
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[t], &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        if (pthread_create(&handles[t], &attr, pair_thread, &threads[t]) != 0) {
+            fprintf(stderr, "Failed to start the thread pinned to CPU %d.\n", cpus[t]);
+            exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    for (int t = 0; t < 2; t++) pthread_join(handles[t], NULL);
+
+    result.latency_ns = state.latency_seconds * 1e9 / (2.0 * round_trips);
+    result.bandwidth_mbs = (double) state.bandwidth_rounds * BANDWIDTH_LINES * CACHE_LINE_SIZE /
+                           state.bandwidth_seconds / 1e6;
+    result.ok = state.check_ok;
+
+    pthread_barrier_destroy(&state.start);
+    free(state.flag);
+    free(state.block);
+    return result;
+}
+
+// Function to parse a comma-separated CPU list ("0,2,4"). Returns the count, or -1 if invalid.
+int parse_cpu_list(const char *list, int *cpus, int max_cpus) {
+    int count = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long cpu = strtol(p, &end, 10);
+        if (end == p || cpu < 0 || cpu >= CPU_SETSIZE || count >= max_cpus) return -1;
+        cpus[count++] = (int) cpu;
+        if (*end == ',') end++;
+        else if (*end != '\0') return -1;
+        p = end;
+    }
+    return count;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Function to print a symmetric CPU x CPU matrix of 'values' (pairs only, '-' on the diagonal)
+void print_matrix(const char *title, const int *cpus, int num_cpus, const double *values) {
+    printf("%s\n%6s", title, "");
+    for (int j = 0; j < num_cpus; j++) printf(" %8d", cpus[j]);
+    printf("\n");
+    for (int i = 0; i < num_cpus; i++) {
+        printf("%6d", cpus[i]);
+        for (int j = 0; j < num_cpus; j++) {
+            if (i == j) printf(" %8s", "-");
+            else printf(" %8.1f", values[i * num_cpus + j]);
+        }
+        printf("\n");
+    }
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [matrix|pair] [round-trips] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  matrix : ping-pong between every pair of the CPUs (default: all CPUs this process may use)\n");
+    fprintf(stderr, "  pair   : ping-pong between the two CPUs given with --cpus=A,B\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --cpus=LIST    comma-separated CPU list\n");
+    fprintf(stderr, "  --output=path  write cpu_a,cpu_b,latency_ns,bandwidth_mbs for every pair as CSV\n");
+    fprintf(stderr, "round-trips is the number of timed round trips per pair.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long round_trips = atol(argv[2]);
+
+    // Validate mode
+    int pair_mode;
+    if (strcmp(mode, "matrix") == 0) {
+        pair_mode = 0;
+    } else if (strcmp(mode, "pair") == 0) {
+        pair_mode = 1;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    static int cpus[CPU_SETSIZE];
+    int num_cpus = 0;
+    const char *output = NULL;
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "--cpus=", 7) == 0) {
+            num_cpus = parse_cpu_list(argv[i] + 7, cpus, CPU_SETSIZE);
+            if (num_cpus < 0) {
+                fprintf(stderr, "Invalid CPU list: %s\n", argv[i] + 7);
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            output = argv[i] + 9;
+        } else {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Validate round trips and CPUs
+    if (round_trips == 0) {
+        fprintf(stderr, "Error: Round trips must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_cpus == 0) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            perror("sched_getaffinity");
+            return EXIT_FAILURE;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) cpus[num_cpus++] = cpu;
+        }
+    }
+    if (pair_mode && num_cpus != 2) {
+        fprintf(stderr, "Error: pair mode needs exactly two CPUs (--cpus=A,B).\n");
+        return EXIT_FAILURE;
+    }
+    if (num_cpus < 2) {
+        fprintf(stderr, "Error: at least two CPUs are needed for a ping-pong (found %d).\n", num_cpus);
+        return EXIT_FAILURE;
+    }
+
+    // Measure every pair once (a < b) and mirror it
+    double *latency = (double *) calloc((size_t) num_cpus * num_cpus, sizeof(double));
+    double *bandwidth = (double *) calloc((size_t) num_cpus * num_cpus, sizeof(double));
+    int num_pairs = num_cpus * (num_cpus - 1) / 2;
+    double *sorted = (double *) malloc(num_pairs * sizeof(double));
+    if (!latency || !bandwidth || !sorted) {
+        fprintf(stderr, "Memory allocation failed for the matrices.\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *csv = NULL;
+    if (output) {
+        csv = fopen(output, "w");
+        if (!csv) {
+            perror(output);
+            return EXIT_FAILURE;
+        }
+        fprintf(csv, "cpu_a,cpu_b,latency_ns,bandwidth_mbs\n");
+    }
+
+    int ok = 1;
+    int min_pair[2] = { cpus[0], cpus[1] }, max_pair[2] = { cpus[0], cpus[1] };
+    double min_latency = 0.0, max_latency = 0.0;
+    int p = 0;
+    double start_time = now_seconds();
+    for (int i = 0; i < num_cpus; i++) {
+        for (int j = i + 1; j < num_cpus; j++) {
+            PairResult r = measure_pair(cpus[i], cpus[j], round_trips);
+            if (!r.ok) ok = 0;
+            latency[i * num_cpus + j] = latency[j * num_cpus + i] = r.latency_ns;
+            bandwidth[i * num_cpus + j] = bandwidth[j * num_cpus + i] = r.bandwidth_mbs;
+            sorted[p] = r.latency_ns;
+            if (p == 0 || r.latency_ns < min_latency) {
+                min_latency = r.latency_ns;
+                min_pair[0] = cpus[i];
+                min_pair[1] = cpus[j];
+            }
+            if (p == 0 || r.latency_ns > max_latency) {
+                max_latency = r.latency_ns;
+                max_pair[0] = cpus[i];
+                max_pair[1] = cpus[j];
+            }
+            p++;
+            if (csv) fprintf(csv, "%d,%d,%.2f,%.1f\n", cpus[i], cpus[j], r.latency_ns, r.bandwidth_mbs);
+        }
+    }
+    double elapsed = now_seconds() - start_time;
+    if (csv) fclose(csv);
+    qsort(sorted, num_pairs, sizeof(double), compare_double);
+
+    printf("Mode: %s (%d CPUs, %d pairs, %lu round trips per pair)\n", mode, num_cpus, num_pairs, round_trips);
+    if (pair_mode) {
+        printf("CPU %d <-> CPU %d: %.1f ns one-way, %.1f MB/s\n", cpus[0], cpus[1], latency[1], bandwidth[1]);
+    } else {
+        print_matrix("Latency (ns, one-way per line transfer):", cpus, num_cpus, latency);
+        print_matrix("Bandwidth (MB/s, 4 KiB block handed over):", cpus, num_cpus, bandwidth);
+        printf("Latency Summary: min %.1f ns (CPUs %d-%d), median %.1f ns, max %.1f ns (CPUs %d-%d)\n",
+               min_latency, min_pair[0], min_pair[1], sorted[num_pairs / 2], max_latency, max_pair[0], max_pair[1]);
+    }
+    if (output) printf("Saved: %s\n", output);
+    printf("Check: %s\n", ok ? "ok" : "MISMATCH");
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(latency);
+    free(bandwidth);
+    free(sorted);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
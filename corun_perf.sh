@@ -0,0 +1,198 @@
+#!/bin/bash
+
+# ==============================================================================
+# Script Name: corun_perf.sh
+# Description: Runs a victim configuration next to an aggressor kernel on
+#              disjoint physical cores of the same socket (shared LLC and memory
+#              controller), collects 'perf' metrics for both jobs, and logs the
+#              victim into the same CSV as perf_data.sh and the aggressor into
+#              a CSV of its own.
+#
+#              A 'good' victim that runs next to an aggressor is labelled
+#              Mode=interference; victims with a bad mode keep their own label.
+#              The Options column records the role, the victim's own mode and
+#              options, and the partner job, e.g.
+#                role=victim victim_mode=good aggressor=./sc_29:bad-ma:300000000
+#                role=aggressor victim=./sc_28:good:1000000000
+#              Each victim configuration also runs alone (aggressor "none") as
+#              the baseline under the same pinning.
+# ==============================================================================
+
+# ==============================================================================
+# Configuration Variables
+# ==============================================================================
+
+# Number of iterations per victim/aggressor pair
+ITERATIONS=3
+
+# Output files (shared with perf_data.sh). An aggressor row covers several
+# restarted runs, the last one cut short, so it is not a sample of its mode and
+# goes to a file of its own that the classifier does not read.
+OUTPUT_FILE="perf_data.csv"
+AGGRESSOR_OUTPUT_FILE="corun_aggressors.csv"
+ERROR_LOG="error.log"
+LOG_FILE="corun_run.log"
+
+# Seconds the aggressor runs before the victim starts, so the victim sees a warm neighbour
+AGGRESSOR_WARMUP=1
+
+# Cores for each job; empty means split the physical cores of socket 0 in two halves
+VICTIM_CPUS=""
+AGGRESSOR_CPUS=""
+
+# Victim configurations: "program mode size threads [options]"
+VICTIMS=(
+    "./sc_28 good 1000000000 4"
+    "./sc_29 good 100000000 4"
+    "./mc_31 good 10000 4"
+    "./vec_14 good 300000000 4"
+    # Add more victim configurations here if needed
+)
+
+# Aggressor configurations: "program mode size threads [options]", or "none" for the
+# victim-alone baseline. The aggressor is restarted until the victim has finished.
+AGGRESSORS=(
+    "none"
+    "./sc_29 bad-ma 300000000 4"
+    "./vec_14 good 500000000 4"
+    "./tr_61 bad-ma 8000 4"
+    # Add more aggressor configurations here if needed
+)
+
+# ==============================================================================
+# Redirect All Output to Log File
+# ==============================================================================
+
+# Redirect both stdout and stderr to LOG_FILE while displaying in terminal
+exec > >(tee -a "$LOG_FILE") 2>&1
+
+# ==============================================================================
+# Shared CSV Layout and perf Helpers
+# ==============================================================================
+source "$(dirname "$0")/perf_common.sh"
+
+init_output_file
+OUTPUT_FILE="$AGGRESSOR_OUTPUT_FILE" init_output_file
+load_core_latency
+
+# ==============================================================================
+# Function: split_socket_cpus
+# Description: Lists one logical CPU per physical core of socket 0 and prints
+#              the first half and the second half as two comma-separated lists.
+#              SMT siblings are skipped so the two jobs never share a core.
+# ==============================================================================
+split_socket_cpus() {
+    local cpus
+    cpus=$(lscpu -p=CPU,CORE,SOCKET | grep -v '^#' | awk -F, '$3 == 0 && !seen[$2]++ {print $1}')
+    local count
+    count=$(echo "$cpus" | wc -l)
+    if [ "$count" -lt 2 ]; then
+        echo "Error: socket 0 has fewer than two physical cores; set VICTIM_CPUS and AGGRESSOR_CPUS." >&2
+        return 1
+    fi
+    local half=$((count / 2))
+    echo "$cpus" | head -n "$half" | paste -sd, -
+    echo "$cpus" | tail -n "$((count - half))" | paste -sd, -
+}
+
+if [ -z "$VICTIM_CPUS" ] || [ -z "$AGGRESSOR_CPUS" ]; then
+    SPLIT=$(split_socket_cpus) || exit 1
+    VICTIM_CPUS=$(echo "$SPLIT" | sed -n 1p)
+    AGGRESSOR_CPUS=$(echo "$SPLIT" | sed -n 2p)
+fi
+echo "Victim CPUs: $VICTIM_CPUS, aggressor CPUs: $AGGRESSOR_CPUS"
+
+# ==============================================================================
+# Verify Executability of All Programs
+# ==============================================================================
+for CONFIG in "${VICTIMS[@]}" "${AGGRESSORS[@]}"; do
+    [ "$CONFIG" = "none" ] && continue
+    PROGRAM=${CONFIG%% *}
+    if [ ! -x "$PROGRAM" ]; then
+        echo "Error: Program $PROGRAM not found or not executable."
+        exit 1
+    fi
+done
+
+# ==============================================================================
+# Function: corun_and_log
+# Description: Starts the aggressor (if any) in its own process group under
+#              'perf stat', runs the victim under 'perf stat' once the warmup
+#              has passed, then stops the aggressor so perf reports its
+#              counters over the co-run, and logs a row for each job (the
+#              aggressor's to AGGRESSOR_OUTPUT_FILE).
+# ==============================================================================
+corun_and_log() {
+    local victim="$1"
+    local aggressor="$2"
+    local run="$3"
+
+    read -r v_program v_mode v_size v_threads v_options <<< "$victim"
+
+    local agg_pid=""
+    local agg_output=""
+    local stop_file=""
+    local victim_mode="$v_mode"
+    local victim_options="role=victim victim_mode=$v_mode aggressor=none"
+    if [ "$aggressor" != "none" ]; then
+        read -r a_program a_mode a_size a_threads a_options <<< "$aggressor"
+        agg_output=$(mktemp)
+        stop_file="$agg_output.stop"
+
+        # Repeat the aggressor until the stop file appears. Background jobs ignore SIGINT, so
+        # it is stopped with the stop file plus SIGTERM to the running instance; setsid gives
+        # the job its own process group to find that instance in.
+        setsid bash -c "source '$(dirname "$0")/perf_common.sh'; \
+            perf_collect taskset -c '$AGGRESSOR_CPUS' bash -c \
+            'while [ ! -e \"\$0\" ]; do \"\$@\" > /dev/null || [ -e \"\$0\" ] || exit 1; done' \
+            '$stop_file' '$a_program' '$a_mode' '$a_size' '$a_threads' $a_options" > "$agg_output" 2>&1 &
+        agg_pid=$!
+        sleep "$AGGRESSOR_WARMUP"
+
+        [ "$v_mode" = "good" ] && victim_mode="interference"
+        victim_options="role=victim victim_mode=$v_mode aggressor=$a_program:$a_mode:$a_size"
+    fi
+    [ -n "$v_options" ] && victim_options="$victim_options $v_options"
+
+    echo "    Run #$run"
+    echo "    Victim: $victim (CPUs $VICTIM_CPUS), aggressor: $aggressor"
+
+    PERF_OUTPUT=$(perf_collect taskset -c "$VICTIM_CPUS" "$v_program" "$v_mode" "$v_size" "$v_threads" $v_options)
+    local status=$?
+    log_perf_line "$v_program" "$victim_mode" "$v_threads" "$v_size" "$victim_options" "$run" "$status" "$PERF_OUTPUT" \
+        "$(cpu_set_latency "$VICTIM_CPUS")"
+
+    if [ -n "$agg_pid" ]; then
+        # An aggressor that already exited on its own failed; otherwise stop it now
+        local agg_status=0
+        if kill -0 "$agg_pid" 2> /dev/null; then
+            touch "$stop_file"
+            pkill -TERM -g "$agg_pid" -x "$(basename "$a_program")"
+            wait "$agg_pid"
+        else
+            wait "$agg_pid"
+            agg_status=1
+        fi
+        local agg_options="role=aggressor victim=$v_program:$v_mode:$v_size"
+        [ -n "$a_options" ] && agg_options="$agg_options $a_options"
+        OUTPUT_FILE="$AGGRESSOR_OUTPUT_FILE" log_perf_line "$a_program" "$a_mode" "$a_threads" "$a_size" "$agg_options" "$run" "$agg_status" "$(cat "$agg_output")" \
+            "$(cpu_set_latency "$AGGRESSOR_CPUS")"
+        rm -f "$agg_output" "$stop_file"
+    fi
+}
+
+# ==============================================================================
+# Main Execution Loop
+# ==============================================================================
+echo "Starting co-run interference tests."
+
+for VICTIM in "${VICTIMS[@]}"; do
+    for AGGRESSOR in "${AGGRESSORS[@]}"; do
+        echo "  Configuration: Victim=$VICTIM, Aggressor=$AGGRESSOR"
+        for RUN in $(seq 1 "$ITERATIONS"); do
+            corun_and_log "$VICTIM" "$AGGRESSOR" "$RUN"
+        done
+    done
+done
+
+echo "Co-run data collection complete. Victim data saved to $OUTPUT_FILE, aggressor data to $AGGRESSOR_OUTPUT_FILE."
@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Dense N x N matrix multiply C += A * B, a compute-heavy kernel (2N^3 flops on 3N^2 data)
+// - Loop orders ijk, ikj and jik, whose inner loops walk B by column (strided) or by row
+// - Cache-blocked and register-blocked (4 x 4 micro-tile) variants
+// - A false-sharing variant: ikj order with C's columns dealt to threads in half-line groups
+// - Reporting GFLOP/s, so memory pathologies can be compared under high arithmetic intensity
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Default cache tile edge (three 64 x 64 double tiles = 96 KiB)
+#define DEFAULT_BLOCK 64
+
+// Register micro-tile edge
+#define REG_TILE 4
+
+// Columns of C per ownership group in the interleaved variant (32 bytes, half a cache line)
+#define INTERLEAVE_COLUMNS 4
+
+typedef enum {
+    VARIANT_IJK,         // inner loop over k: B read down a column
+    VARIANT_IKJ,         // inner loop over j: B and C read along rows
+    VARIANT_JIK,         // columns of C split into contiguous per-thread blocks
+    VARIANT_BLOCKED,     // ikj over cache-sized tiles
+    VARIANT_REGBLOCKED,  // 4 x 4 tiles of C held in registers over the whole k range
+    VARIANT_INTERLEAVED  // ikj with groups of C columns dealt round-robin to threads
+} Variant;
+
+// Function to allocate an N x N matrix aligned to a cache line
+double *alloc_matrix(unsigned long n) {
+    double *m = NULL;
+    if (posix_memalign((void **) &m, CACHE_LINE_SIZE, n * n * sizeof(double)) != 0) {
+        fprintf(stderr, "Memory allocation failed for a %lu x %lu matrix.\n", n, n);
+        exit(EXIT_FAILURE);
+    }
+    return m;
+}
+
+// Shared state of the initialisation and the multiply variants, handed to the per-thread body on every backend
+typedef struct {
+    double *A;
+    double *B;
+    double *C;
+    unsigned long n;
+    unsigned long block;
+} MatmulContext;
+
+// Per-thread body: fill the thread's rows of A and B with small integers (so every product sum
+// is exact) and clear them in C
+void initialize_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    unsigned long n = ctx->n;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        for (unsigned long j = 0; j < n; j++) {
+            ctx->A[i * n + j] = (double) ((i + j) % 8);
+            ctx->B[i * n + j] = (double) ((2 * i + j) % 8);
+            ctx->C[i * n + j] = 0.0;
+        }
+    }
+}
+
+void matmul_ijk_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    const double *A = ctx->A, *B = ctx->B;
+    double *C = ctx->C;
+    unsigned long n = ctx->n;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        for (unsigned long j = 0; j < n; j++) {
+            for (unsigned long k = 0; k < n; k++) {
+                C[i * n + j] += A[i * n + k] * B[k * n + j];
+            }
+        }
+    }
+}
+
+void matmul_ikj_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    const double *A = ctx->A, *B = ctx->B;
+    double *C = ctx->C;
+    unsigned long n = ctx->n;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        for (unsigned long k = 0; k < n; k++) {
+            double a = A[i * n + k];
+            for (unsigned long j = 0; j < n; j++) {
+                C[i * n + j] += a * B[k * n + j];
+            }
+        }
+    }
+}
+
+// Per-thread body of the jik order: the columns of C split into contiguous blocks
+void matmul_jik_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    const double *A = ctx->A, *B = ctx->B;
+    double *C = ctx->C;
+    unsigned long n = ctx->n;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long j = start; j < end; j++) {
+        for (unsigned long i = 0; i < n; i++) {
+            for (unsigned long k = 0; k < n; k++) {
+                C[i * n + j] += A[i * n + k] * B[k * n + j];
+            }
+        }
+    }
+}
+
+// Per-thread body of the interleaved order: the ikj loops of the good variants, but every thread
+// walks all rows and updates only its own groups of INTERLEAVE_COLUMNS columns, dealt round-robin.
+// B and C are still read along rows; only the ownership of C changes, so two threads write each
+// line of C.
+void matmul_interleaved_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    const double *A = ctx->A, *B = ctx->B;
+    double *C = ctx->C;
+    unsigned long n = ctx->n;
+    unsigned long first = (unsigned long) tid * INTERLEAVE_COLUMNS;
+    unsigned long stride = (unsigned long) num_threads * INTERLEAVE_COLUMNS;
+    for (unsigned long i = 0; i < n; i++) {
+        for (unsigned long k = 0; k < n; k++) {
+            double a = A[i * n + k];
+            for (unsigned long jj = first; jj < n; jj += stride) {
+                unsigned long j_end = jj + INTERLEAVE_COLUMNS < n ? jj + INTERLEAVE_COLUMNS : n;
+                for (unsigned long j = jj; j < j_end; j++) {
+                    C[i * n + j] += a * B[k * n + j];
+                }
+            }
+        }
+    }
+}
+
+// Per-thread body of the blocked order: contiguous blocks of row tiles per thread
+void matmul_blocked_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    const double *A = ctx->A, *B = ctx->B;
+    double *C = ctx->C;
+    unsigned long n = ctx->n, block = ctx->block;
+    unsigned long start, end;
+    backend_static_range((n + block - 1) / block, num_threads, tid, &start, &end);
+    for (unsigned long ii = start * block; ii < end * block; ii += block) {
+        unsigned long i_end = (ii + block < n) ? ii + block : n;
+        for (unsigned long kk = 0; kk < n; kk += block) {
+            unsigned long k_end = (kk + block < n) ? kk + block : n;
+            for (unsigned long jj = 0; jj < n; jj += block) {
+                unsigned long j_end = (jj + block < n) ? jj + block : n;
+                for (unsigned long i = ii; i < i_end; i++) {
+                    for (unsigned long k = kk; k < k_end; k++) {
+                        double a = A[i * n + k];
+                        for (unsigned long j = jj; j < j_end; j++) {
+                            C[i * n + j] += a * B[k * n + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Per-thread body of the 4 x 4 register tiles over contiguous blocks of tile rows; ragged edges
+// fall back to scalar dot products
+void matmul_regblocked_body(int tid, int num_threads, void *arg) {
+    MatmulContext *ctx = (MatmulContext *) arg;
+    const double *A = ctx->A, *B = ctx->B;
+    double *C = ctx->C;
+    unsigned long n = ctx->n;
+    unsigned long n_tiled = n - n % REG_TILE;
+    unsigned long start, end;
+    backend_static_range((n + REG_TILE - 1) / REG_TILE, num_threads, tid, &start, &end);
+
+    for (unsigned long i = start * REG_TILE; i < end * REG_TILE; i += REG_TILE) {
+        if (i < n_tiled) {
+            for (unsigned long j = 0; j < n_tiled; j += REG_TILE) {
+                double c00 = 0, c01 = 0, c02 = 0, c03 = 0;
+                double c10 = 0, c11 = 0, c12 = 0, c13 = 0;
+                double c20 = 0, c21 = 0, c22 = 0, c23 = 0;
+                double c30 = 0, c31 = 0, c32 = 0, c33 = 0;
+                for (unsigned long k = 0; k < n; k++) {
+                    const double *b = &B[k * n + j];
+                    double a0 = A[i * n + k], a1 = A[(i + 1) * n + k];
+                    double a2 = A[(i + 2) * n + k], a3 = A[(i + 3) * n + k];
+                    c00 += a0 * b[0]; c01 += a0 * b[1]; c02 += a0 * b[2]; c03 += a0 * b[3];
+                    c10 += a1 * b[0]; c11 += a1 * b[1]; c12 += a1 * b[2]; c13 += a1 * b[3];
+                    c20 += a2 * b[0]; c21 += a2 * b[1]; c22 += a2 * b[2]; c23 += a2 * b[3];
+                    c30 += a3 * b[0]; c31 += a3 * b[1]; c32 += a3 * b[2]; c33 += a3 * b[3];
+                }
+                double *c = &C[i * n + j];
+                c[0] += c00; c[1] += c01; c[2] += c02; c[3] += c03;
+                c += n;
+                c[0] += c10; c[1] += c11; c[2] += c12; c[3] += c13;
+                c += n;
+                c[0] += c20; c[1] += c21; c[2] += c22; c[3] += c23;
+                c += n;
+                c[0] += c30; c[1] += c31; c[2] += c32; c[3] += c33;
+            }
+        }
+
+        // Remaining columns of full tiles, and every column of the ragged last rows
+        unsigned long i_end = (i + REG_TILE < n) ? i + REG_TILE : n;
+        for (unsigned long r = i; r < i_end; r++) {
+            unsigned long j_start = (i < n_tiled) ? n_tiled : 0;
+            for (unsigned long j = j_start; j < n; j++) {
+                double sum = 0.0;
+                for (unsigned long k = 0; k < n; k++) {
+                    sum += A[r * n + k] * B[k * n + j];
+                }
+                C[r * n + j] += sum;
+            }
+        }
+    }
+}
+
+// Function to check a sample of C entries against direct dot products
+int verify_result(const double *A, const double *B, const double *C, unsigned long n) {
+    unsigned long picks[4] = { 0, n / 3, (2 * n) / 3, n - 1 };
+    for (int p = 0; p < 4; p++) {
+        for (int q = 0; q < 4; q++) {
+            unsigned long i = picks[p], j = picks[q];
+            double expected = 0.0;
+            for (unsigned long k = 0; k < n; k++) {
+                expected += A[i * n + k] * B[k * n + j];
+            }
+            if (C[i * n + j] != expected) return 0;
+        }
+    }
+    return 1;
+}
+
+const char *variant_name(Variant variant) {
+    switch (variant) {
+    case VARIANT_IJK: return "ijk";
+    case VARIANT_IKJ: return "ikj";
+    case VARIANT_JIK: return "jik";
+    case VARIANT_BLOCKED: return "blocked";
+    case VARIANT_REGBLOCKED: return "register-blocked";
+    case VARIANT_INTERLEAVED: return "ikj, interleaved column groups";
+    }
+    return "unknown";
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|bad-ma|ikj|jik|regblocked] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good       : cache-blocked ikj tiles\n");
+    fprintf(stderr, "  bad-fs     : ikj with groups of 4 columns of C dealt round-robin to threads (false sharing)\n");
+    fprintf(stderr, "  bad-ma     : ijk order, B walked down its columns\n");
+    fprintf(stderr, "  ikj        : ikj order, untiled\n");
+    fprintf(stderr, "  jik        : jik order, contiguous column blocks per thread\n");
+    fprintf(stderr, "  regblocked : 4 x 4 register tiles\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --block=B      tile edge for good mode (default 64)\n");
+    fprintf(stderr, "  --cache=STATE  cache state the multiply starts from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M   fault the matrices in before initialisation: none, populate or touch (default none)\n");
+    fprintf(stderr, "  --backend=B    runtime that runs the initialisation and the multiply: openmp, pthread or pool (default openmp)\n");
+    fprintf(stderr, "size is the matrix dimension N.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    Variant variant;
+    if (strcmp(mode, "good") == 0) {
+        variant = VARIANT_BLOCKED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        variant = VARIANT_INTERLEAVED;
+    } else if (strcmp(mode, "bad-ma") == 0) {
+        variant = VARIANT_IJK;
+    } else if (strcmp(mode, "ikj") == 0) {
+        variant = VARIANT_IKJ;
+    } else if (strcmp(mode, "jik") == 0) {
+        variant = VARIANT_JIK;
+    } else if (strcmp(mode, "regblocked") == 0) {
+        variant = VARIANT_REGBLOCKED;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    unsigned long block = DEFAULT_BLOCK;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--block=", 8) == 0) {
+            block = atol(argv[i] + 8);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (block == 0) {
+        fprintf(stderr, "Error: --block must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    double *A = alloc_matrix(size);
+    double *B = alloc_matrix(size);
+    double *C = alloc_matrix(size);
+    prefault_range(prefault, A, size * size, sizeof(double), 1, num_threads, PARTITION_LINE, backend);
+    prefault_range(prefault, B, size * size, sizeof(double), 1, num_threads, PARTITION_LINE, backend);
+    prefault_range(prefault, C, size * size, sizeof(double), 1, num_threads, PARTITION_LINE, backend);
+    MatmulContext ctx = { A, B, C, size, block };
+    backend_run(backend, num_threads, initialize_body, &ctx);
+
+    // Put the three matrices in the requested cache state
+    CacheRegion regions[] = { { A, size * size, sizeof(double), 0 },
+                              { B, size * size, sizeof(double), 0 },
+                              { C, size * size, sizeof(double), 1 } };
+    cache_state_prepare(cache, regions, 3, num_threads, PARTITION_LINE, backend);
+    fault_phase_report(&faults, "setup");
+
+    fault_phase_begin(&faults);
+    double start_time = omp_get_wtime();
+
+    BackendBody body = matmul_ikj_body;
+    switch (variant) {
+    case VARIANT_IJK: body = matmul_ijk_body; break;
+    case VARIANT_IKJ: body = matmul_ikj_body; break;
+    case VARIANT_JIK: body = matmul_jik_body; break;
+    case VARIANT_BLOCKED: body = matmul_blocked_body; break;
+    case VARIANT_REGBLOCKED: body = matmul_regblocked_body; break;
+    case VARIANT_INTERLEAVED: body = matmul_interleaved_body; break;
+    }
+    backend_run(backend, num_threads, body, &ctx);
+
+    double end_time = omp_get_wtime();
+    fault_phase_report(&faults, "kernel");
+    double elapsed = end_time - start_time;
+    int ok = verify_result(A, B, C, size);
+    double flops = 2.0 * (double) size * (double) size * (double) size;
+
+    if (variant == VARIANT_BLOCKED) {
+        printf("Mode: %s (%s, %lu x %lu tiles)\n", mode, variant_name(variant), block, block);
+    } else {
+        printf("Mode: %s (%s)\n", mode, variant_name(variant));
+    }
+    printf("Size: %lu x %lu\n", size, size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Result Check: %s\n", ok ? "ok" : "MISMATCH");
+    printf("GFLOP/s: %.3f\n", flops / elapsed / 1e9);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(A);
+    free(B);
+    free(C);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
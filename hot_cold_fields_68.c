@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Objects with a read-mostly (cold) field and a write-hot field, in three layouts:
+//   AoS with hot and cold side by side, AoS with the hot field padded onto its own cache line,
+//   and SoA (separate hot and cold arrays)
+// - Threads updating the hot fields of a disjoint block of objects while reading the cold fields
+//   of another thread's block, so writing one object's hot field evicts other threads' cold reads
+//   whenever both share a line
+// - Reporting updates/s per layout
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Object layouts
+typedef enum {
+    LAYOUT_AOS,         // { cold, hot } back-to-back: 4 objects per line, hot next to cold
+    LAYOUT_AOS_PADDED,  // { cold, pad, hot, pad }: cold and hot on separate lines
+    LAYOUT_SOA          // cold[] and hot[] arrays
+} ObjectLayout;
+
+typedef struct {
+    unsigned long cold;
+    unsigned long hot;
+} Object;
+
+typedef struct {
+    unsigned long cold;
+    char cold_padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
+    unsigned long hot;
+    char hot_padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
+} PaddedObject;
+
+// The objects in whichever layout was chosen
+typedef struct {
+    ObjectLayout layout;
+    unsigned long count;
+    Object *aos;
+    PaddedObject *aos_padded;
+    unsigned long *soa_cold;
+    unsigned long *soa_hot;
+} ObjectArray;
+
+const char *layout_name(ObjectLayout layout) {
+    switch (layout) {
+    case LAYOUT_AOS: return "aos";
+    case LAYOUT_AOS_PADDED: return "aos-padded";
+    case LAYOUT_SOA: return "soa";
+    }
+    return "unknown";
+}
+
+static inline unsigned long cold_value(unsigned long i) {
+    return i % 97 + 1;
+}
+
+// Shared state of the initialisation and the kernel, handed to the per-thread body on every backend
+typedef struct {
+    ObjectArray *objects;
+    int passes;
+} ObjectContext;
+
+static void *alloc_aligned(size_t bytes, PrefaultMode prefault, int num_threads, ThreadBackend backend) {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, bytes) != 0) {
+        fprintf(stderr, "Memory allocation failed for %zu bytes.\n", bytes);
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, ptr, bytes, 1, 1, num_threads, PARTITION_LINE, backend);
+    return ptr;
+}
+
+// Per-thread body: cold = i % 97 + 1, hot = 0 over the thread's static block of objects
+void init_objects_body(int tid, int num_threads, void *arg) {
+    ObjectArray *objects = ((ObjectContext *) arg)->objects;
+    unsigned long start, end;
+    backend_static_range(objects->count, num_threads, tid, &start, &end);
+
+    switch (objects->layout) {
+    case LAYOUT_AOS:
+        for (unsigned long i = start; i < end; i++) {
+            objects->aos[i].cold = cold_value(i);
+            objects->aos[i].hot = 0;
+        }
+        break;
+    case LAYOUT_AOS_PADDED:
+        for (unsigned long i = start; i < end; i++) {
+            objects->aos_padded[i].cold = cold_value(i);
+            objects->aos_padded[i].hot = 0;
+        }
+        break;
+    case LAYOUT_SOA:
+        for (unsigned long i = start; i < end; i++) {
+            objects->soa_cold[i] = cold_value(i);
+            objects->soa_hot[i] = 0;
+        }
+        break;
+    }
+}
+
+// Function to allocate (prefaulted as requested) and initialize the objects: cold = i % 97 + 1, hot = 0
+void init_objects(ObjectArray *objects, ObjectLayout layout, unsigned long count, PrefaultMode prefault,
+                  int num_threads, ThreadBackend backend) {
+    memset(objects, 0, sizeof(*objects));
+    objects->layout = layout;
+    objects->count = count;
+
+    switch (layout) {
+    case LAYOUT_AOS:
+        objects->aos = (Object *) alloc_aligned(count * sizeof(Object), prefault, num_threads, backend);
+        break;
+    case LAYOUT_AOS_PADDED:
+        objects->aos_padded = (PaddedObject *) alloc_aligned(count * sizeof(PaddedObject), prefault, num_threads,
+                                                             backend);
+        break;
+    case LAYOUT_SOA:
+        objects->soa_cold = (unsigned long *) alloc_aligned(count * sizeof(unsigned long), prefault, num_threads,
+                                                            backend);
+        objects->soa_hot = (unsigned long *) alloc_aligned(count * sizeof(unsigned long), prefault, num_threads,
+                                                           backend);
+        break;
+    }
+
+    ObjectContext ctx = { objects, 0 };
+    backend_run(backend, num_threads, init_objects_body, &ctx);
+}
+
+// Function to put the objects in the requested cache state before the kernel
+void prepare_objects(const ObjectArray *objects, CacheState cache, int num_threads, ThreadBackend backend) {
+    CacheRegion regions[2];
+    int num_regions = 0;
+    switch (objects->layout) {
+    case LAYOUT_AOS:
+        regions[num_regions++] = (CacheRegion) { objects->aos, objects->count, sizeof(Object), 1 };
+        break;
+    case LAYOUT_AOS_PADDED:
+        regions[num_regions++] = (CacheRegion) { objects->aos_padded, objects->count, sizeof(PaddedObject), 1 };
+        break;
+    case LAYOUT_SOA:
+        regions[num_regions++] = (CacheRegion) { objects->soa_cold, objects->count, sizeof(unsigned long), 0 };
+        regions[num_regions++] = (CacheRegion) { objects->soa_hot, objects->count, sizeof(unsigned long), 1 };
+        break;
+    }
+    cache_state_prepare(cache, regions, num_regions, num_threads, PARTITION_LINE, backend);
+}
+
+void free_objects(ObjectArray *objects) {
+    free(objects->aos);
+    free(objects->aos_padded);
+    free(objects->soa_cold);
+    free(objects->soa_hot);
+}
+
+// Per-thread body of the kernel: the thread owns a contiguous block of objects and, for every
+// owned object i, adds the cold field of object (i + block) % count, which belongs to the next
+// thread's block, to hot[i]. Repeated for 'passes' passes.
+void kernel_body(int tid, int num_threads, void *arg) {
+    ObjectContext *ctx = (ObjectContext *) arg;
+    ObjectArray *objects = ctx->objects;
+    unsigned long count = objects->count;
+    unsigned long start = count * tid / num_threads;
+    unsigned long end = count * (tid + 1) / num_threads;
+    unsigned long shift = count / num_threads;
+
+    for (int p = 0; p < ctx->passes; p++) {
+        switch (objects->layout) {
+        case LAYOUT_AOS: {
+            Object *aos = objects->aos;
+            for (unsigned long i = start; i < end; i++) {
+                aos[i].hot += aos[(i + shift) % count].cold;
+            }
+            break;
+        }
+        case LAYOUT_AOS_PADDED: {
+            PaddedObject *aos = objects->aos_padded;
+            for (unsigned long i = start; i < end; i++) {
+                aos[i].hot += aos[(i + shift) % count].cold;
+            }
+            break;
+        }
+        case LAYOUT_SOA: {
+            unsigned long *cold = objects->soa_cold;
+            unsigned long *hot = objects->soa_hot;
+            for (unsigned long i = start; i < end; i++) {
+                hot[i] += cold[(i + shift) % count];
+            }
+            break;
+        }
+        }
+    }
+}
+
+// Function to run the kernel for 'passes' passes; returns the elapsed time
+double run_kernel(ObjectArray *objects, int passes, int num_threads, ThreadBackend backend) {
+    ObjectContext ctx = { objects, passes };
+    double start_time = omp_get_wtime();
+    backend_run(backend, num_threads, kernel_body, &ctx);
+    return omp_get_wtime() - start_time;
+}
+
+// Function to check every hot field against passes * (the cold value it accumulated)
+int check_objects(const ObjectArray *objects, int passes, int num_threads) {
+    unsigned long count = objects->count;
+    unsigned long shift = count / num_threads;
+    for (unsigned long i = 0; i < count; i++) {
+        unsigned long hot = 0;
+        switch (objects->layout) {
+        case LAYOUT_AOS: hot = objects->aos[i].hot; break;
+        case LAYOUT_AOS_PADDED: hot = objects->aos_padded[i].hot; break;
+        case LAYOUT_SOA: hot = objects->soa_hot[i]; break;
+        }
+        if (hot != (unsigned long) passes * cold_value((i + shift) % count)) return 0;
+    }
+    return 1;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|padded] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good    : SoA, separate cold and hot arrays\n");
+    fprintf(stderr, "  bad-fs  : AoS, hot field next to cold field (4 objects per cache line)\n");
+    fprintf(stderr, "  padded  : AoS, hot field padded onto its own cache line\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --passes=P     passes over the objects (default 10)\n");
+    fprintf(stderr, "  --cache=STATE  cache state the kernel starts from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M   fault the objects in before initialisation: none, populate or touch (default none)\n");
+    fprintf(stderr, "  --backend=B    runtime that runs the initialisation and the kernel: openmp, pthread or pool (default openmp)\n");
+    fprintf(stderr, "size is the number of objects.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    ObjectLayout layout;
+    if (strcmp(mode, "good") == 0) {
+        layout = LAYOUT_SOA;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        layout = LAYOUT_AOS;
+    } else if (strcmp(mode, "padded") == 0) {
+        layout = LAYOUT_AOS_PADDED;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    int passes = 10;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--passes=", 9) == 0) {
+            passes = atoi(argv[i] + 9);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (passes <= 0) {
+        fprintf(stderr, "Error: --passes must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    ObjectArray objects;
+    init_objects(&objects, layout, size, prefault, num_threads, backend);
+    prepare_objects(&objects, cache, num_threads, backend);
+    fault_phase_report(&faults, "setup");
+
+    fault_phase_begin(&faults);
+    double elapsed = run_kernel(&objects, passes, num_threads, backend);
+    fault_phase_report(&faults, "kernel");
+    int ok = check_objects(&objects, passes, num_threads);
+    unsigned long updates = size * (unsigned long) passes;
+
+    printf("Mode: %s (layout %s, %d passes)\n", mode, layout_name(layout), passes);
+    printf("Size: %lu\n", size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Updates/s: %.0f\n", updates / elapsed);
+    printf("Check: %s\n", ok ? "ok" : "MISMATCH");
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free_objects(&objects);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
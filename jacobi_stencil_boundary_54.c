@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "cache_state.h"
+#include "prefault.h"
+
+// This program demonstrates:
+// - A 2D (5-point) or 3D (7-point) Jacobi stencil over an int grid with row-partitioned threads
+// - good   : row pitch padded to a whole number of cache lines, so every row starts on a new line
+// - bad-fs : odd row pitch, so rows owned by different threads share the cache line at their boundary
+// - halo   : each thread relaxes a private, line-aligned block and copies halo rows from its neighbours
+// - Timing and million lattice updates per second (MLUP/s)
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Number of ints per cache line
+#define INTS_PER_LINE (CACHE_LINE_SIZE / sizeof(int))
+
+// Value held fixed on the first slab (top row / front plane)
+#define BOUNDARY_VALUE 1000
+
+// Grid geometry: n points per dimension, rows of 'pitch' ints, slabs (rows in 2D, planes in 3D)
+// of 'slab' ints. Interior points are 1..n-2 in every dimension.
+typedef struct {
+    int dims;
+    unsigned long n;
+    unsigned long pitch;
+    unsigned long slab;
+} Grid;
+
+void init_grid(Grid *g, int dims, unsigned long n, unsigned long pitch) {
+    g->dims = dims;
+    g->n = n;
+    g->pitch = pitch;
+    g->slab = (dims == 3) ? pitch * n : pitch;
+}
+
+// Function to allocate a cache-line-aligned block of ints, exiting on failure
+int *alloc_ints(unsigned long count) {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, count * sizeof(int)) != 0) {
+        fprintf(stderr, "Memory allocation failed for %lu grid points.\n", count);
+        exit(EXIT_FAILURE);
+    }
+    return (int *) ptr;
+}
+
+// Number of interior rows and the offset of interior row r (3D rows are enumerated plane by plane)
+static inline unsigned long interior_rows(const Grid *g) {
+    return (g->dims == 3) ? (g->n - 2) * (g->n - 2) : g->n - 2;
+}
+
+static inline unsigned long row_offset(const Grid *g, unsigned long r) {
+    if (g->dims == 3) {
+        unsigned long z = 1 + r / (g->n - 2);
+        unsigned long y = 1 + r % (g->n - 2);
+        return z * g->slab + y * g->pitch;
+    }
+    return (1 + r) * g->pitch;
+}
+
+// Function to relax the interior points of the row starting at 'offset'
+static inline void relax_row(int *dst, const int *src, unsigned long offset, const Grid *g) {
+    unsigned long n = g->n, p = g->pitch, s = g->slab;
+    if (g->dims == 3) {
+        for (unsigned long x = 1; x < n - 1; x++) {
+            unsigned long i = offset + x;
+            dst[i] = (src[i - 1] + src[i + 1] + src[i - p] + src[i + p] + src[i - s] + src[i + s]) / 6;
+        }
+    } else {
+        for (unsigned long x = 1; x < n - 1; x++) {
+            unsigned long i = offset + x;
+            dst[i] = (src[i - 1] + src[i + 1] + src[i - p] + src[i + p]) / 4;
+        }
+    }
+}
+
+// Function to relax every interior row of the slab starting at 'offset'
+static inline void relax_slab(int *dst, const int *src, unsigned long offset, const Grid *g) {
+    if (g->dims == 3) {
+        for (unsigned long y = 1; y < g->n - 1; y++) {
+            relax_row(dst, src, offset + y * g->pitch, g);
+        }
+    } else {
+        relax_row(dst, src, offset, g);
+    }
+}
+
+// Function to set the initial condition: first slab held at BOUNDARY_VALUE, everything else zero
+void fill_initial(int *grid, const Grid *g, unsigned long first_slab, unsigned long slabs, unsigned long local_base) {
+    for (unsigned long s = 0; s < slabs; s++) {
+        int value = (first_slab + s == 0) ? BOUNDARY_VALUE : 0;
+        int *slab = grid + (local_base + s) * g->slab;
+        for (unsigned long i = 0; i < g->slab; i++) slab[i] = value;
+    }
+}
+
+// Function to count row boundaries that fall inside a cache line and separate rows owned by
+// different threads under schedule(static, chunk)
+unsigned long shared_boundary_lines(const Grid *g, unsigned long chunk, int num_threads) {
+    unsigned long rows = interior_rows(g);
+    unsigned long count = 0;
+    if (num_threads < 2) return 0;
+    for (unsigned long r = 0; r + 1 < rows; r++) {
+        int owner = (int) ((r / chunk) % num_threads);
+        int next_owner = (int) (((r + 1) / chunk) % num_threads);
+        unsigned long boundary = row_offset(g, r + 1);
+        if (owner != next_owner && (boundary % INTS_PER_LINE) != 0) count++;
+    }
+    return count;
+}
+
+// Function to run the stencil on one shared grid with rows dealt out in chunks of 'chunk' rows.
+// 'faults' began with the setup; the setup and kernel phases are reported here.
+long jacobi_shared(const Grid *g, int iters, unsigned long chunk, int num_threads, CacheState cache,
+                   PrefaultMode prefault, FaultPhase *faults, double *elapsed) {
+    unsigned long total = g->slab * g->n;
+    unsigned long rows = interior_rows(g);
+    int *a = alloc_ints(total);
+    int *b = alloc_ints(total);
+    prefault_range(prefault, a, total, sizeof(int), 1, num_threads, PARTITION_LINE, BACKEND_OPENMP);
+    prefault_range(prefault, b, total, sizeof(int), 1, num_threads, PARTITION_LINE, BACKEND_OPENMP);
+
+    // First touch with the same row schedule the sweeps use
+    fill_initial(a, g, 0, 1, 0);
+    fill_initial(b, g, 0, 1, 0);
+    fill_initial(a, g, g->n - 1, 1, g->n - 1);
+    fill_initial(b, g, g->n - 1, 1, g->n - 1);
+    #pragma omp parallel for schedule(static, chunk)
+    for (unsigned long r = 0; r < rows; r++) {
+        unsigned long off = row_offset(g, r);
+        memset(a + off, 0, g->pitch * sizeof(int));
+        memset(b + off, 0, g->pitch * sizeof(int));
+    }
+    if (g->dims == 3) {
+        // Fill the y boundary rows of every interior plane
+        for (unsigned long z = 1; z < g->n - 1; z++) {
+            memset(a + z * g->slab, 0, g->pitch * sizeof(int));
+            memset(b + z * g->slab, 0, g->pitch * sizeof(int));
+            memset(a + z * g->slab + (g->n - 1) * g->pitch, 0, g->pitch * sizeof(int));
+            memset(b + z * g->slab + (g->n - 1) * g->pitch, 0, g->pitch * sizeof(int));
+        }
+    }
+
+    // Put both grids in the requested cache state
+    CacheRegion regions[] = { { a, total, sizeof(int), 1 }, { b, total, sizeof(int), 1 } };
+    cache_state_prepare(cache, regions, 2, num_threads, PARTITION_LINE, BACKEND_OPENMP);
+    fault_phase_report(faults, "setup");
+    fault_phase_begin(faults);
+
+    double start_time = omp_get_wtime();
+
+    #pragma omp parallel
+    {
+        int *src = a, *dst = b;
+        for (int it = 0; it < iters; it++) {
+            #pragma omp for schedule(static, chunk)
+            for (unsigned long r = 0; r < rows; r++) {
+                relax_row(dst, src, row_offset(g, r), g);
+            }
+            int *temp = src;
+            src = dst;
+            dst = temp;
+        }
+    }
+
+    *elapsed = omp_get_wtime() - start_time;
+    fault_phase_report(faults, "kernel");
+
+    int *result = (iters % 2) ? b : a;
+    long checksum = 0;
+    for (unsigned long r = 0; r < rows; r++) {
+        unsigned long off = row_offset(g, r);
+        for (unsigned long x = 1; x < g->n - 1; x++) checksum += result[off + x];
+    }
+
+    free(a);
+    free(b);
+    return checksum;
+}
+
+// Function to run the stencil with private per-thread blocks and explicit halo exchange.
+// 'faults' began with the setup; the setup and kernel phases are reported here.
+long jacobi_halo(const Grid *g, int iters, int num_threads, CacheState cache, PrefaultMode prefault,
+                 FaultPhase *faults, double *elapsed) {
+    unsigned long interior = g->n - 2;
+    // Two buffers per thread; iteration 'it' reads buf[it % 2] and writes buf[(it + 1) % 2], so a
+    // neighbour's source buffer is never the one it is writing in the same iteration
+    int **buf[2];
+    buf[0] = (int **) malloc(num_threads * sizeof(int *));
+    buf[1] = (int **) malloc(num_threads * sizeof(int *));
+    unsigned long *lo = (unsigned long *) malloc(num_threads * sizeof(unsigned long));
+    unsigned long *hi = (unsigned long *) malloc(num_threads * sizeof(unsigned long));
+    if (!buf[0] || !buf[1] || !lo || !hi) {
+        fprintf(stderr, "Memory allocation failed for halo blocks.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Contiguous block of interior slabs per thread, remainder spread over the first threads
+    for (int t = 0; t < num_threads; t++) {
+        unsigned long base = interior / num_threads, extra = interior % num_threads;
+        lo[t] = 1 + t * base + ((unsigned long) t < extra ? (unsigned long) t : extra);
+        hi[t] = lo[t] + base + ((unsigned long) t < extra ? 1 : 0);
+    }
+
+    // Each thread allocates and first-touches its own block, including both ghost slabs; a
+    // prefault runs on the owning thread alone
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        unsigned long local_slabs = hi[tid] - lo[tid] + 2;
+        buf[0][tid] = alloc_ints(local_slabs * g->slab);
+        buf[1][tid] = alloc_ints(local_slabs * g->slab);
+        prefault_range(prefault, buf[0][tid], local_slabs * g->slab, sizeof(int), 1, 1, PARTITION_LINE, BACKEND_OPENMP);
+        prefault_range(prefault, buf[1][tid], local_slabs * g->slab, sizeof(int), 1, 1, PARTITION_LINE, BACKEND_OPENMP);
+        fill_initial(buf[0][tid], g, lo[tid] - 1, local_slabs, 0);
+        fill_initial(buf[1][tid], g, lo[tid] - 1, local_slabs, 0);
+    }
+
+    // Put every block in the requested cache state on the thread that owns it
+    CacheRegion *regions = (CacheRegion *) malloc(2 * num_threads * sizeof(CacheRegion));
+    if (!regions) {
+        fprintf(stderr, "Memory allocation failed for halo blocks.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        unsigned long count = (hi[t] - lo[t] + 2) * g->slab;
+        regions[t] = (CacheRegion) { buf[0][t], count, sizeof(int), 1 };
+        regions[num_threads + t] = (CacheRegion) { buf[1][t], count, sizeof(int), 1 };
+    }
+    cache_state_prepare_private(cache, regions, 2 * num_threads, num_threads, BACKEND_OPENMP);
+    free(regions);
+    fault_phase_report(faults, "setup");
+    fault_phase_begin(faults);
+
+    long checksum = 0;
+    double start_time = 0.0;
+
+    #pragma omp parallel num_threads(num_threads) reduction(+:checksum)
+    {
+        int tid = omp_get_thread_num();
+        unsigned long owned = hi[tid] - lo[tid];
+
+        #pragma omp master
+        start_time = omp_get_wtime();
+
+        for (int it = 0; it < iters; it++) {
+            int **cur = buf[it % 2], **next = buf[(it + 1) % 2];
+            #pragma omp barrier
+
+            // Pull the neighbours' edge slabs into the ghost slabs (global edges never change)
+            if (owned > 0 && tid > 0 && hi[tid - 1] > lo[tid - 1]) {
+                unsigned long src_slab = hi[tid - 1] - lo[tid - 1];
+                memcpy(cur[tid], cur[tid - 1] + src_slab * g->slab, g->slab * sizeof(int));
+            }
+            if (owned > 0 && tid < num_threads - 1 && hi[tid + 1] > lo[tid + 1]) {
+                memcpy(cur[tid] + (owned + 1) * g->slab, cur[tid + 1] + g->slab, g->slab * sizeof(int));
+            }
+
+            for (unsigned long s = 1; s <= owned; s++) {
+                relax_slab(next[tid], cur[tid], s * g->slab, g);
+            }
+        }
+
+        #pragma omp barrier
+        #pragma omp master
+        *elapsed = omp_get_wtime() - start_time;
+
+        int *result = buf[iters % 2][tid];
+        for (unsigned long s = 1; s <= owned; s++) {
+            if (g->dims == 3) {
+                for (unsigned long y = 1; y < g->n - 1; y++) {
+                    const int *row = result + s * g->slab + y * g->pitch;
+                    for (unsigned long x = 1; x < g->n - 1; x++) checksum += row[x];
+                }
+            } else {
+                const int *row = result + s * g->slab;
+                for (unsigned long x = 1; x < g->n - 1; x++) checksum += row[x];
+            }
+        }
+    }
+    fault_phase_report(faults, "kernel");
+
+    for (int t = 0; t < num_threads; t++) {
+        free(buf[0][t]);
+        free(buf[1][t]);
+    }
+    free(buf[0]);
+    free(buf[1]);
+    free(lo);
+    free(hi);
+    return checksum;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|halo] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good    : row pitch padded to whole cache lines (line-aligned partitions)\n");
+    fprintf(stderr, "  bad-fs  : odd row pitch in ints (partition boundaries share cache lines)\n");
+    fprintf(stderr, "  halo    : private line-aligned blocks per thread with halo-row copies\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --dims=2|3    2D 5-point or 3D 7-point stencil (default 2)\n");
+    fprintf(stderr, "  --iters=N     Jacobi sweeps (default 100)\n");
+    fprintf(stderr, "  --chunk=R     rows per schedule(static, R) chunk in good/bad-fs (default 1)\n");
+    fprintf(stderr, "  --cache=STATE cache state the sweeps start from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M  fault the grids in before initialisation: none, populate or touch (default none)\n");
+    fprintf(stderr, "size is the number of points per dimension.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long N = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "halo") != 0) {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    int dims = 2;
+    int iters = 100;
+    unsigned long chunk = 1;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--dims=", 7) == 0) {
+            dims = atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "--iters=", 8) == 0) {
+            iters = atoi(argv[i] + 8);
+        } else if (strncmp(argv[i], "--chunk=", 8) == 0) {
+            chunk = atol(argv[i] + 8);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (N < 3) {
+        fprintf(stderr, "Error: Size must be at least 3.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if ((dims != 2 && dims != 3) || iters <= 0 || chunk == 0) {
+        fprintf(stderr, "Error: --dims must be 2 or 3, --iters and --chunk must be positive.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    // Row pitch: whole cache lines for good/halo, an odd number of ints for bad-fs
+    unsigned long pitch;
+    if (strcmp(mode, "bad-fs") == 0) {
+        pitch = N | 1;
+    } else {
+        pitch = (N + INTS_PER_LINE - 1) / INTS_PER_LINE * INTS_PER_LINE;
+    }
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    Grid g;
+    init_grid(&g, dims, N, pitch);
+
+    double elapsed = 0.0;
+    long checksum;
+    if (strcmp(mode, "halo") == 0) {
+        checksum = jacobi_halo(&g, iters, num_threads, cache, prefault, &faults, &elapsed);
+    } else {
+        checksum = jacobi_shared(&g, iters, chunk, num_threads, cache, prefault, &faults, &elapsed);
+    }
+
+    unsigned long points = (dims == 3) ? (N - 2) * (N - 2) * (N - 2) : (N - 2) * (N - 2);
+
+    printf("Mode: %s (%dD, pitch %lu ints, %d sweeps)\n", mode, dims, pitch, iters);
+    printf("Size: %lu\n", N);
+    printf("Threads: %d\n", num_threads);
+    cache_state_report(cache);
+    prefault_report(prefault);
+    if (strcmp(mode, "halo") != 0) {
+        printf("Thread Boundaries Inside a Cache Line: %lu per sweep\n", shared_boundary_lines(&g, chunk, num_threads));
+    }
+    printf("Checksum: %ld\n", checksum);
+    printf("MLUP/s: %.2f\n", (double) points * iters / elapsed / 1e6);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,454 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <time.h>
+#include <pthread.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Threads acquiring spinlocks from a striped lock table and updating protected counters
+// - Packed, line-padded, co-located and separated lock/data layouts
+// - Uniform and skewed (Zipf-like) lock selection to separate false sharing from lock contention
+// - Reporting acquisitions/s and the distribution of lock hold times
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Number of precomputed lock indices per thread (ring buffer, power of two)
+#define INDEX_RING_SIZE 4096
+
+// Hold time is sampled on every Nth acquisition to keep timing overhead low
+#define HOLD_SAMPLE_INTERVAL 16
+
+// Number of log2(ns) buckets in the hold-time histogram
+#define HIST_BUCKETS 32
+
+// Lock/data layouts of the striped lock table
+typedef enum {
+    LAYOUT_PACKED,     // locks back-to-back, counters in a separate packed array
+    LAYOUT_PADDED,     // one lock per cache line, counters in a separate packed array
+    LAYOUT_COLOCATED,  // lock and its counter share one padded cache line
+    LAYOUT_SEPARATED   // lock on its own line, counter on its own line in a separate array
+} LockLayout;
+
+// Lock selection distributions
+typedef enum {
+    DIST_UNIFORM,
+    DIST_SKEWED
+} LockDist;
+
+// Lock and counter sharing a single cache line (alignment pads the struct to a full line)
+typedef struct {
+    pthread_spinlock_t lock;
+    unsigned long counter;
+} __attribute__((aligned(CACHE_LINE_SIZE))) ColocatedStripe;
+
+// Per-thread hold-time histogram, padded so the statistics do not false-share
+typedef struct {
+    unsigned long buckets[HIST_BUCKETS];
+    unsigned long samples;
+    unsigned long max_ns;
+} __attribute__((aligned(CACHE_LINE_SIZE))) HoldHistogram;
+
+// Striped lock table: lock i lives at lock_base + i * lock_stride,
+// its counter at counter_base + i * counter_stride
+typedef struct {
+    char *lock_base;
+    char *counter_base;
+    size_t lock_stride;
+    size_t counter_stride;
+    void *lock_alloc;
+    void *counter_alloc;
+    unsigned long num_locks;
+} LockTable;
+
+static inline pthread_spinlock_t *lock_at(LockTable *table, unsigned long i) {
+    return (pthread_spinlock_t *) (table->lock_base + i * table->lock_stride);
+}
+
+static inline unsigned long *counter_at(LockTable *table, unsigned long i) {
+    return (unsigned long *) (table->counter_base + i * table->counter_stride);
+}
+
+// Function to allocate cache-line-aligned memory, prefaulted as requested and zeroed, exiting on failure
+void *alloc_aligned(size_t bytes, const char *what, PrefaultMode prefault, int num_threads, ThreadBackend backend) {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, bytes) != 0) {
+        fprintf(stderr, "Memory allocation failed for %s.\n", what);
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, ptr, bytes, 1, 1, num_threads, PARTITION_LINE, backend);
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+// Function to build the lock table in the requested layout
+void init_lock_table(LockTable *table, unsigned long num_locks, LockLayout layout, PrefaultMode prefault,
+                     int num_threads, ThreadBackend backend) {
+    table->num_locks = num_locks;
+    table->lock_alloc = NULL;
+    table->counter_alloc = NULL;
+
+    switch (layout) {
+    case LAYOUT_PACKED:
+        table->lock_stride = sizeof(pthread_spinlock_t);
+        table->counter_stride = sizeof(unsigned long);
+        break;
+    case LAYOUT_PADDED:
+        table->lock_stride = CACHE_LINE_SIZE;
+        table->counter_stride = sizeof(unsigned long);
+        break;
+    case LAYOUT_COLOCATED:
+        table->lock_stride = sizeof(ColocatedStripe);
+        table->counter_stride = sizeof(ColocatedStripe);
+        break;
+    case LAYOUT_SEPARATED:
+        table->lock_stride = CACHE_LINE_SIZE;
+        table->counter_stride = CACHE_LINE_SIZE;
+        break;
+    }
+
+    if (layout == LAYOUT_COLOCATED) {
+        ColocatedStripe *stripes = (ColocatedStripe *) alloc_aligned(num_locks * sizeof(ColocatedStripe), "lock stripes",
+                                                                 prefault, num_threads, backend);
+        table->lock_alloc = stripes;
+        table->lock_base = (char *) &stripes[0].lock;
+        table->counter_base = (char *) &stripes[0].counter;
+    } else {
+        table->lock_alloc = alloc_aligned(num_locks * table->lock_stride, "locks", prefault, num_threads, backend);
+        table->counter_alloc = alloc_aligned(num_locks * table->counter_stride, "counters", prefault, num_threads,
+                                             backend);
+        table->lock_base = (char *) table->lock_alloc;
+        table->counter_base = (char *) table->counter_alloc;
+    }
+
+    for (unsigned long i = 0; i < num_locks; i++) {
+        pthread_spin_init(lock_at(table, i), PTHREAD_PROCESS_PRIVATE);
+        *counter_at(table, i) = 0;
+    }
+}
+
+// Function to release the lock table
+void free_lock_table(LockTable *table) {
+    for (unsigned long i = 0; i < table->num_locks; i++) {
+        pthread_spin_destroy(lock_at(table, i));
+    }
+    free(table->lock_alloc);
+    free(table->counter_alloc);
+}
+
+// Function to precompute per-thread lock indices (uniform or Zipf with s = 1)
+void build_index_rings(unsigned long *rings, int num_threads, unsigned long num_locks, LockDist dist) {
+    double *cdf = NULL;
+    if (dist == DIST_SKEWED) {
+        cdf = (double *) malloc(num_locks * sizeof(double));
+        if (!cdf) {
+            fprintf(stderr, "Memory allocation failed for skew table.\n");
+            exit(EXIT_FAILURE);
+        }
+        double total = 0.0;
+        for (unsigned long k = 0; k < num_locks; k++) {
+            total += 1.0 / (double) (k + 1);
+            cdf[k] = total;
+        }
+        for (unsigned long k = 0; k < num_locks; k++) {
+            cdf[k] /= total;
+        }
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        unsigned int seed = (unsigned) time(NULL) ^ (unsigned) (t * 2654435761u);
+        for (unsigned long i = 0; i < INDEX_RING_SIZE; i++) {
+            unsigned long idx;
+            if (dist == DIST_UNIFORM) {
+                idx = (unsigned long) rand_r(&seed) % num_locks;
+            } else {
+                double u = (double) rand_r(&seed) / ((double) RAND_MAX + 1.0);
+                unsigned long lo = 0, hi = num_locks - 1;
+                while (lo < hi) {
+                    unsigned long mid = (lo + hi) / 2;
+                    if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+                }
+                idx = lo;
+            }
+            rings[(unsigned long) t * INDEX_RING_SIZE + i] = idx;
+        }
+    }
+
+    free(cdf);
+}
+
+static inline unsigned long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long) ts.tv_sec * 1000000000UL + (unsigned long) ts.tv_nsec;
+}
+
+static inline int log2_bucket(unsigned long ns) {
+    int b = 0;
+    while (ns > 1 && b < HIST_BUCKETS - 1) {
+        ns >>= 1;
+        b++;
+    }
+    return b;
+}
+
+// Shared state of the striped lock workload, handed to the per-thread body on every backend
+typedef struct {
+    LockTable *table;
+    unsigned long *rings;
+    HoldHistogram *hists;
+    unsigned long size;
+    unsigned long hold_work;
+} LockRunContext;
+
+// Per-thread body: 'size' acquisitions from the thread's own index ring
+void striped_locks_body(int tid, int num_threads, void *arg) {
+    (void) num_threads;
+    LockRunContext *ctx = (LockRunContext *) arg;
+    unsigned long *ring = ctx->rings + (unsigned long) tid * INDEX_RING_SIZE;
+    HoldHistogram *hist = &ctx->hists[tid];
+    unsigned long hold_work = ctx->hold_work;
+
+    for (unsigned long i = 0; i < ctx->size; i++) {
+        unsigned long idx = ring[i & (INDEX_RING_SIZE - 1)];
+        pthread_spinlock_t *lock = lock_at(ctx->table, idx);
+        unsigned long *counter = counter_at(ctx->table, idx);
+
+        if ((i % HOLD_SAMPLE_INTERVAL) == 0) {
+            pthread_spin_lock(lock);
+            unsigned long t0 = now_ns();
+            for (unsigned long w = 0; w < hold_work; w++) {
+                (*counter)++;
+            }
+            unsigned long held = now_ns() - t0;
+            pthread_spin_unlock(lock);
+
+            hist->buckets[log2_bucket(held)]++;
+            hist->samples++;
+            if (held > hist->max_ns) hist->max_ns = held;
+        } else {
+            pthread_spin_lock(lock);
+            for (unsigned long w = 0; w < hold_work; w++) {
+                (*counter)++;
+            }
+            pthread_spin_unlock(lock);
+        }
+    }
+}
+
+// Function to run the striped lock workload: each thread performs 'size' acquisitions
+double run_striped_locks(LockTable *table, unsigned long *rings, HoldHistogram *hists,
+                         unsigned long size, int num_threads, unsigned long hold_work, ThreadBackend backend) {
+    LockRunContext ctx = { table, rings, hists, size, hold_work };
+    double start_time = omp_get_wtime();
+    backend_run(backend, num_threads, striped_locks_body, &ctx);
+    return omp_get_wtime() - start_time;
+}
+
+// Function to report the upper bound of the bucket holding the given percentile
+unsigned long hist_percentile(const unsigned long *buckets, unsigned long samples, double pct) {
+    unsigned long target = (unsigned long) (pct * (double) samples);
+    unsigned long seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen > target) return 1UL << (b + 1);
+    }
+    return 1UL << HIST_BUCKETS;
+}
+
+const char *layout_name(LockLayout layout) {
+    switch (layout) {
+    case LAYOUT_PACKED: return "packed";
+    case LAYOUT_PADDED: return "padded";
+    case LAYOUT_COLOCATED: return "colocated";
+    case LAYOUT_SEPARATED: return "separated";
+    }
+    return "unknown";
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|bad-lock] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good     : co-located padded stripes, uniform lock choice\n");
+    fprintf(stderr, "  bad-fs   : packed locks and counters, uniform lock choice (false sharing)\n");
+    fprintf(stderr, "  bad-lock : co-located padded stripes, skewed lock choice (lock contention)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --locks=N                                    number of lock stripes (default 64)\n");
+    fprintf(stderr, "  --layout=packed|padded|colocated|separated   override the mode's layout\n");
+    fprintf(stderr, "  --dist=uniform|skewed                        override the mode's lock choice\n");
+    fprintf(stderr, "  --hold=N                                     counter increments per critical section (default 1)\n");
+    fprintf(stderr, "  --cache=STATE                                cache state the workload starts from: none, warm,\n");
+    fprintf(stderr, "                                               cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=none|populate|touch               fault the allocations in before initialisation (default none)\n");
+    fprintf(stderr, "  --backend=openmp|pthread|pool                runtime that runs the parallel region (default openmp)\n");
+    fprintf(stderr, "size is the number of acquisitions per thread.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode and derive its default layout and distribution
+    LockLayout layout;
+    LockDist dist;
+    if (strcmp(mode, "good") == 0) {
+        layout = LAYOUT_COLOCATED;
+        dist = DIST_UNIFORM;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        layout = LAYOUT_PACKED;
+        dist = DIST_UNIFORM;
+    } else if (strcmp(mode, "bad-lock") == 0) {
+        layout = LAYOUT_COLOCATED;
+        dist = DIST_SKEWED;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    unsigned long num_locks = 64;
+    unsigned long hold_work = 1;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--locks=", 8) == 0) {
+            num_locks = atol(argv[i] + 8);
+        } else if (strcmp(argv[i], "--layout=packed") == 0) {
+            layout = LAYOUT_PACKED;
+        } else if (strcmp(argv[i], "--layout=padded") == 0) {
+            layout = LAYOUT_PADDED;
+        } else if (strcmp(argv[i], "--layout=colocated") == 0) {
+            layout = LAYOUT_COLOCATED;
+        } else if (strcmp(argv[i], "--layout=separated") == 0) {
+            layout = LAYOUT_SEPARATED;
+        } else if (strcmp(argv[i], "--dist=uniform") == 0) {
+            dist = DIST_UNIFORM;
+        } else if (strcmp(argv[i], "--dist=skewed") == 0) {
+            dist = DIST_SKEWED;
+        } else if (strncmp(argv[i], "--hold=", 7) == 0) {
+            hold_work = atol(argv[i] + 7);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and lock count
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_locks == 0) {
+        fprintf(stderr, "Error: Number of locks must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    LockTable table;
+    init_lock_table(&table, num_locks, layout, prefault, num_threads, backend);
+
+    unsigned long *rings = (unsigned long *) malloc((unsigned long) num_threads * INDEX_RING_SIZE * sizeof(unsigned long));
+    if (!rings) {
+        fprintf(stderr, "Memory allocation failed for lock index rings.\n");
+        free_lock_table(&table);
+        return EXIT_FAILURE;
+    }
+    prefault_range(prefault, rings, (unsigned long) num_threads * INDEX_RING_SIZE, sizeof(unsigned long), 1,
+                   num_threads, PARTITION_LINE, backend);
+    build_index_rings(rings, num_threads, num_locks, dist);
+
+    HoldHistogram *hists = (HoldHistogram *) alloc_aligned(num_threads * sizeof(HoldHistogram), "hold histograms",
+                                                           prefault, num_threads, backend);
+
+    // Put the lock table, the index rings and the histograms in the requested cache state
+    CacheRegion regions[4];
+    int num_regions = 0;
+    regions[num_regions++] = (CacheRegion) { table.lock_alloc, num_locks, table.lock_stride, 1 };
+    if (table.counter_alloc) {
+        regions[num_regions++] = (CacheRegion) { table.counter_alloc, num_locks, table.counter_stride, 1 };
+    }
+    regions[num_regions++] = (CacheRegion) { rings, (unsigned long) num_threads * INDEX_RING_SIZE, sizeof(unsigned long), 0 };
+    regions[num_regions++] = (CacheRegion) { hists, (unsigned long) num_threads, sizeof(HoldHistogram), 1 };
+    cache_state_prepare(cache, regions, num_regions, num_threads, PARTITION_LINE, backend);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+
+    double elapsed = run_striped_locks(&table, rings, hists, size, num_threads, hold_work, backend);
+    fault_phase_report(&faults, "kernel");
+
+    // Verify the protected counters and merge the hold-time histograms
+    unsigned long total = 0;
+    for (unsigned long i = 0; i < num_locks; i++) {
+        total += *counter_at(&table, i);
+    }
+    unsigned long expected = (unsigned long) num_threads * size * hold_work;
+
+    unsigned long merged[HIST_BUCKETS] = {0};
+    unsigned long samples = 0, max_ns = 0;
+    for (int t = 0; t < num_threads; t++) {
+        for (int b = 0; b < HIST_BUCKETS; b++) merged[b] += hists[t].buckets[b];
+        samples += hists[t].samples;
+        if (hists[t].max_ns > max_ns) max_ns = hists[t].max_ns;
+    }
+
+    unsigned long acquisitions = (unsigned long) num_threads * size;
+    printf("Mode: %s (layout %s, %s lock choice, %lu locks)\n", mode, layout_name(layout),
+           dist == DIST_UNIFORM ? "uniform" : "skewed", num_locks);
+    printf("Size: %lu\n", size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Counter Total: %lu (%s)\n", total, total == expected ? "ok" : "MISMATCH");
+    printf("Acquisitions: %lu\n", acquisitions);
+    printf("Acquisitions/s: %.0f\n", acquisitions / elapsed);
+    printf("Hold Time p50/p90/p99 (ns, bucket bound): %lu / %lu / %lu\n",
+           hist_percentile(merged, samples, 0.50),
+           hist_percentile(merged, samples, 0.90),
+           hist_percentile(merged, samples, 0.99));
+    printf("Hold Time max: %lu ns (%lu samples)\n", max_ns, samples);
+    printf("Hold Time Histogram (ns):");
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        if (merged[b]) printf(" [<%lu]=%lu", 1UL << (b + 1), merged[b]);
+    }
+    printf("\n");
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    // Free allocated memory
+    free(hists);
+    free(rings);
+    free_lock_table(&table);
+
+    return total == expected ? EXIT_SUCCESS : EXIT_FAILURE;
+}
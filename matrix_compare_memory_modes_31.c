@@ -3,32 +3,61 @@
 #include <string.h>
 #include <omp.h>
 #include <time.h>
+#include "partition.h"
+#include "mmap_input.h"
+#include "tasking.h"
+#include "thread_backend.h"
+#include "mem_order.h"
+#include "cache_state.h"
+#include "prefault.h"
 
 // Define cache line size for padding (typically 64 bytes)
 #define CACHE_LINE_SIZE 64
 
+// Elements per task for --tasking
+#define DEFAULT_TASK_GRAIN 16384
+
 // Structure to prevent false sharing by padding
 typedef struct {
     unsigned long diff_count;
     char padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
 } PaddedDiff;
 
-// Function to initialize the matrices with sequential values and introduce differences
-void initialize_matrices(unsigned long *A, unsigned long *B, unsigned long size) {
-    // Initialize both matrices with the same values
-    #pragma omp parallel for schedule(static)
-    for (unsigned long i = 0; i < size; i++) {
-        A[i] = i % 100;
-        B[i] = A[i];
+// Shared state of a comparison kernel, handed to the per-thread body on every backend
+typedef struct {
+    unsigned long *A;
+    unsigned long *B;
+    unsigned long *shuffled_indices;
+    unsigned long size;
+    PartitionPolicy policy;
+    PaddedDiff *padded_diffs;
+    unsigned long *packed_diffs;
+    MemOrder order;
+} CompareContext;
+
+// Per-thread body of initialize_matrices: the same values in both matrices over the thread's static
+// chunk (with the numa policy, the range it will later compare, so each thread first-touches its
+// own pages), then a difference in B at every 1000th element
+void initialize_body(int tid, int num_threads, void *arg) {
+    CompareContext *ctx = (CompareContext *) arg;
+    unsigned long start, end;
+    if (ctx->policy == PARTITION_NUMA) {
+        partition_range(ctx->A, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+    } else {
+        backend_static_range(ctx->size, num_threads, tid, &start, &end);
     }
-
-    // Introduce differences in B: every 1000th element differs
-    #pragma omp parallel for schedule(static)
-    for (unsigned long i = 0; i < size; i += 1000) {
-        B[i] = A[i] + 1;
+    for (unsigned long i = start; i < end; i++) {
+        ctx->A[i] = i % 100;
+        ctx->B[i] = (i % 1000 == 0) ? ctx->A[i] + 1 : ctx->A[i];
     }
 }
 
+// Function to initialize the matrices on the kernel's threading backend
+void initialize_matrices(unsigned long *A, unsigned long *B, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend) {
+    CompareContext ctx = { .A = A, .B = B, .size = size, .policy = policy };
+    backend_run(backend, num_threads, initialize_body, &ctx);
+}
+
 // Function to shuffle an array of indices for random access
 void shuffle_indices(unsigned long *indices, unsigned long size) {
     srand((unsigned)time(NULL));
@@ -40,8 +69,54 @@ void shuffle_indices(unsigned long *indices, unsigned long size) {
     }
 }
 
+// Per-thread body of 'good' mode: count the thread's differences into its own padded slot
+void compare_good_body(int tid, int num_threads, void *arg) {
+    CompareContext *ctx = (CompareContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->A, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    unsigned long i;
+    MEM_ORDER_ACCUMULATE(ctx->order, &ctx->padded_diffs[tid].diff_count, i, start, end, ctx->A[i] != ctx->B[i], 1);
+}
+
+// Per-thread body of 'bad-fs' mode: count the thread's differences into a packed, shared-line slot
+void compare_bad_fs_body(int tid, int num_threads, void *arg) {
+    CompareContext *ctx = (CompareContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->A, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    unsigned long i;
+    MEM_ORDER_ACCUMULATE(ctx->order, &ctx->packed_diffs[tid], i, start, end, ctx->A[i] != ctx->B[i], 1);
+}
+
+// Per-thread body of 'bad-ma' mode: compare through the thread's range of shuffled indices
+void compare_bad_ma_body(int tid, int num_threads, void *arg) {
+    CompareContext *ctx = (CompareContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->shuffled_indices, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    for (unsigned long i = start; i < end; i++) {
+        unsigned long idx = ctx->shuffled_indices[i];
+        if (ctx->A[idx] != ctx->B[idx]) {
+            ctx->padded_diffs[tid].diff_count++;
+        }
+    }
+}
+
+// Per-thread body of 'bad-both' mode: compare through the thread's range of shuffled indices,
+// counting into a packed, shared-line slot (false sharing and random access at once)
+void compare_bad_both_body(int tid, int num_threads, void *arg) {
+    CompareContext *ctx = (CompareContext *) arg;
+    unsigned long start, end;
+    partition_range(ctx->shuffled_indices, ctx->size, sizeof(unsigned long), ctx->policy, num_threads, tid, &start, &end);
+
+    unsigned long i;
+    MEM_ORDER_ACCUMULATE(ctx->order, &ctx->packed_diffs[tid], i, start, end,
+                         ctx->A[ctx->shuffled_indices[i]] != ctx->B[ctx->shuffled_indices[i]], 1);
+}
+
 // Function to perform the matrix comparison in 'good' mode (no false sharing, linear access)
-unsigned long compare_good(unsigned long *A, unsigned long *B, unsigned long size, int num_threads) {
+unsigned long compare_good(unsigned long *A, unsigned long *B, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend, MemOrder order) {
     unsigned long total_diffs = 0;
 
     // Allocate per-thread difference counts with padding to prevent false sharing
@@ -59,19 +134,8 @@ unsigned long compare_good(unsigned long *A, unsigned long *B, unsigned long siz
     double start_time = omp_get_wtime();
 
     // Perform the matrix comparison
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        unsigned long chunk_size = size / num_threads;
-        unsigned long start = tid * chunk_size;
-        unsigned long end = (tid == num_threads - 1) ? size : start + chunk_size;
-
-        for (unsigned long i = start; i < end; i++) {
-            if (A[i] != B[i]) {
-                partial_diffs[tid].diff_count++;
-            }
-        }
-    }
+    CompareContext ctx = { A, B, NULL, size, policy, partial_diffs, NULL, order };
+    backend_run(backend, num_threads, compare_good_body, &ctx);
 
     // Aggregate the partial difference counts
     for (int i = 0; i < num_threads; i++) {
@@ -81,13 +145,14 @@ unsigned long compare_good(unsigned long *A, unsigned long *B, unsigned long siz
     double end_time = omp_get_wtime();
     printf("Good Mode - Total Differences: %lu\n", total_diffs);
     printf("Good Mode - Execution Time: %f seconds\n", end_time - start_time);
+    mem_order_report(order, "Good Mode", size, end_time - start_time, total_diffs, (size + 999) / 1000);
 
     free(partial_diffs);
     return total_diffs;
 }
 
 // Function to perform the matrix comparison in 'bad-fs' mode (with false sharing, linear access)
-unsigned long compare_bad_fs(unsigned long *A, unsigned long *B, unsigned long size, int num_threads) {
+unsigned long compare_bad_fs(unsigned long *A, unsigned long *B, unsigned long size, int num_threads, PartitionPolicy policy, ThreadBackend backend, MemOrder order) {
     unsigned long total_diffs = 0;
 
     // Allocate per-thread difference counts without padding to introduce false sharing
@@ -105,19 +170,8 @@ unsigned long compare_bad_fs(unsigned long *A, unsigned long *B, unsigned long s
     double start_time = omp_get_wtime();
 
     // Perform the matrix comparison
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        unsigned long chunk_size = size / num_threads;
-        unsigned long start = tid * chunk_size;
-        unsigned long end = (tid == num_threads - 1) ? size : start + chunk_size;
-
-        for (unsigned long i = start; i < end; i++) {
-            if (A[i] != B[i]) {
-                partial_diffs[tid]++;
-            }
-        }
-    }
+    CompareContext ctx = { A, B, NULL, size, policy, NULL, partial_diffs, order };
+    backend_run(backend, num_threads, compare_bad_fs_body, &ctx);
 
     // Aggregate the partial difference counts
     for (int i = 0; i < num_threads; i++) {
@@ -127,13 +181,14 @@ unsigned long compare_bad_fs(unsigned long *A, unsigned long *B, unsigned long s
     double end_time = omp_get_wtime();
     printf("Bad-FS Mode - Total Differences: %lu\n", total_diffs);
     printf("Bad-FS Mode - Execution Time: %f seconds\n", end_time - start_time);
+    mem_order_report(order, "Bad-FS Mode", size, end_time - start_time, total_diffs, (size + 999) / 1000);
 
     free(partial_diffs);
     return total_diffs;
 }
 
 // Function to perform the matrix comparison in 'bad-ma' mode (inefficient memory access, random access)
-unsigned long compare_bad_ma(unsigned long *A, unsigned long *B, unsigned long size, int num_threads, unsigned long *shuffled_indices){
+unsigned long compare_bad_ma(unsigned long *A, unsigned long *B, unsigned long size, int num_threads, unsigned long *shuffled_indices, PartitionPolicy policy, ThreadBackend backend){
     unsigned long total_diffs = 0;
 
     // Allocate per-thread difference counts with padding to prevent false sharing
@@ -151,20 +206,8 @@ unsigned long compare_bad_ma(unsigned long *A, unsigned long *B, unsigned long s
     double start_time = omp_get_wtime();
 
     // Perform the matrix comparison with random access
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        unsigned long chunk_size = size / num_threads;
-        unsigned long start = tid * chunk_size;
-        unsigned long end = (tid == num_threads - 1) ? size : start + chunk_size;
-
-        for(unsigned long i = start; i < end; i++) {
-            unsigned long idx = shuffled_indices[i];
-            if (A[idx] != B[idx]) {
-                partial_diffs[tid].diff_count++;
-            }
-        }
-    }
+    CompareContext ctx = { A, B, shuffled_indices, size, policy, partial_diffs, NULL, MEM_ORDER_PLAIN };
+    backend_run(backend, num_threads, compare_bad_ma_body, &ctx);
 
     // Aggregate the partial difference counts
     for(int i=0; i<num_threads; i++) {
@@ -179,9 +222,96 @@ unsigned long compare_bad_ma(unsigned long *A, unsigned long *B, unsigned long s
     return total_diffs;
 }
 
+// Function to perform the matrix comparison in 'bad-both' mode (with false sharing, random access)
+unsigned long compare_bad_both(unsigned long *A, unsigned long *B, unsigned long size, int num_threads, unsigned long *shuffled_indices, PartitionPolicy policy, ThreadBackend backend, MemOrder order) {
+    unsigned long total_diffs = 0;
+
+    // Allocate per-thread difference counts without padding to introduce false sharing
+    unsigned long *partial_diffs = (unsigned long *) malloc(num_threads * sizeof(unsigned long));
+    if (!partial_diffs) {
+        fprintf(stderr, "Memory allocation failed for partial_diffs in bad-both mode.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Initialize partial difference counts
+    for (int i = 0; i < num_threads; i++) {
+        partial_diffs[i] = 0;
+    }
+
+    double start_time = omp_get_wtime();
+
+    // Perform the matrix comparison with random access into packed slots
+    CompareContext ctx = { A, B, shuffled_indices, size, policy, NULL, partial_diffs, order };
+    backend_run(backend, num_threads, compare_bad_both_body, &ctx);
+
+    // Aggregate the partial difference counts
+    for (int i = 0; i < num_threads; i++) {
+        total_diffs += partial_diffs[i];
+    }
+
+    double end_time = omp_get_wtime();
+    printf("Bad-Both Mode (Packed Slots, Random Access) - Total Differences: %lu\n", total_diffs);
+    printf("Bad-Both Mode (Packed Slots, Random Access) - Execution Time: %f seconds\n", end_time - start_time);
+    mem_order_report(order, "Bad-Both Mode", size, end_time - start_time, total_diffs, (size + 999) / 1000);
+
+    free(partial_diffs);
+    return total_diffs;
+}
+
+// Context of the task-based comparison: shuffled_indices is NULL for linear access
+typedef struct {
+    unsigned long *A;
+    unsigned long *B;
+    unsigned long *shuffled_indices;
+    TaskSlots *slots;
+} CompareTaskContext;
+
+// Task body: count differing elements in [start, end) into the task's own result slot
+void compare_task_body(unsigned long task, unsigned long start, unsigned long end, void *ctx) {
+    CompareTaskContext *c = (CompareTaskContext *) ctx;
+    unsigned long *slot = task_slot(c->slots, task);
+    if (c->shuffled_indices) {
+        for (unsigned long i = start; i < end; i++) {
+            unsigned long idx = c->shuffled_indices[i];
+            if (c->A[idx] != c->B[idx]) {
+                (*slot)++;
+            }
+        }
+    } else {
+        for (unsigned long i = start; i < end; i++) {
+            if (c->A[i] != c->B[i]) {
+                (*slot)++;
+            }
+        }
+    }
+}
+
+// Function to perform the matrix comparison with tasks (taskloop or recursive), one result slot per task.
+// 'padded' selects padded slots (good, bad-ma) or packed slots (bad-fs, bad-both).
+unsigned long compare_tasks(unsigned long *A, unsigned long *B, unsigned long size, unsigned long *shuffled_indices,
+                            int padded, const TaskingConfig *tasking, const char *label) {
+    TaskSlots slots;
+    task_slots_init(&slots, tasking_num_tasks(tasking, size), padded);
+    CompareTaskContext ctx = { A, B, shuffled_indices, &slots };
+
+    double start_time = omp_get_wtime();
+    tasking_run(tasking, size, &slots, compare_task_body, &ctx);
+    unsigned long total_diffs = task_slots_sum(&slots);
+    double end_time = omp_get_wtime();
+
+    printf("Tasking: %s (grain %lu, %lu tasks, %s slots)\n", tasking_mode_name(tasking->mode),
+           tasking->grain, slots.count, padded ? "padded" : "packed");
+    printf("Adjacent Tasks on Different Threads: %.1f%%\n", 100.0 * task_slots_owner_switches(&slots));
+    printf("%s - Total Differences: %lu\n", label, total_diffs);
+    printf("%s - Execution Time: %f seconds\n", label, end_time - start_time);
+
+    task_slots_free(&slots);
+    return total_diffs;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
-        fprintf(stderr, "Usage: %s [good|bad-fs|bad-ma] [size] [threads]\n", argv[0]);
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s [good|bad-fs|bad-ma|bad-both] [size] [threads] [--partition=naive|line|page|numa] [--input=path [--madvise=normal|sequential|random|willneed] [--drop-cache]] [--tasking=none|taskloop|recursive [--grain=N] | --backend=openmp|pthread|pool [--order=plain|store|relaxed|seq_cst|cas]] [--cache=none|warm|cold-stream|cold-flush|mixed] [--prefault=none|populate|touch]\n", argv[0]);
         return EXIT_FAILURE;
     }
 
@@ -191,9 +321,50 @@ int main(int argc, char *argv[]) {
     int num_threads = atoi(argv[3]);
 
     // Validate mode
-    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "bad-ma") != 0) {
+    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-fs") != 0 && strcmp(mode, "bad-ma") != 0 && strcmp(mode, "bad-both") != 0) {
         fprintf(stderr, "Invalid mode: %s\n", mode);
-        fprintf(stderr, "Valid modes are: good, bad-fs, bad-ma\n");
+        fprintf(stderr, "Valid modes are: good, bad-fs, bad-ma, bad-both\n");
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    PartitionPolicy policy = PARTITION_LINE;
+    MmapInput input;
+    mmap_input_init(&input);
+    TaskingConfig tasking = { TASKING_NONE, DEFAULT_TASK_GRAIN };
+    ThreadBackend backend = BACKEND_OPENMP;
+    MemOrder order = MEM_ORDER_PLAIN;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    for (int i = 4; i < argc; i++) {
+        int parsed = partition_parse_option(argv[i], &policy);
+        if (parsed == 0) parsed = mmap_input_parse_option(argv[i], &input);
+        if (parsed == 0) parsed = tasking_parse_option(argv[i], &tasking);
+        if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+        if (parsed == 0) parsed = mem_order_parse_option(argv[i], &order);
+        if (parsed == 0) parsed = cache_state_parse_option(argv[i], &cache);
+        if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+        if (parsed == 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        if (parsed < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (mmap_input_check(&input) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (tasking.mode != TASKING_NONE && backend != BACKEND_OPENMP) {
+        fprintf(stderr, "Error: --tasking requires --backend=openmp.\n");
+        return EXIT_FAILURE;
+    }
+    if (order != MEM_ORDER_PLAIN && strcmp(mode, "bad-ma") == 0) {
+        fprintf(stderr, "Error: --order applies to the good, bad-fs and bad-both modes only.\n");
+        return EXIT_FAILURE;
+    }
+    if (order != MEM_ORDER_PLAIN && tasking.mode != TASKING_NONE) {
+        fprintf(stderr, "Error: --order cannot be combined with --tasking.\n");
         return EXIT_FAILURE;
     }
 
@@ -213,49 +384,111 @@ int main(int argc, char *argv[]) {
     // Calculate total number of elements
     unsigned long total_elements = N * N;
 
-    // Allocate memory for the matrices
-    unsigned long *A = (unsigned long *) malloc(total_elements * sizeof(unsigned long));
-    unsigned long *B = (unsigned long *) malloc(total_elements * sizeof(unsigned long));
-    if (!A || !B) {
-        fprintf(stderr, "Memory allocation failed for matrices.\n");
-        free(A);
-        free(B);
-        return EXIT_FAILURE;
-    }
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    // Allocate memory for the matrices, or map both from the input file (A followed by B)
+    unsigned long *A = NULL;
+    unsigned long *B = NULL;
+    if (input.path) {
+        int needs_fill = 0;
+        A = (unsigned long *) mmap_input_open(&input, "mc_31", "u64 A[i] = i % 100, then B (A + 1 every 1000)",
+                                              2 * total_elements, sizeof(unsigned long), &needs_fill);
+        if (needs_fill) initialize_matrices(A, A + total_elements, total_elements, num_threads, policy, backend);
+        A = (unsigned long *) mmap_input_ready(&input);
+        B = A + total_elements;
+        prefault_range(prefault, A, total_elements, sizeof(unsigned long), 0, num_threads, policy, backend);
+        prefault_range(prefault, B, total_elements, sizeof(unsigned long), 0, num_threads, policy, backend);
+    } else {
+        A = (unsigned long *) malloc(total_elements * sizeof(unsigned long));
+        B = (unsigned long *) malloc(total_elements * sizeof(unsigned long));
+        if (!A || !B) {
+            fprintf(stderr, "Memory allocation failed for matrices.\n");
+            free(A);
+            free(B);
+            return EXIT_FAILURE;
+        }
+        prefault_range(prefault, A, total_elements, sizeof(unsigned long), 1, num_threads, policy, backend);
+        prefault_range(prefault, B, total_elements, sizeof(unsigned long), 1, num_threads, policy, backend);
 
-    // Initialize the matrices and introduce differences
-    initialize_matrices(A, B, total_elements);
+        // Initialize the matrices and introduce differences
+        initialize_matrices(A, B, total_elements, num_threads, policy, backend);
+    }
 
-    // Prepare shuffled indices for 'bad-ma' mode
+    // Prepare shuffled indices for 'bad-ma' and 'bad-both' modes
     unsigned long *shuffled_indices = NULL;
-    if (strcmp(mode, "bad-ma") == 0) {
+    if (strcmp(mode, "bad-ma") == 0 || strcmp(mode, "bad-both") == 0) {
         shuffled_indices = (unsigned long*) malloc(total_elements * sizeof(unsigned long));
         if (!shuffled_indices) {
-            fprintf(stderr, "Memory allocation failed for shuffled_indices in bad-ma mode.\n");
-            free(A);
-            free(B);
+            fprintf(stderr, "Memory allocation failed for shuffled_indices in %s mode.\n", mode);
+            if (input.path) {
+                mmap_input_close(&input);
+            } else {
+                free(A);
+                free(B);
+            }
             return EXIT_FAILURE;
         }
+        prefault_range(prefault, shuffled_indices, total_elements, sizeof(unsigned long), 1, num_threads, policy, backend);
         for (unsigned long i = 0; i < total_elements; i++) {
             shuffled_indices[i] = i;
         }
         shuffle_indices(shuffled_indices, total_elements);
     }
 
+    printf("Partition: %s\n", partition_policy_name(policy));
+    printf("Backend: %s\n", backend_name(backend));
+
+    // Put both matrices (and the shuffled indices) in the requested cache state, in the kernel's own partition
+    CacheRegion regions[] = { { A, total_elements, sizeof(unsigned long), 0 },
+                              { B, total_elements, sizeof(unsigned long), 0 },
+                              { shuffled_indices, total_elements, sizeof(unsigned long), 0 } };
+    cache_state_prepare(cache, regions, shuffled_indices ? 3 : 2, num_threads, policy, backend);
+    cache_state_report(cache);
+    prefault_report(prefault);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+    if (input.path) {
+        mmap_input_begin(&input);
+    }
+
     // Perform the matrix comparison based on the mode
-    if (strcmp(mode, "good") == 0) {
-        compare_good(A, B, total_elements, num_threads);
+    if (tasking.mode != TASKING_NONE) {
+        if (strcmp(mode, "good") == 0) {
+            compare_tasks(A, B, total_elements, NULL, 1, &tasking, "Good Mode");
+        } else if (strcmp(mode, "bad-fs") == 0) {
+            compare_tasks(A, B, total_elements, NULL, 0, &tasking, "Bad-FS Mode");
+        } else if (strcmp(mode, "bad-both") == 0) {
+            compare_tasks(A, B, total_elements, shuffled_indices, 0, &tasking, "Bad-Both Mode (Packed Slots, Random Access)");
+        } else {
+            compare_tasks(A, B, total_elements, shuffled_indices, 1, &tasking, "Bad-MA Mode (Random Access)");
+        }
+    }
+    else if (strcmp(mode, "good") == 0) {
+        compare_good(A, B, total_elements, num_threads, policy, backend, order);
     }
     else if (strcmp(mode, "bad-fs") == 0) {
-        compare_bad_fs(A, B, total_elements, num_threads);
+        compare_bad_fs(A, B, total_elements, num_threads, policy, backend, order);
     }
     else if (strcmp(mode, "bad-ma") == 0) {
-        compare_bad_ma(A, B, total_elements, num_threads, shuffled_indices);
+        compare_bad_ma(A, B, total_elements, num_threads, shuffled_indices, policy, backend);
+    }
+    else if (strcmp(mode, "bad-both") == 0) {
+        compare_bad_both(A, B, total_elements, num_threads, shuffled_indices, policy, backend, order);
+    }
+    fault_phase_report(&faults, "kernel");
+
+    if (input.path) {
+        mmap_input_report(&input);
     }
 
     // Free allocated memory
-    free(A);
-    free(B);
+    if (input.path) {
+        mmap_input_close(&input);
+    } else {
+        free(A);
+        free(B);
+    }
     if (shuffled_indices) free(shuffled_indices);
 
     return EXIT_SUCCESS;
@@ -2,44 +2,112 @@
 #include <stdio.h>
 #include <string.h>
 #include <omp.h>
+#include "tasking.h"
+#include "thread_backend.h"
+#include "cache_state.h"
+#include "prefault.h"
 
-// Good mode: Efficient initialization without false sharing or inefficient access
-void good_mode(int **a, int N, int threads) {
-    #pragma omp parallel for num_threads(threads) schedule(static)
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            a[i][j] = 17;
+// Rows (or columns in bad-ma mode) per task for --tasking
+#define DEFAULT_TASK_GRAIN 1
+
+// Matrix handed to the per-thread bodies on every backend
+typedef struct {
+    int **a;
+    int N;
+} InitContext;
+
+// Good mode body: static block of rows, each written row-major
+void good_body(int tid, int threads, void *arg) {
+    InitContext *ctx = (InitContext *) arg;
+    unsigned long start, end;
+    backend_static_range((unsigned long) ctx->N, threads, tid, &start, &end);
+    for (int i = (int) start; i < (int) end; i++) {
+        for (int j = 0; j < ctx->N; j++) {
+            ctx->a[i][j] = 17;
         }
     }
 }
 
+// Bad-fs mode body: static block of columns, each thread writing every threads-th row of them
+void bad_fs_body(int tid, int threads, void *arg) {
+    InitContext *ctx = (InitContext *) arg;
+    unsigned long start, end;
+    backend_static_range((unsigned long) ctx->N, threads, tid, &start, &end);
+    for (int i = (int) start; i < (int) end; i++) {
+        for (int j = tid; j < ctx->N; j += threads) {
+            ctx->a[j][i] = 17 + tid; // Introduce thread-specific writes to simulate false sharing
+        }
+    }
+}
 
-// Modified Bad-fs mode: Initializes all rows with potential false sharing
-void bad_fs_mode(int **a, int N, int threads) {
-    #pragma omp parallel for num_threads(threads) schedule(static)
-    for (int i = 0; i < N; i++) {
-        int tid = omp_get_thread_num();
-        for (int j = tid; j < N; j += threads) {
-            a[j][i] = 17 + tid; // Introduce thread-specific writes to simulate false sharing
+// Bad-ma mode body: static block of columns, each written top to bottom
+void bad_ma_body(int tid, int threads, void *arg) {
+    InitContext *ctx = (InitContext *) arg;
+    unsigned long start, end;
+    backend_static_range((unsigned long) ctx->N, threads, tid, &start, &end);
+    for (int j = (int) start; j < (int) end; j++) { // Column-major order
+        for (int i = 0; i < ctx->N; i++) {
+            ctx->a[i][j] = 17;
         }
     }
 }
 
+// Good mode: Efficient initialization without false sharing or inefficient access
+void good_mode(int **a, int N, int threads, ThreadBackend backend) {
+    InitContext ctx = { a, N };
+    backend_run(backend, threads, good_body, &ctx);
+}
+
+
+// Modified Bad-fs mode: Initializes all rows with potential false sharing
+void bad_fs_mode(int **a, int N, int threads, ThreadBackend backend) {
+    InitContext ctx = { a, N };
+    backend_run(backend, threads, bad_fs_body, &ctx);
+}
+
 
 // Bad-ma mode: Simulates inefficient memory access by initializing in column-major order
-void bad_ma_mode(int **a, int N, int threads) {
-    #pragma omp parallel for num_threads(threads) schedule(static)
-    for (int j = 0; j < N; j++) { // Column-major order
-        for (int i = 0; i < N; i++) {
-            a[i][j] = 17;
+void bad_ma_mode(int **a, int N, int threads, ThreadBackend backend) {
+    InitContext ctx = { a, N };
+    backend_run(backend, threads, bad_ma_body, &ctx);
+}
+
+// Context of the task-based initialization
+typedef struct {
+    int **a;
+    int N;
+    int column_major;
+    TaskSlots *slots;
+} InitTaskContext;
+
+// Task body: initialize rows [start, end) (columns in column-major order), counting written
+// elements in the task's own result slot
+void init_task_body(unsigned long task, unsigned long start, unsigned long end, void *ctx) {
+    InitTaskContext *c = (InitTaskContext *) ctx;
+    unsigned long *slot = task_slot(c->slots, task);
+    for (unsigned long k = start; k < end; k++) {
+        for (int m = 0; m < c->N; m++) {
+            if (c->column_major) {
+                c->a[m][k] = 17;
+            } else {
+                c->a[k][m] = 17;
+            }
+            (*slot)++;
         }
     }
 }
 
+// Task mode: rows (good, bad-fs) or columns (bad-ma) split into tasks, one result slot per task
+// in 'slots' (allocated by the caller, padded for good/bad-ma and packed for bad-fs)
+void task_mode(int **a, int N, int column_major, TaskSlots *slots, const TaskingConfig *tasking) {
+    InitTaskContext ctx = { a, N, column_major, slots };
+    tasking_run(tasking, (unsigned long) N, slots, init_task_body, &ctx);
+}
+
 int main(int argc, char *argv[]) {
     if (argc < 4) {
         fprintf(stderr, "Usage:\n");
-        fprintf(stderr, "       ./program <mode> <N> <threads>\n");
+        fprintf(stderr, "       ./program <mode> <N> <threads> [--tasking=none|taskloop|recursive [--grain=rows] | --backend=openmp|pthread|pool] [--cache=none|warm|cold-stream|cold-flush|mixed] [--prefault=none|populate|touch]\n");
         fprintf(stderr, "Modes:\n");
         fprintf(stderr, "  good    : no false sharing, no bad memory access\n");
         fprintf(stderr, "  bad-fs  : with false sharing\n");
@@ -61,6 +129,35 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Parse optional arguments
+    TaskingConfig tasking = { TASKING_NONE, DEFAULT_TASK_GRAIN };
+    ThreadBackend backend = BACKEND_OPENMP;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    for (int i = 4; i < argc; i++) {
+        int parsed = tasking_parse_option(argv[i], &tasking);
+        if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+        if (parsed == 0) parsed = cache_state_parse_option(argv[i], &cache);
+        if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+        if (parsed == 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+        }
+        if (parsed <= 0) {
+            return 1;
+        }
+    }
+    if (tasking.mode != TASKING_NONE && backend != BACKEND_OPENMP) {
+        fprintf(stderr, "Error: --tasking requires --backend=openmp.\n");
+        return 1;
+    }
+    if (N <= 0 || threads <= 0) {
+        fprintf(stderr, "Error: N and threads must be positive integers.\n");
+        return 1;
+    }
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
     // Allocate memory for the 2D array as a single contiguous block to enhance cache line sharing
     int **a = (int **)malloc(sizeof(int*) * N);
     if (!a){
@@ -75,22 +172,53 @@ int main(int argc, char *argv[]) {
         free(a);
         return 1;
     }
+    // Without --prefault the matrix is first touched inside the timed kernel
+    prefault_range(prefault, a_block, (unsigned long) N * N, sizeof(int), 1, threads, PARTITION_LINE, backend);
 
     // Assign row pointers to the contiguous block
     for (int i = 0; i < N; i++) {
         a[i] = a_block + i * N;
     }
 
+    TaskSlots slots;
+    if (tasking.mode != TASKING_NONE) {
+        omp_set_num_threads(threads);
+        task_slots_init(&slots, tasking_num_tasks(&tasking, (unsigned long) N), strcmp(mode, "bad-fs") != 0);
+    }
+
+    printf("Backend: %s\n", backend_name(backend));
+
+    // Put the matrix in the requested cache state. The kernel writes it, so the touch writes too and
+    // faults its pages in; without --cache the first touch happens inside the timed kernel.
+    CacheRegion regions[] = { { a_block, (unsigned long) N * N, sizeof(int), 1 },
+                              { a, (unsigned long) N, sizeof(int *), 0 } };
+    cache_state_prepare(cache, regions, 2, threads, PARTITION_LINE, backend);
+    cache_state_report(cache);
+    prefault_report(prefault);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+
     // Execute the selected mode
     double start_time = omp_get_wtime();
-    if (strcmp(mode, "good") == 0) {
-        good_mode(a, N, threads);
+    if (tasking.mode != TASKING_NONE) {
+        task_mode(a, N, strcmp(mode, "bad-ma") == 0, &slots, &tasking);
+    } else if (strcmp(mode, "good") == 0) {
+        good_mode(a, N, threads, backend);
     } else if (strcmp(mode, "bad-fs") == 0) {
-        bad_fs_mode(a, N, threads);
+        bad_fs_mode(a, N, threads, backend);
     } else if (strcmp(mode, "bad-ma") == 0) {
-        bad_ma_mode(a, N, threads);
+        bad_ma_mode(a, N, threads, backend);
     }
     double end_time = omp_get_wtime();
+    fault_phase_report(&faults, "kernel");
+
+    if (tasking.mode != TASKING_NONE) {
+        printf("Tasking: %s (grain %lu, %lu tasks, %s slots)\n", tasking_mode_name(tasking.mode),
+               tasking.grain, slots.count, strcmp(mode, "bad-fs") != 0 ? "padded" : "packed");
+        printf("Adjacent Tasks on Different Threads: %.1f%%\n", 100.0 * task_slots_owner_switches(&slots));
+        printf("Elements Written: %lu\n", task_slots_sum(&slots));
+        task_slots_free(&slots);
+    }
 
     // Validate and print results
     if (N > 17){
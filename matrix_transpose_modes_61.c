@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Out-of-place transpose B = A^T of an N x N float matrix: one side contiguous, the other strided
+// - Naive, tiled (with a tile-size autotuner), recursive cache-oblivious and SIMD 4 x 4
+//   in-register variants
+// - A false-sharing variant where threads own interleaved destination columns
+// - Reporting GB/s (one read and one write of the matrix)
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Leaf edge below which the recursive variant copies directly
+#define RECURSIVE_LEAF 32
+
+// Sub-problems above this many elements are spawned as tasks
+#define RECURSIVE_TASK_CUTOFF (256 * 256)
+
+// Outer block edge used around the 4 x 4 SIMD kernel
+#define SIMD_BLOCK 32
+
+// Tile edges tried by the autotuner
+static const unsigned long tile_candidates[] = { 8, 16, 32, 64, 128 };
+#define NUM_TILE_CANDIDATES (sizeof(tile_candidates) / sizeof(tile_candidates[0]))
+
+typedef enum {
+    VARIANT_NAIVE,       // rows of A split into contiguous blocks, B written down columns
+    VARIANT_INTERLEAVED, // rows of A (destination columns) dealt round-robin to threads
+    VARIANT_TILED,       // square tiles, both sides stay cache-resident
+    VARIANT_RECURSIVE,   // split the longer side in half until a small leaf
+    VARIANT_SIMD         // 4 x 4 blocks transposed in SSE registers
+} Variant;
+
+// Function to allocate an N x N matrix aligned to a cache line
+float *alloc_matrix(unsigned long n) {
+    float *m = NULL;
+    if (posix_memalign((void **) &m, CACHE_LINE_SIZE, n * n * sizeof(float)) != 0) {
+        fprintf(stderr, "Memory allocation failed for a %lu x %lu matrix.\n", n, n);
+        exit(EXIT_FAILURE);
+    }
+    return m;
+}
+
+// Shared state of the initialisation and the transposes, handed to the per-thread body on every backend
+typedef struct {
+    float *A;
+    float *B;
+    unsigned long n;
+    unsigned long tile;
+} TransposeContext;
+
+// Per-thread body: fill the thread's rows of A with distinct values and clear them in B
+void initialize_body(int tid, int num_threads, void *arg) {
+    TransposeContext *ctx = (TransposeContext *) arg;
+    unsigned long n = ctx->n;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        for (unsigned long j = 0; j < n; j++) {
+            ctx->A[i * n + j] = (float) ((i * n + j) % 1000003);
+            ctx->B[i * n + j] = 0.0f;
+        }
+    }
+}
+
+// Function to fill A with distinct values and clear B
+void initialize_matrices(float *A, float *B, unsigned long n, int num_threads, ThreadBackend backend) {
+    TransposeContext ctx = { A, B, n, 0 };
+    backend_run(backend, num_threads, initialize_body, &ctx);
+}
+
+// Per-thread body of the naive transpose: rows of A split into contiguous blocks
+void naive_body(int tid, int num_threads, void *arg) {
+    TransposeContext *ctx = (TransposeContext *) arg;
+    const float *A = ctx->A;
+    float *B = ctx->B;
+    unsigned long n = ctx->n;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        for (unsigned long j = 0; j < n; j++) {
+            B[j * n + i] = A[i * n + j];
+        }
+    }
+}
+
+// Per-thread body of the interleaved transpose: rows of A dealt round-robin (schedule(static, 1))
+void interleaved_body(int tid, int num_threads, void *arg) {
+    TransposeContext *ctx = (TransposeContext *) arg;
+    const float *A = ctx->A;
+    float *B = ctx->B;
+    unsigned long n = ctx->n;
+    for (unsigned long i = (unsigned long) tid; i < n; i += (unsigned long) num_threads) {
+        for (unsigned long j = 0; j < n; j++) {
+            B[j * n + i] = A[i * n + j];
+        }
+    }
+}
+
+void transpose_naive(const float *A, float *B, unsigned long n, int interleaved, int num_threads,
+                     ThreadBackend backend) {
+    TransposeContext ctx = { (float *) A, B, n, 0 };
+    backend_run(backend, num_threads, interleaved ? interleaved_body : naive_body, &ctx);
+}
+
+// Per-thread body of the tiled transpose: the tile grid flattened row-major and split into
+// contiguous blocks, as collapse(2) schedule(static) does
+void tiled_body(int tid, int num_threads, void *arg) {
+    TransposeContext *ctx = (TransposeContext *) arg;
+    const float *A = ctx->A;
+    float *B = ctx->B;
+    unsigned long n = ctx->n, tile = ctx->tile;
+    unsigned long tiles = (n + tile - 1) / tile;
+    unsigned long start, end;
+    backend_static_range(tiles * tiles, num_threads, tid, &start, &end);
+    for (unsigned long t = start; t < end; t++) {
+        unsigned long ii = (t / tiles) * tile;
+        unsigned long jj = (t % tiles) * tile;
+        unsigned long i_end = (ii + tile < n) ? ii + tile : n;
+        unsigned long j_end = (jj + tile < n) ? jj + tile : n;
+        for (unsigned long i = ii; i < i_end; i++) {
+            for (unsigned long j = jj; j < j_end; j++) {
+                B[j * n + i] = A[i * n + j];
+            }
+        }
+    }
+}
+
+void transpose_tiled(const float *A, float *B, unsigned long n, unsigned long tile, int num_threads,
+                     ThreadBackend backend) {
+    TransposeContext ctx = { (float *) A, B, n, tile };
+    backend_run(backend, num_threads, tiled_body, &ctx);
+}
+
+// Function to transpose rows [i0, i1) x columns [j0, j1) of A by halving the longer side
+void transpose_recursive_block(const float *A, float *B, unsigned long n,
+                               unsigned long i0, unsigned long i1, unsigned long j0, unsigned long j1) {
+    unsigned long rows = i1 - i0, cols = j1 - j0;
+    if (rows <= RECURSIVE_LEAF && cols <= RECURSIVE_LEAF) {
+        for (unsigned long i = i0; i < i1; i++) {
+            for (unsigned long j = j0; j < j1; j++) {
+                B[j * n + i] = A[i * n + j];
+            }
+        }
+        return;
+    }
+
+    int spawn = rows * cols > RECURSIVE_TASK_CUTOFF;
+    if (rows >= cols) {
+        unsigned long mid = i0 + rows / 2;
+        #pragma omp task if(spawn)
+        transpose_recursive_block(A, B, n, i0, mid, j0, j1);
+        transpose_recursive_block(A, B, n, mid, i1, j0, j1);
+    } else {
+        unsigned long mid = j0 + cols / 2;
+        #pragma omp task if(spawn)
+        transpose_recursive_block(A, B, n, i0, i1, j0, mid);
+        transpose_recursive_block(A, B, n, i0, i1, mid, j1);
+    }
+    #pragma omp taskwait
+}
+
+// Function to run the recursive transpose as OpenMP tasks (OpenMP backend only)
+void transpose_recursive(const float *A, float *B, unsigned long n) {
+    #pragma omp parallel
+    {
+        #pragma omp single
+        transpose_recursive_block(A, B, n, 0, n, 0, n);
+    }
+}
+
+// Function to transpose the 4 x 4 block at row i, column j of A into B
+static inline void transpose_4x4(const float *A, float *B, unsigned long n, unsigned long i, unsigned long j) {
+#ifdef __SSE__
+    __m128 r0 = _mm_loadu_ps(&A[i * n + j]);
+    __m128 r1 = _mm_loadu_ps(&A[(i + 1) * n + j]);
+    __m128 r2 = _mm_loadu_ps(&A[(i + 2) * n + j]);
+    __m128 r3 = _mm_loadu_ps(&A[(i + 3) * n + j]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(&B[j * n + i], r0);
+    _mm_storeu_ps(&B[(j + 1) * n + i], r1);
+    _mm_storeu_ps(&B[(j + 2) * n + i], r2);
+    _mm_storeu_ps(&B[(j + 3) * n + i], r3);
+#else
+    // Portable fallback: same access pattern, one element at a time
+    for (unsigned long r = 0; r < 4; r++) {
+        for (unsigned long c = 0; c < 4; c++) {
+            B[(j + c) * n + i + r] = A[(i + r) * n + j + c];
+        }
+    }
+#endif
+}
+
+// Per-thread body of the SIMD transpose: the SIMD_BLOCK grid over the 4-aligned part, flattened
+// and split as collapse(2) schedule(static) does
+void simd_body(int tid, int num_threads, void *arg) {
+    TransposeContext *ctx = (TransposeContext *) arg;
+    const float *A = ctx->A;
+    float *B = ctx->B;
+    unsigned long n = ctx->n;
+    unsigned long n4 = n - n % 4;
+    unsigned long blocks = (n4 + SIMD_BLOCK - 1) / SIMD_BLOCK;
+    unsigned long start, end;
+    backend_static_range(blocks * blocks, num_threads, tid, &start, &end);
+    for (unsigned long t = start; t < end; t++) {
+        unsigned long ii = (t / blocks) * SIMD_BLOCK;
+        unsigned long jj = (t % blocks) * SIMD_BLOCK;
+        unsigned long i_end = (ii + SIMD_BLOCK < n4) ? ii + SIMD_BLOCK : n4;
+        unsigned long j_end = (jj + SIMD_BLOCK < n4) ? jj + SIMD_BLOCK : n4;
+        for (unsigned long i = ii; i < i_end; i += 4) {
+            for (unsigned long j = jj; j < j_end; j += 4) {
+                transpose_4x4(A, B, n, i, j);
+            }
+        }
+    }
+}
+
+// Per-thread body of the SIMD transpose's ragged right columns and bottom rows
+void simd_edge_body(int tid, int num_threads, void *arg) {
+    TransposeContext *ctx = (TransposeContext *) arg;
+    const float *A = ctx->A;
+    float *B = ctx->B;
+    unsigned long n = ctx->n;
+    unsigned long n4 = n - n % 4;
+    unsigned long start, end;
+    backend_static_range(n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        unsigned long j_start = (i < n4) ? n4 : 0;
+        for (unsigned long j = j_start; j < n; j++) {
+            B[j * n + i] = A[i * n + j];
+        }
+    }
+}
+
+void transpose_simd(const float *A, float *B, unsigned long n, int num_threads, ThreadBackend backend) {
+    TransposeContext ctx = { (float *) A, B, n, 0 };
+    backend_run(backend, num_threads, simd_body, &ctx);
+    backend_run(backend, num_threads, simd_edge_body, &ctx);
+}
+
+// Function to time one tiled transpose per candidate tile and return the fastest tile
+unsigned long autotune_tile(const float *A, float *B, unsigned long n, int num_threads, ThreadBackend backend) {
+    unsigned long best_tile = tile_candidates[0];
+    double best_time = 0.0;
+    printf("Autotune:");
+    for (unsigned long c = 0; c < NUM_TILE_CANDIDATES; c++) {
+        double start_time = omp_get_wtime();
+        transpose_tiled(A, B, n, tile_candidates[c], num_threads, backend);
+        double t = omp_get_wtime() - start_time;
+        printf(" %lu=%.6fs", tile_candidates[c], t);
+        if (c == 0 || t < best_time) {
+            best_time = t;
+            best_tile = tile_candidates[c];
+        }
+    }
+    printf("\n");
+    return best_tile;
+}
+
+// Function to check every element of B against A
+int verify_transpose(const float *A, const float *B, unsigned long n) {
+    for (unsigned long i = 0; i < n; i++) {
+        for (unsigned long j = 0; j < n; j++) {
+            if (B[j * n + i] != A[i * n + j]) return 0;
+        }
+    }
+    return 1;
+}
+
+const char *variant_name(Variant variant) {
+    switch (variant) {
+    case VARIANT_NAIVE: return "naive";
+    case VARIANT_INTERLEAVED: return "naive, interleaved destination columns";
+    case VARIANT_TILED: return "tiled";
+    case VARIANT_RECURSIVE: return "recursive cache-oblivious";
+#ifdef __SSE__
+    case VARIANT_SIMD: return "SSE 4x4 in-register";
+#else
+    case VARIANT_SIMD: return "4x4 blocks, scalar fallback";
+#endif
+    }
+    return "unknown";
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|bad-ma|recursive|simd] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good      : tiled transpose\n");
+    fprintf(stderr, "  bad-fs    : naive, destination columns interleaved across threads (false sharing)\n");
+    fprintf(stderr, "  bad-ma    : naive, contiguous row blocks per thread (strided writes)\n");
+    fprintf(stderr, "  recursive : cache-oblivious recursive halving\n");
+    fprintf(stderr, "  simd      : 4 x 4 blocks transposed in registers\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --tile=auto|B  tile edge for good mode; auto times 8..128 first (default auto)\n");
+    fprintf(stderr, "  --cache=STATE  cache state the transpose starts from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M   fault the matrices in before initialisation: none, populate or touch (default none)\n");
+    fprintf(stderr, "  --backend=B    runtime that runs the initialisation and the transpose: openmp, pthread or pool\n");
+    fprintf(stderr, "                 (default openmp; recursive mode requires openmp)\n");
+    fprintf(stderr, "size is the matrix dimension N.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    Variant variant;
+    if (strcmp(mode, "good") == 0) {
+        variant = VARIANT_TILED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        variant = VARIANT_INTERLEAVED;
+    } else if (strcmp(mode, "bad-ma") == 0) {
+        variant = VARIANT_NAIVE;
+    } else if (strcmp(mode, "recursive") == 0) {
+        variant = VARIANT_RECURSIVE;
+    } else if (strcmp(mode, "simd") == 0) {
+        variant = VARIANT_SIMD;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments (tile 0 = autotune)
+    unsigned long tile = 0;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--tile=auto") == 0) {
+            tile = 0;
+        } else if (strncmp(argv[i], "--tile=", 7) == 0) {
+            tile = atol(argv[i] + 7);
+            if (tile == 0) {
+                fprintf(stderr, "Error: --tile must be auto or a positive integer.\n");
+                return EXIT_FAILURE;
+            }
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size and threads
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (variant == VARIANT_RECURSIVE && backend != BACKEND_OPENMP) {
+        fprintf(stderr, "Error: recursive mode runs as OpenMP tasks and requires --backend=openmp.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    float *A = alloc_matrix(size);
+    float *B = alloc_matrix(size);
+    prefault_range(prefault, A, size * size, sizeof(float), 1, num_threads, PARTITION_LINE, backend);
+    prefault_range(prefault, B, size * size, sizeof(float), 1, num_threads, PARTITION_LINE, backend);
+    initialize_matrices(A, B, size, num_threads, backend);
+
+    if (variant == VARIANT_TILED && tile == 0) {
+        tile = autotune_tile(A, B, size, num_threads, backend);
+    }
+
+    // Put both matrices in the requested cache state (after autotuning, which touches them)
+    CacheRegion regions[] = { { A, size * size, sizeof(float), 0 }, { B, size * size, sizeof(float), 1 } };
+    cache_state_prepare(cache, regions, 2, num_threads, PARTITION_LINE, backend);
+    fault_phase_report(&faults, "setup");
+
+    fault_phase_begin(&faults);
+    double start_time = omp_get_wtime();
+
+    switch (variant) {
+    case VARIANT_NAIVE:
+        transpose_naive(A, B, size, 0, num_threads, backend);
+        break;
+    case VARIANT_INTERLEAVED:
+        transpose_naive(A, B, size, 1, num_threads, backend);
+        break;
+    case VARIANT_TILED:
+        transpose_tiled(A, B, size, tile, num_threads, backend);
+        break;
+    case VARIANT_RECURSIVE:
+        transpose_recursive(A, B, size);
+        break;
+    case VARIANT_SIMD:
+        transpose_simd(A, B, size, num_threads, backend);
+        break;
+    }
+
+    double end_time = omp_get_wtime();
+    fault_phase_report(&faults, "kernel");
+    double elapsed = end_time - start_time;
+    int ok = verify_transpose(A, B, size);
+    double bytes = 2.0 * (double) size * (double) size * sizeof(float);
+
+    if (variant == VARIANT_TILED) {
+        printf("Mode: %s (%s, %lu x %lu tiles)\n", mode, variant_name(variant), tile, tile);
+    } else {
+        printf("Mode: %s (%s)\n", mode, variant_name(variant));
+    }
+    printf("Size: %lu x %lu\n", size, size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Result Check: %s\n", ok ? "ok" : "MISMATCH");
+    printf("Bandwidth: %.3f GB/s\n", bytes / elapsed / 1e9);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(A);
+    free(B);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,109 @@
+#ifndef MEM_ORDER_H
+#define MEM_ORDER_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Memory-ordering variants of a per-thread counter update.
+//
+// The hand-split kernels accumulate into one counter slot per thread, padded (good) or packed
+// (bad-fs). --order selects how each update is issued:
+//   plain   - ordinary load/add/store (the original code)
+//   store   - C11 relaxed atomic load, then relaxed atomic store (no read-modify-write)
+//   relaxed - atomic_fetch_add with memory_order_relaxed
+//   seq_cst - atomic_fetch_add with memory_order_seq_cst
+//   cas     - compare-exchange loop (lock cmpxchg on x86)
+// On x86 both fetch_add orders compile to a lock-prefixed xadd; seq_cst additionally stops the
+// compiler from reordering or merging the updates. Each slot has a single writer, so every order
+// yields the same totals; the cost difference is the price of the ordering itself.
+
+typedef enum {
+    MEM_ORDER_PLAIN,
+    MEM_ORDER_STORE,
+    MEM_ORDER_RELAXED,
+    MEM_ORDER_SEQ_CST,
+    MEM_ORDER_CAS
+} MemOrder;
+
+static inline const char *mem_order_name(MemOrder order) {
+    switch (order) {
+    case MEM_ORDER_PLAIN: return "plain";
+    case MEM_ORDER_STORE: return "store";
+    case MEM_ORDER_RELAXED: return "relaxed";
+    case MEM_ORDER_SEQ_CST: return "seq_cst";
+    case MEM_ORDER_CAS: return "cas";
+    }
+    return "unknown";
+}
+
+// Function to parse an --order=<name> argument.
+// Returns 1 if the argument was consumed, 0 if it is not an order option, -1 if invalid.
+static inline int mem_order_parse_option(const char *arg, MemOrder *order) {
+    if (strncmp(arg, "--order=", 8) != 0) return 0;
+    const char *value = arg + 8;
+    if (strcmp(value, "plain") == 0) *order = MEM_ORDER_PLAIN;
+    else if (strcmp(value, "store") == 0) *order = MEM_ORDER_STORE;
+    else if (strcmp(value, "relaxed") == 0) *order = MEM_ORDER_RELAXED;
+    else if (strcmp(value, "seq_cst") == 0) *order = MEM_ORDER_SEQ_CST;
+    else if (strcmp(value, "cas") == 0) *order = MEM_ORDER_CAS;
+    else {
+        fprintf(stderr, "Invalid memory order: %s (expected plain, store, relaxed, seq_cst or cas)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+// Loop 'i' over [start, end) and, where 'cond' holds, add 'value' to the unsigned long counter
+// at 'slot' with the given order. The switch sits outside the loop so every variant is a tight
+// loop of its own update. 'cond' and 'value' are expressions evaluated per iteration.
+#define MEM_ORDER_ACCUMULATE(order, slot, i, start, end, cond, value)                            \
+    do {                                                                                          \
+        unsigned long *mo_plain_ = (slot);                                                        \
+        _Atomic unsigned long *mo_slot_ = (_Atomic unsigned long *) mo_plain_;                    \
+        switch (order) {                                                                          \
+        case MEM_ORDER_PLAIN:                                                                     \
+            for (i = (start); i < (end); i++)                                                     \
+                if (cond) *mo_plain_ += (value);                                                  \
+            break;                                                                                \
+        case MEM_ORDER_STORE:                                                                     \
+            for (i = (start); i < (end); i++)                                                     \
+                if (cond) atomic_store_explicit(mo_slot_,                                         \
+                        atomic_load_explicit(mo_slot_, memory_order_relaxed) + (value),           \
+                        memory_order_relaxed);                                                    \
+            break;                                                                                \
+        case MEM_ORDER_RELAXED:                                                                   \
+            for (i = (start); i < (end); i++)                                                     \
+                if (cond) atomic_fetch_add_explicit(mo_slot_, (value), memory_order_relaxed);     \
+            break;                                                                                \
+        case MEM_ORDER_SEQ_CST:                                                                   \
+            for (i = (start); i < (end); i++)                                                     \
+                if (cond) atomic_fetch_add_explicit(mo_slot_, (value), memory_order_seq_cst);     \
+            break;                                                                                \
+        case MEM_ORDER_CAS:                                                                       \
+            for (i = (start); i < (end); i++) {                                                   \
+                if (cond) {                                                                       \
+                    unsigned long mo_old_ = atomic_load_explicit(mo_slot_, memory_order_relaxed); \
+                    while (!atomic_compare_exchange_weak_explicit(mo_slot_, &mo_old_,             \
+                            mo_old_ + (value), memory_order_seq_cst, memory_order_relaxed))       \
+                        ;                                                                         \
+                }                                                                                 \
+            }                                                                                     \
+            break;                                                                                \
+        }                                                                                         \
+    } while (0)
+
+// Function to print the order, update throughput and the counter total against its expected value
+static inline void mem_order_report(MemOrder order, const char *label, unsigned long elements,
+                                    double seconds, unsigned long total, unsigned long expected) {
+    printf("%s - Memory Order: %s\n", label, mem_order_name(order));
+    printf("%s - Throughput: %.2f M elements/s\n", label, seconds > 0 ? elements / seconds / 1e6 : 0.0);
+    if (total == expected) {
+        printf("%s - Counter Check: ok\n", label);
+    } else {
+        printf("%s - Counter Check: MISMATCH (expected %lu, difference %ld)\n", label, expected,
+               (long) (total - expected));
+    }
+}
+
+#endif // MEM_ORDER_H
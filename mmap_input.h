@@ -0,0 +1,271 @@
+#ifndef MMAP_INPUT_H
+#define MMAP_INPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+// File-backed input for the array kernels.
+//
+// With --input=<path> the program's arrays live in a private mapping of that file instead of
+// malloc'ed memory. A missing file is created and filled once by the program's own initialisation
+// through a shared mapping, so later runs read it back from disk or the page cache. The private
+// mapping keeps any writes the kernel makes out of the file.
+//
+// The data follows a one-page header (magic, program, layout, element count, fill complete), so
+// a file is only reused by the same program with the same layout and size. An input file written
+// for another size, program or layout, or whose fill was interrupted, is refilled; a file
+// without the header is not ours and is rejected rather than overwritten.
+//
+// --madvise applies a hint to the mapping, --drop-cache evicts the file from the page cache
+// before the run, and the report gives page faults and block I/O wait of the kernel alone.
+
+typedef enum {
+    MMAP_HINT_NORMAL,
+    MMAP_HINT_SEQUENTIAL,
+    MMAP_HINT_RANDOM,
+    MMAP_HINT_WILLNEED
+} MmapHint;
+
+typedef struct {
+    const char *path;        // NULL: input is not file-backed
+    MmapHint hint;
+    int drop_cache;
+    int fd;
+    void *addr;              // start of the mapping (the header)
+    size_t length;           // data bytes after the header
+    int shared;              // addr is the shared fill mapping rather than the private one
+    long minflt_before;
+    long majflt_before;
+    unsigned long iowait_ticks_before;
+} MmapInput;
+
+// Define the header size: one page, so the data stays page-aligned
+#define MMAP_INPUT_HEADER_SIZE 4096
+#define MMAP_INPUT_MAGIC "HPCFSIN1"
+
+// Header at the start of every input file
+typedef struct {
+    char magic[8];
+    char program[32];
+    char layout[64];
+    unsigned long elements;
+    unsigned long complete;  // set once the fill has been flushed
+} MmapInputHeader;
+
+static inline const char *mmap_hint_name(MmapHint hint) {
+    switch (hint) {
+    case MMAP_HINT_NORMAL: return "normal";
+    case MMAP_HINT_SEQUENTIAL: return "sequential";
+    case MMAP_HINT_RANDOM: return "random";
+    case MMAP_HINT_WILLNEED: return "willneed";
+    }
+    return "unknown";
+}
+
+static inline void mmap_input_init(MmapInput *in) {
+    memset(in, 0, sizeof(*in));
+    in->hint = MMAP_HINT_NORMAL;
+    in->fd = -1;
+}
+
+// Function to parse --input=<path>, --madvise=<hint> and --drop-cache.
+// Returns 1 if the argument was consumed, 0 if it is not an input option, -1 if invalid.
+static inline int mmap_input_parse_option(const char *arg, MmapInput *in) {
+    if (strncmp(arg, "--input=", 8) == 0) {
+        if (arg[8] == '\0') {
+            fprintf(stderr, "Invalid input path: empty\n");
+            return -1;
+        }
+        in->path = arg + 8;
+        return 1;
+    }
+    if (strcmp(arg, "--drop-cache") == 0) {
+        in->drop_cache = 1;
+        return 1;
+    }
+    if (strncmp(arg, "--madvise=", 10) != 0) return 0;
+    const char *value = arg + 10;
+    if (strcmp(value, "normal") == 0) in->hint = MMAP_HINT_NORMAL;
+    else if (strcmp(value, "sequential") == 0) in->hint = MMAP_HINT_SEQUENTIAL;
+    else if (strcmp(value, "random") == 0) in->hint = MMAP_HINT_RANDOM;
+    else if (strcmp(value, "willneed") == 0) in->hint = MMAP_HINT_WILLNEED;
+    else {
+        fprintf(stderr, "Invalid madvise hint: %s (expected normal, sequential, random or willneed)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+// Function to reject --madvise/--drop-cache without --input. Returns 0 if valid, -1 otherwise.
+static inline int mmap_input_check(const MmapInput *in) {
+    if (!in->path && (in->hint != MMAP_HINT_NORMAL || in->drop_cache)) {
+        fprintf(stderr, "Error: --madvise and --drop-cache require --input=<path>.\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to read the cumulative block I/O delay of this process (field 42 of /proc/self/stat).
+// Stays 0 unless the kernel has delay accounting enabled.
+static inline unsigned long mmap_input_iowait_ticks(void) {
+    char buf[1024];
+    FILE *f = fopen("/proc/self/stat", "r");
+    if (!f) return 0;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    // The command name (field 2) may contain spaces; count fields after its closing parenthesis
+    char *p = strrchr(buf, ')');
+    if (!p) return 0;
+    int field = 2;
+    unsigned long ticks = 0;
+    for (char *tok = strtok(p + 1, " "); tok; tok = strtok(NULL, " ")) {
+        if (++field == 42) {
+            ticks = strtoul(tok, NULL, 10);
+            break;
+        }
+    }
+    return ticks;
+}
+
+// Function to build the header expected for this program, layout and element count
+static inline void mmap_input_header(MmapInputHeader *header, const char *program, const char *layout,
+                                     unsigned long elements) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, MMAP_INPUT_MAGIC, sizeof(header->magic));
+    strncpy(header->program, program, sizeof(header->program) - 1);
+    strncpy(header->layout, layout, sizeof(header->layout) - 1);
+    header->elements = elements;
+    header->complete = 1;
+}
+
+// Function to open the input file for 'elements' elements of 'elem_size' bytes, written by
+// 'program' in 'layout' (a short description of what the fill stores). Returns a writable shared
+// mapping of the data when *needs_fill is set, in which case the caller fills it and then calls
+// mmap_input_ready(); otherwise call mmap_input_ready() directly.
+static inline void *mmap_input_open(MmapInput *in, const char *program, const char *layout,
+                                    unsigned long elements, size_t elem_size, int *needs_fill) {
+    size_t bytes = elements * elem_size;
+    size_t file_bytes = MMAP_INPUT_HEADER_SIZE + bytes;
+    *needs_fill = 0;
+    in->length = bytes;
+    in->fd = open(in->path, O_RDWR | O_CREAT, 0644);
+    if (in->fd < 0) {
+        perror(in->path);
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat st;
+    if (fstat(in->fd, &st) != 0) {
+        perror(in->path);
+        exit(EXIT_FAILURE);
+    }
+
+    MmapInputHeader expected, found;
+    mmap_input_header(&expected, program, layout, elements);
+    if (st.st_size > 0) {
+        memset(&found, 0, sizeof(found));
+        if (pread(in->fd, &found, sizeof(found), 0) != (ssize_t) sizeof(found) ||
+            memcmp(found.magic, MMAP_INPUT_MAGIC, sizeof(found.magic)) != 0) {
+            fprintf(stderr, "Error: %s is not an input file written by these programs; refusing to overwrite it.\n", in->path);
+            exit(EXIT_FAILURE);
+        }
+        if ((size_t) st.st_size == file_bytes && memcmp(&found, &expected, sizeof(found)) == 0) return NULL;
+        fprintf(stderr, "Note: %s holds %s (%s, %lu elements%s); refilling it for %s (%s, %lu elements).\n", in->path,
+                found.program, found.layout, found.elements, found.complete ? "" : ", incomplete",
+                program, layout, elements);
+    }
+
+    // Mark the file incomplete until the fill has been flushed, then size it exactly
+    expected.complete = 0;
+    if (ftruncate(in->fd, 0) != 0 || ftruncate(in->fd, (off_t) file_bytes) != 0 ||
+        pwrite(in->fd, &expected, sizeof(expected), 0) != (ssize_t) sizeof(expected)) {
+        perror(in->path);
+        exit(EXIT_FAILURE);
+    }
+    in->addr = mmap(NULL, file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, in->fd, 0);
+    if (in->addr == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    in->shared = 1;
+    *needs_fill = 1;
+    return (char *) in->addr + MMAP_INPUT_HEADER_SIZE;
+}
+
+// Function to take the page-fault and I/O wait baselines of the report. Called right before the
+// kernel, after any prefault and cache warm-up, so the report covers the kernel only.
+static inline void mmap_input_begin(MmapInput *in) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    in->minflt_before = usage.ru_minflt;
+    in->majflt_before = usage.ru_majflt;
+    in->iowait_ticks_before = mmap_input_iowait_ticks();
+}
+
+// Function to flush any fill (marking the file complete), optionally drop the page cache, and map
+// the file privately. Returns the data after the header.
+static inline void *mmap_input_ready(MmapInput *in) {
+    size_t file_bytes = MMAP_INPUT_HEADER_SIZE + in->length;
+    if (in->shared) {
+        MmapInputHeader *header = (MmapInputHeader *) in->addr;
+        msync(in->addr, file_bytes, MS_SYNC);
+        header->complete = 1;
+        msync(in->addr, MMAP_INPUT_HEADER_SIZE, MS_SYNC);
+        munmap(in->addr, file_bytes);
+        in->shared = 0;
+    }
+    if (in->drop_cache) {
+        // Dirty or mapped pages are not dropped, hence the sync and the unmap above
+        fdatasync(in->fd);
+        posix_fadvise(in->fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    in->addr = mmap(NULL, file_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, in->fd, 0);
+    if (in->addr == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    int advice = MADV_NORMAL;
+    switch (in->hint) {
+    case MMAP_HINT_NORMAL: advice = MADV_NORMAL; break;
+    case MMAP_HINT_SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+    case MMAP_HINT_RANDOM: advice = MADV_RANDOM; break;
+    case MMAP_HINT_WILLNEED: advice = MADV_WILLNEED; break;
+    }
+    madvise(in->addr, file_bytes, advice);
+
+    mmap_input_begin(in);
+    return (char *) in->addr + MMAP_INPUT_HEADER_SIZE;
+}
+
+// Function to print the input description, page faults and I/O wait since mmap_input_begin()
+static inline void mmap_input_report(const MmapInput *in) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    unsigned long iowait = mmap_input_iowait_ticks() - in->iowait_ticks_before;
+
+    printf("Input: %s (%zu bytes, madvise %s%s)\n", in->path, in->length, mmap_hint_name(in->hint),
+           in->drop_cache ? ", page cache dropped" : "");
+    printf("Page Faults: minor %ld, major %ld\n", usage.ru_minflt - in->minflt_before,
+           usage.ru_majflt - in->majflt_before);
+    printf("I/O Wait: %f seconds\n", (double) iowait / (double) sysconf(_SC_CLK_TCK));
+}
+
+// Function to unmap and close the input file
+static inline void mmap_input_close(MmapInput *in) {
+    if (in->addr && in->addr != MAP_FAILED) munmap(in->addr, MMAP_INPUT_HEADER_SIZE + in->length);
+    if (in->fd >= 0) close(in->fd);
+    in->addr = NULL;
+    in->fd = -1;
+}
+
+#endif // MMAP_INPUT_H
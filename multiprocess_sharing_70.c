@@ -0,0 +1,336 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "cache_state.h"
+#include "prefault.h"
+
+// This program demonstrates:
+// - False sharing between processes instead of threads: N forked processes each update their own
+//   counter slot in one MAP_SHARED region, as shared-memory IPC does with per-process statistics
+//   slots or ring-buffer indices
+// - Packed slots (several processes' counters on one cache line) against padded slots (one line
+//   per process)
+// - Hardware counters collected per process with perf_event_open, then aggregated by the parent,
+//   since each process is counted separately
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Slot layouts
+typedef enum {
+    LAYOUT_PACKED,   // slot p at offset p * 8: 8 processes per cache line
+    LAYOUT_PADDED    // slot p at offset p * 64: one cache line per process
+} SlotLayout;
+
+// Hardware events counted in every process
+typedef enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_CACHE_REFERENCES,
+    COUNTER_CACHE_MISSES,
+    NUM_COUNTERS
+} CounterId;
+
+static const char *counter_names[NUM_COUNTERS] = { "cycles", "instructions", "LLC references", "LLC misses" };
+static const unsigned long long counter_configs[NUM_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES
+};
+
+// Per-process result written by the child into the shared result area, two cache lines each.
+// The fault deltas are the child's own: the parent's getrusage() cannot see a running child.
+typedef struct {
+    pid_t pid;
+    int counters_ok;                          // 0 if perf_event_open was unavailable
+    double elapsed;
+    unsigned long long counts[NUM_COUNTERS];
+    FaultPhase setup_faults;                  // from fork to the start line
+    FaultPhase kernel_faults;                 // around the update loop
+    char padding[2 * CACHE_LINE_SIZE - sizeof(pid_t) - sizeof(int) - sizeof(double) -
+                 NUM_COUNTERS * sizeof(unsigned long long) - 2 * sizeof(FaultPhase)];
+} ProcessResult;
+
+// Start-line shared by the parent and the children
+typedef struct {
+    atomic_int ready;
+    atomic_int start;
+} StartControl;
+
+const char *layout_name(SlotLayout layout) {
+    switch (layout) {
+    case LAYOUT_PACKED: return "packed";
+    case LAYOUT_PADDED: return "padded";
+    }
+    return "unknown";
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Function to map an anonymous region shared with every process forked afterwards, prefaulted
+// as requested in the parent. The pages are then resident, but each child still takes a minor
+// fault to map a shared page into its own page table on first touch.
+static void *map_shared(size_t bytes, PrefaultMode prefault) {
+    void *ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        fprintf(stderr, "Shared mapping of %zu bytes failed.\n", bytes);
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, ptr, bytes, 1, 1, 1, PARTITION_LINE, BACKEND_OPENMP);
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+// Function to open the calling process's user-space counters, disabled until enabled.
+// Returns 0 and leaves fds[] at -1 if any event cannot be opened (no PMU access, paranoid level).
+static int open_counters(int fds[NUM_COUNTERS]) {
+    for (int c = 0; c < NUM_COUNTERS; c++) fds[c] = -1;
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = counter_configs[c];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds[c] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fds[c] < 0) {
+            for (int k = 0; k <= c; k++) {
+                if (fds[k] >= 0) close(fds[k]);
+                fds[k] = -1;
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void set_counters(int fds[NUM_COUNTERS], unsigned long request) {
+    for (int c = 0; c < NUM_COUNTERS; c++) ioctl(fds[c], request, 0);
+}
+
+// Function run by each child process: put its slot and result line in the requested cache state,
+// wait for the start flag, then add 1 to its own slot for each of its updates, with counters
+// enabled around the loop only. Its setup and kernel faults go into its result. The children prepare concurrently, so under mixed another child's
+// eviction pass can still push a re-touched line out of a shared last-level cache.
+static void run_child(_Atomic unsigned long *slot, unsigned long updates, CacheState cache,
+                      StartControl *control, ProcessResult *result) {
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+    int fds[NUM_COUNTERS];
+    int counters_ok = open_counters(fds);
+
+    // The process is single-threaded, so the passes run on this process alone
+    CacheRegion regions[] = { { (void *) slot, 1, sizeof(unsigned long), 1 },
+                              { result, 1, sizeof(ProcessResult), 1 } };
+    cache_state_prepare(cache, regions, 2, 1, PARTITION_LINE, BACKEND_OPENMP);
+    fault_phase_delta(&faults, &result->setup_faults);
+
+    atomic_fetch_add_explicit(&control->ready, 1, memory_order_acq_rel);
+    while (!atomic_load_explicit(&control->start, memory_order_acquire)) {
+        sched_yield();
+    }
+
+    if (counters_ok) {
+        set_counters(fds, PERF_EVENT_IOC_RESET);
+        set_counters(fds, PERF_EVENT_IOC_ENABLE);
+    }
+    fault_phase_begin(&faults);
+    double start_time = now_seconds();
+
+    // Single writer per slot: relaxed load + store, no read-modify-write needed
+    for (unsigned long i = 0; i < updates; i++) {
+        unsigned long v = atomic_load_explicit(slot, memory_order_relaxed);
+        atomic_store_explicit(slot, v + 1, memory_order_relaxed);
+    }
+
+    result->elapsed = now_seconds() - start_time;
+    fault_phase_delta(&faults, &result->kernel_faults);
+    if (counters_ok) {
+        set_counters(fds, PERF_EVENT_IOC_DISABLE);
+        for (int c = 0; c < NUM_COUNTERS; c++) {
+            unsigned long long value = 0;
+            if (read(fds[c], &value, sizeof(value)) != (ssize_t) sizeof(value)) counters_ok = 0;
+            result->counts[c] = value;
+            close(fds[c]);
+        }
+    }
+    result->pid = getpid();
+    result->counters_ok = counters_ok;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs] [size] [processes] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good   : each process's counter slot on its own cache line of the shared region\n");
+    fprintf(stderr, "  bad-fs : counter slots packed back-to-back (8 processes per cache line)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --cache=STATE  cache state each process starts from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M   fault the shared regions in before forking: none, populate or touch (default none)\n");
+    fprintf(stderr, "size is the total number of counter updates, split evenly over the processes.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_procs = atoi(argv[3]);
+
+    // Validate mode
+    SlotLayout layout;
+    if (strcmp(mode, "good") == 0) {
+        layout = LAYOUT_PADDED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        layout = LAYOUT_PACKED;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    for (int i = 4; i < argc; i++) {
+        int parsed = cache_state_parse_option(argv[i], &cache);
+        if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+        if (parsed == 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (parsed < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Validate size and processes
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_procs <= 0) {
+        fprintf(stderr, "Error: Number of processes must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Shared slots, per-process results and the start control, all mapped before fork
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+    size_t stride = layout == LAYOUT_PADDED ? CACHE_LINE_SIZE : sizeof(unsigned long);
+    size_t slot_bytes = (size_t) num_procs * stride;
+    char *slots = (char *) map_shared(slot_bytes, prefault);
+    ProcessResult *results = (ProcessResult *) map_shared(num_procs * sizeof(ProcessResult), prefault);
+    StartControl *control = (StartControl *) map_shared(sizeof(StartControl), prefault);
+
+    // Flush before forking so buffered output is not duplicated by the children
+    fflush(stdout);
+    pid_t *pids = (pid_t *) malloc(num_procs * sizeof(pid_t));
+    if (!pids) {
+        fprintf(stderr, "Memory allocation failed for the process table.\n");
+        return EXIT_FAILURE;
+    }
+    for (int p = 0; p < num_procs; p++) {
+        unsigned long updates = size * (p + 1) / num_procs - size * p / num_procs;
+        pids[p] = fork();
+        if (pids[p] < 0) {
+            perror("fork");
+            atomic_store_explicit(&control->start, 1, memory_order_release);
+            for (int k = 0; k < p; k++) waitpid(pids[k], NULL, 0);
+            return EXIT_FAILURE;
+        }
+        if (pids[p] == 0) {
+            run_child((_Atomic unsigned long *) (slots + p * stride), updates, cache, control, &results[p]);
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    // Release every process at once, then wait for all of them
+    while (atomic_load_explicit(&control->ready, memory_order_acquire) < num_procs) {
+        sched_yield();
+    }
+    FaultPhase setup_faults;
+    fault_phase_delta(&faults, &setup_faults);
+    double start_time = now_seconds();
+    atomic_store_explicit(&control->start, 1, memory_order_release);
+
+    int ok = 1;
+    for (int p = 0; p < num_procs; p++) {
+        int status = 0;
+        if (waitpid(pids[p], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = 0;
+    }
+    double elapsed = now_seconds() - start_time;
+
+    // Check every slot and aggregate the per-process counters and faults. Setup is the parent's
+    // mapping and forking plus every child's own setup; the kernel is the children's loops alone.
+    int counters_ok = 1;
+    unsigned long long totals[NUM_COUNTERS] = { 0 };
+    FaultPhase kernel_faults = { 0, 0, 0.0 };
+    for (int p = 0; p < num_procs; p++) {
+        setup_faults.minflt += results[p].setup_faults.minflt;
+        setup_faults.majflt += results[p].setup_faults.majflt;
+        setup_faults.sys_time += results[p].setup_faults.sys_time;
+        kernel_faults.minflt += results[p].kernel_faults.minflt;
+        kernel_faults.majflt += results[p].kernel_faults.majflt;
+        kernel_faults.sys_time += results[p].kernel_faults.sys_time;
+        unsigned long updates = size * (p + 1) / num_procs - size * p / num_procs;
+        if (atomic_load((_Atomic unsigned long *) (slots + p * stride)) != updates) ok = 0;
+        if (!results[p].counters_ok) counters_ok = 0;
+        for (int c = 0; c < NUM_COUNTERS; c++) totals[c] += results[p].counts[c];
+    }
+
+    int per_line = layout == LAYOUT_PADDED ? 1 : (int) (CACHE_LINE_SIZE / sizeof(unsigned long));
+    if (per_line > num_procs) per_line = num_procs;
+    printf("Mode: %s (layout %s, MAP_SHARED region, up to %d processes per cache line)\n",
+           mode, layout_name(layout), per_line);
+    printf("Size: %lu\n", size);
+    printf("Processes: %d\n", num_procs);
+    cache_state_report(cache);
+    prefault_report(prefault);
+    fault_phase_print(&setup_faults, "setup");
+    fault_phase_print(&kernel_faults, "kernel");
+    for (int p = 0; p < num_procs; p++) {
+        printf("Process %d (pid %d): %.6f s", p, (int) results[p].pid, results[p].elapsed);
+        if (results[p].counters_ok) {
+            for (int c = 0; c < NUM_COUNTERS; c++) printf(", %s=%llu", counter_names[c], results[p].counts[c]);
+        }
+        printf("\n");
+    }
+    if (counters_ok) {
+        printf("Process Totals:");
+        for (int c = 0; c < NUM_COUNTERS; c++) printf("%s %s=%llu", c ? "," : "", counter_names[c], totals[c]);
+        printf("\n");
+    } else {
+        printf("Process Totals: counters unavailable (perf_event_open failed in at least one process)\n");
+    }
+    printf("Updates/s: %.0f\n", size / elapsed);
+    printf("Check: %s\n", ok ? "ok" : "MISMATCH");
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(pids);
+    munmap(slots, slot_bytes);
+    munmap(results, num_procs * sizeof(ProcessResult));
+    munmap(control, sizeof(StartControl));
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,88 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Shared range partitioner for the hand-chunked parallel loops.
+//
+// The original kernels split [0, size) as start = tid * (size / num_threads), which ignores
+// where the array sits in memory and hands the whole remainder to the last thread. The aligned
+// policies instead cut the range only at cache-line (or page) boundaries of the actual array
+// address and spread the remaining units one by one over the first threads.
+
+// Define cache line and page size used as split granularity
+#define PARTITION_LINE_SIZE 64
+#define PARTITION_PAGE_SIZE 4096
+
+typedef enum {
+    PARTITION_NAIVE,  // legacy split: equal element counts, remainder to the last thread
+    PARTITION_LINE,   // balanced split on cache-line boundaries
+    PARTITION_PAGE,   // balanced split on page boundaries
+    PARTITION_NUMA    // page split, and initialisation first-touches with the same split
+} PartitionPolicy;
+
+static inline const char *partition_policy_name(PartitionPolicy policy) {
+    switch (policy) {
+    case PARTITION_NAIVE: return "naive";
+    case PARTITION_LINE: return "line";
+    case PARTITION_PAGE: return "page";
+    case PARTITION_NUMA: return "numa";
+    }
+    return "unknown";
+}
+
+// Function to parse a --partition=<policy> argument.
+// Returns 1 if the argument was consumed, 0 if it is not a partition option, -1 if invalid.
+static inline int partition_parse_option(const char *arg, PartitionPolicy *policy) {
+    if (strncmp(arg, "--partition=", 12) != 0) return 0;
+    const char *value = arg + 12;
+    if (strcmp(value, "naive") == 0) *policy = PARTITION_NAIVE;
+    else if (strcmp(value, "line") == 0) *policy = PARTITION_LINE;
+    else if (strcmp(value, "page") == 0) *policy = PARTITION_PAGE;
+    else if (strcmp(value, "numa") == 0) *policy = PARTITION_NUMA;
+    else {
+        fprintf(stderr, "Invalid partition policy: %s (expected naive, line, page or numa)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+// Element index of the k-th unit boundary, clamped to [0, count]
+static inline unsigned long partition_boundary(unsigned long k, unsigned long granularity, unsigned long offset,
+                                               size_t elem_size, unsigned long count) {
+    unsigned long byte = k * granularity;
+    if (byte <= offset) return 0;
+    unsigned long idx = (byte - offset + elem_size - 1) / elem_size;
+    return idx < count ? idx : count;
+}
+
+// Function to compute the [start, end) element range of 'part' out of 'num_parts' for an array
+// of 'count' elements of 'elem_size' bytes starting at 'base'
+static inline void partition_range(const void *base, unsigned long count, size_t elem_size,
+                                   PartitionPolicy policy, int num_parts, int part,
+                                   unsigned long *start, unsigned long *end) {
+    if (policy == PARTITION_NAIVE) {
+        unsigned long chunk_size = count / num_parts;
+        *start = part * chunk_size;
+        *end = (part == num_parts - 1) ? count : *start + chunk_size;
+        return;
+    }
+
+    unsigned long granularity = (policy == PARTITION_LINE) ? PARTITION_LINE_SIZE : PARTITION_PAGE_SIZE;
+    unsigned long offset = (unsigned long) ((uintptr_t) base % granularity);
+    unsigned long units = (offset + count * elem_size + granularity - 1) / granularity;
+
+    // Balanced remainder: the first (units % num_parts) parts get one extra unit
+    unsigned long per_part = units / num_parts;
+    unsigned long extra = units % num_parts;
+    unsigned long p = (unsigned long) part;
+    unsigned long first_unit = p * per_part + (p < extra ? p : extra);
+    unsigned long last_unit = first_unit + per_part + (p < extra ? 1 : 0);
+
+    *start = partition_boundary(first_unit, granularity, offset, elem_size, count);
+    *end = partition_boundary(last_unit, granularity, offset, elem_size, count);
+}
+
+#endif // PARTITION_H
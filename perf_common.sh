@@ -0,0 +1,292 @@
+#!/bin/bash
+
+# ==============================================================================
+# Script Name: perf_common.sh
+# Description: Shared CSV layout and 'perf stat' helpers for the data collection
+#              scripts (perf_data.sh, corun_perf.sh), and the per-host
+#              core-to-core latency calibration. Sourced, not executed;
+#              the caller sets OUTPUT_FILE and ERROR_LOG first.
+# ==============================================================================
+
+# ==============================================================================
+# Function: write_header
+# Description: Writes the CSV header if the output file does not exist.
+# ==============================================================================
+CSV_HEADER="Program,Mode,Threads,Data_Size,Options,Run,cache_references,cache_misses,L1_dcache_loads,L1_dcache_load_misses,L1_dcache_prefetches,dTLB_loads,dTLB_load_misses,branch_instructions,branch_misses,context_switches,cpu_migrations,stalled_cycles_backend,stalled_cycles_frontend,cpu_cycles,instructions,elapsed_time,user_time,sys_time,page_faults_minor,page_faults_major,io_wait_time,kernel_faults_minor,kernel_faults_major,kernel_fault_sys_time,c2c_latency_ns"
+
+write_header() {
+    echo "$CSV_HEADER" > "$OUTPUT_FILE"
+    echo "Created new output file and added header: $OUTPUT_FILE"
+}
+
+# ==============================================================================
+# Function: init_output_file
+# Description: Creates the output CSV with its header, or sets aside a file
+#              written with a different column layout.
+# ==============================================================================
+init_output_file() {
+    if [ ! -f "$OUTPUT_FILE" ]; then
+        write_header
+    elif [ "$(head -n 1 "$OUTPUT_FILE")" != "$CSV_HEADER" ]; then
+        # Columns changed since the file was written: set it aside instead of mixing layouts
+        LEGACY_FILE="${OUTPUT_FILE}.legacy_$(date +%F_%T)"
+        mv "$OUTPUT_FILE" "$LEGACY_FILE"
+        echo "Output file has an outdated header; moved it to $LEGACY_FILE"
+        write_header
+    else
+        echo "Output file exists. Appending data to $OUTPUT_FILE"
+    fi
+}
+
+# ==============================================================================
+# Function: extract_metrics
+# Description: Parses 'perf' output and extracts relevant performance metrics.
+#              Page faults come from the program's --input report (kernel only)
+#              or else from perf's minor-faults/major-faults (whole run); I/O
+#              wait is only printed with --input and stays 0 otherwise. The
+#              kernel_* fault columns come from the "Faults (kernel)" line of
+#              the programs using prefault.h and stay 0 for the others.
+# ==============================================================================
+extract_metrics() {
+    local perf_output="$1"
+
+    # Use awk to parse the perf output
+    echo "$perf_output" | awk '
+    BEGIN {
+        FS=" ";
+        OFS=",";
+        # Initialize all variables to "0" to handle cases where metrics are missing
+        cache_references = cache_misses = L1_dcache_loads = L1_dcache_load_misses = L1_dcache_prefetches = dTLB_loads = dTLB_load_misses = branch_instructions = branch_misses = context_switches = cpu_migrations = stalled_cycles_backend = stalled_cycles_frontend = cpu_cycles = instructions = elapsed_time = user_time = sys_time = page_faults_minor = page_faults_major = io_wait_time = "0";
+        perf_minor_faults = perf_major_faults = kernel_faults_minor = kernel_faults_major = kernel_fault_sys_time = "0";
+        input_report = 0;
+    }
+    /cache-references/ {cache_references=$1}
+    /cache-misses/ {cache_misses=$1}
+    /L1-dcache-loads/ {L1_dcache_loads=$1}
+    /L1-dcache-load-misses/ {L1_dcache_load_misses=$1}
+    /L1-dcache-prefetches/ {L1_dcache_prefetches=$1}
+    /dTLB-loads/ {dTLB_loads=$1}
+    /dTLB-load-misses/ {dTLB_load_misses=$1}
+    /branch-instructions/ {branch_instructions=$1}
+    /branch-misses/ {branch_misses=$1}
+    /context-switches/ {context_switches=$1}
+    /cpu-migrations/ {cpu_migrations=$1}
+    /stalled-cycles-backend/ {stalled_cycles_backend=$1}
+    /stalled-cycles-frontend/ {stalled_cycles_frontend=$1}
+    /cycles / {cpu_cycles=$1}
+    /instructions / {instructions=$1}
+    /seconds time elapsed/ {elapsed_time=$1}
+    /seconds user/ {user_time=$1}
+    /seconds sys/ {sys_time=$1}
+    /minor-faults/ {perf_minor_faults=$1}
+    /major-faults/ {perf_major_faults=$1}
+    /^Page Faults: minor/ {page_faults_minor=$4; page_faults_major=$6; input_report=1}
+    /^Faults \(kernel\):/ {kernel_faults_minor=$4; kernel_faults_major=$6; kernel_fault_sys_time=$8}
+    /^I\/O Wait:/ {io_wait_time=$3}
+    END {
+        if (!input_report) {
+            page_faults_minor = perf_minor_faults;
+            page_faults_major = perf_major_faults;
+        }
+
+        # Replace <not counted> with 0
+        gsub(/<not counted>/, "0", cache_references);
+        gsub(/<not counted>/, "0", cache_misses);
+        gsub(/<not counted>/, "0", L1_dcache_loads);
+        gsub(/<not counted>/, "0", L1_dcache_load_misses);
+        gsub(/<not counted>/, "0", L1_dcache_prefetches);
+        gsub(/<not counted>/, "0", dTLB_loads);
+        gsub(/<not counted>/, "0", dTLB_load_misses);
+        gsub(/<not counted>/, "0", branch_instructions);
+        gsub(/<not counted>/, "0", branch_misses);
+        gsub(/<not counted>/, "0", context_switches);
+        gsub(/<not counted>/, "0", cpu_migrations);
+        gsub(/<not counted>/, "0", stalled_cycles_backend);
+        gsub(/<not counted>/, "0", stalled_cycles_frontend);
+        gsub(/<not counted>/, "0", cpu_cycles);
+        gsub(/<not counted>/, "0", instructions);
+        gsub(/<not counted>/, "0", elapsed_time);
+        gsub(/<not counted>/, "0", user_time);
+        gsub(/<not counted>/, "0", sys_time);
+        gsub(/<not counted>/, "0", page_faults_minor);
+        gsub(/<not counted>/, "0", page_faults_major);
+
+        # Remove commas from all numeric values to prevent CSV cell splitting
+        gsub(/,/, "", cache_references);
+        gsub(/,/, "", cache_misses);
+        gsub(/,/, "", L1_dcache_loads);
+        gsub(/,/, "", L1_dcache_load_misses);
+        gsub(/,/, "", L1_dcache_prefetches);
+        gsub(/,/, "", dTLB_loads);
+        gsub(/,/, "", dTLB_load_misses);
+        gsub(/,/, "", branch_instructions);
+        gsub(/,/, "", branch_misses);
+        gsub(/,/, "", context_switches);
+        gsub(/,/, "", cpu_migrations);
+        gsub(/,/, "", stalled_cycles_backend);
+        gsub(/,/, "", stalled_cycles_frontend);
+        gsub(/,/, "", cpu_cycles);
+        gsub(/,/, "", instructions);
+        gsub(/,/, "", elapsed_time);
+        gsub(/,/, "", user_time);
+        gsub(/,/, "", sys_time);
+        gsub(/,/, "", page_faults_minor);
+        gsub(/,/, "", page_faults_major);
+        gsub(/,/, "", kernel_faults_minor);
+        gsub(/,/, "", kernel_faults_major);
+
+        print cache_references, cache_misses, L1_dcache_loads, L1_dcache_load_misses, L1_dcache_prefetches, dTLB_loads, dTLB_load_misses, branch_instructions, branch_misses, context_switches, cpu_migrations, stalled_cycles_backend, stalled_cycles_frontend, cpu_cycles, instructions, elapsed_time, user_time, sys_time, page_faults_minor, page_faults_major, io_wait_time, kernel_faults_minor, kernel_faults_major, kernel_fault_sys_time;
+    }'
+}
+
+# ==============================================================================
+# Core-to-core latency calibration
+# The matrix measured by cl_72 (cpu_a,cpu_b,latency_ns,bandwidth_mbs per CPU
+# pair) is cached per host, so it is measured once and reused by every sweep.
+# ==============================================================================
+CORE_LATENCY_FILE="${CORE_LATENCY_FILE:-core_latency_$(hostname -s).csv}"
+CORE_LATENCY_ROUND_TRIPS="${CORE_LATENCY_ROUND_TRIPS:-20000}"
+
+# ==============================================================================
+# Function: load_core_latency
+# Description: Measures the host's core-to-core latency matrix with cl_72 unless
+#              it is already cached. Without a matrix the c2c_latency_ns column
+#              stays empty and no pinned runs are made.
+# ==============================================================================
+load_core_latency() {
+    if [ ! -s "$CORE_LATENCY_FILE" ] && [ -x ./cl_72 ]; then
+        echo "Calibrating core-to-core latency into $CORE_LATENCY_FILE (once per host)."
+        ./cl_72 matrix "$CORE_LATENCY_ROUND_TRIPS" --output="$CORE_LATENCY_FILE" > /dev/null || rm -f "$CORE_LATENCY_FILE"
+    fi
+    if [ -s "$CORE_LATENCY_FILE" ]; then
+        echo "Core-to-core latency matrix: $CORE_LATENCY_FILE"
+    else
+        echo "Warning: no core-to-core latency matrix; c2c_latency_ns stays empty."
+    fi
+}
+
+# ==============================================================================
+# Function: cpu_set_latency
+# Description: Prints the mean one-way latency (ns) over the CPU pairs inside a
+#              taskset-style list ("0,2" or "0-3,8"); an empty list means every
+#              pair, i.e. an unpinned run. Prints nothing without a matrix.
+# ==============================================================================
+cpu_set_latency() {
+    [ -s "$CORE_LATENCY_FILE" ] || return 0
+    awk -F, -v list="$1" '
+    BEGIN {
+        n = split(list, parts, ",");
+        for (i = 1; i <= n; i++) {
+            if (split(parts[i], range, "-") == 2) {
+                for (c = range[1]; c <= range[2]; c++) want[c] = 1;
+            } else if (parts[i] != "") {
+                want[parts[i]] = 1;
+            }
+        }
+    }
+    NR > 1 && (list == "" || (($1 in want) && ($2 in want))) { sum += $3; count++ }
+    END { if (count) printf "%.2f", sum / count }
+    ' "$CORE_LATENCY_FILE"
+}
+
+# ==============================================================================
+# Function: representative_pairs
+# Description: Prints "near A,B", "mid A,B" and "far A,B": the CPU pairs with
+#              the lowest, median and highest latency (typically SMT siblings,
+#              two cores of one die, and two sockets).
+# ==============================================================================
+representative_pairs() {
+    [ -s "$CORE_LATENCY_FILE" ] || return 0
+    tail -n +2 "$CORE_LATENCY_FILE" | sort -t, -k3,3g | awk -F, '
+    { pair[NR] = $1 "," $2 }
+    END {
+        if (NR == 0) exit;
+        print "near " pair[1];
+        if (NR > 2) print "mid " pair[int((NR + 1) / 2)];
+        if (NR > 1) print "far " pair[NR];
+    }'
+}
+
+# ==============================================================================
+# Function: perf_collect
+# Description: Runs a command under 'perf stat' with the collected events and
+#              prints the combined program and perf output. The exit status is
+#              that of the command.
+# ==============================================================================
+PERF_EVENTS="cache-references,cache-misses,L1-dcache-loads,L1-dcache-load-misses,L1-dcache-prefetches,dTLB-loads,dTLB-load-misses,branch-instructions,branch-misses,context-switches,cpu-migrations,stalled-cycles-backend,stalled-cycles-frontend,cpu-cycles,instructions,minor-faults,major-faults"
+
+perf_collect() {
+    perf stat -e "$PERF_EVENTS" "$@" 2>&1
+}
+
+# ==============================================================================
+# Function: log_perf_line
+# Description: Appends one CSV row for a finished run: its metrics, or an ERROR
+#              flag with empty metric fields when the run failed.
+# Arguments:   program mode threads data_size options run status perf_output
+#              [c2c_latency]  (mean core-to-core latency of the CPUs used)
+# ==============================================================================
+log_perf_line() {
+    local program="$1"
+    local mode="$2"
+    local threads="$3"
+    local data_size="$4"
+    local options="$5"
+    local run="$6"
+    local status="$7"
+    local perf_output="$8"
+    local c2c_latency="$9"
+
+    if [ "$status" -ne 0 ]; then
+        echo "Error: Program $program encountered an error during execution."
+        # Log the error in the CSV with an ERROR flag and empty fields for metrics
+        LINE="$program,$mode,$threads,$data_size,$options,$run,ERROR,,,,,,,,,,,,,,,,,,,,,,,,"
+        echo "$LINE" >> "$OUTPUT_FILE"
+        echo "Error during run #$run of program $program with Mode=$mode, Threads=$threads, Data_Size=$data_size, Options=$options" >> "$ERROR_LOG"
+        return 1
+    fi
+
+    # Extract metrics from perf output
+    METRICS=$(extract_metrics "$perf_output")
+
+    # Combine all extracted metrics into a single line
+    LINE="$program,$mode,$threads,$data_size,$options,$run,$METRICS,$c2c_latency"
+
+    # Append the line to the output CSV file
+    echo "$LINE" >> "$OUTPUT_FILE"
+}
+
+# ==============================================================================
+# Function: run_perf_and_log
+# Description: Executes a program with given parameters, collects perf metrics,
+#              and logs the results into the CSV file. An optional pin
+#              "class:A,B" runs it with its threads on CPUs A and B (taskset,
+#              one OpenMP place per CPU) and adds pin=class:A/B to Options.
+# ==============================================================================
+run_perf_and_log() {
+    local program="$1"
+    local mode="$2"
+    local data_size="$3"
+    local threads="$4"
+    local run="$5"
+    local options="$6"
+    local pin="$7"
+
+    echo "    Run #$run"
+    echo "    Executing: $program $mode $data_size $threads $options${pin:+ (pinned $pin)}"
+
+    # Execute the program with current configuration and capture perf output
+    local logged_options="$options"
+    local cpus=""
+    if [ -n "$pin" ]; then
+        cpus="${pin#*:}"
+        logged_options="${options:+$options }pin=${pin//,//}"
+        PERF_OUTPUT=$(perf_collect env OMP_PLACES="$(echo "$cpus" | sed 's/[0-9][0-9]*/{&}/g')" OMP_PROC_BIND=close \
+                      taskset -c "$cpus" "$program" "$mode" "$data_size" "$threads" $options)
+    else
+        PERF_OUTPUT=$(perf_collect "$program" "$mode" "$data_size" "$threads" $options)
+    fi
+    local status=$?
+
+    log_perf_line "$program" "$mode" "$threads" "$data_size" "$logged_options" "$run" "$status" "$PERF_OUTPUT" "$(cpu_set_latency "$cpus")"
+}
@@ -20,6 +20,35 @@ OUTPUT_FILE="perf_data.csv"
 ERROR_LOG="error.log"
 LOG_FILE="perf_run.log"
 
+# Configurations with this thread count also run pinned to the representative
+# CPU pairs (near/mid/far) of the host's core-to-core latency matrix from cl_72;
+# empty disables the pinned runs
+PIN_THREADS=2
+
+# Cache state the kernels of the programs below start from (see cache_state.h):
+# warm, cold-stream, cold-flush or mixed. It is passed as --cache and recorded in
+# the Options column, so small sizes no longer flip between cache-resident and
+# DRAM-bound depending on how each program initialised its data. Empty keeps
+# whatever the initialisation left in cache.
+CACHE_STATE="warm"
+CACHE_STATE_PROGRAMS="./vec_14 ./sc_28 ./seq_10 ./mc_31 ./vec_23 ./sc_29 ./lk_51 ./ct_52 ./sp_53 ./st_54 ./pc_56 ./hm_58 ./mm_60 ./tr_61 ./rw_67 ./hc_68 ./mp_70"
+
+# How the programs below fault their arrays in (see prefault.h): populate or
+# touch, passed as --prefault and recorded in the Options column. 'touch' faults
+# each page from the thread whose partition holds it, like a parallel
+# initialisation, so vec_23 no longer takes its first-touch faults inside the
+# timed kernel. Every swept program takes it and prints the Faults (kernel) line
+# behind the kernel_faults_* columns. Empty leaves faulting to each program.
+PREFAULT="touch"
+PREFAULT_PROGRAMS="$CACHE_STATE_PROGRAMS"
+
+# tr_61 good autotunes its tile (five extra tiled transposes) unless given --tile,
+# and that would run inside the process perf measures. The tile is tuned once per
+# host at this size, outside perf, cached in TRANSPOSE_TILE_FILE and passed as
+# --tile to every tr_61 good run.
+TRANSPOSE_TILE_SIZE=4000
+TRANSPOSE_TILE_FILE="transpose_tile_$(hostname -s).txt"
+
 # ==============================================================================
 # Redirect All Output to Log File
 # ==============================================================================
@@ -50,17 +79,39 @@ declare -A PROGRAMS=(
     ["./seq_10"]="1000000000 2000000000 3000000000 4000000000 5000000000"
     ["./vec_14"]="100000000 100000000 300000000 400000000 500000000"
     ["./vec_23"]="100000000 100000000 300000000 400000000 500000000"
+    ["./tr_61"]="1000 2000 4000 6000 8000"
+    ["./lk_51"]="1000000 2000000 3000000 4000000 5000000"
+    ["./ct_52"]="1000000 2000000 3000000 4000000 5000000"
+    ["./sp_53"]="250000 500000 1000000 2000000 4000000"
+    ["./st_54"]="1000 2000 3000 4000 5000"
+    ["./pc_56"]="1000000 2000000 4000000 8000000 16000000"
+    ["./hm_58"]="1000000 2000000 3000000 4000000 5000000"
+    ["./mm_60"]="200 400 600 800 1000"
+    ["./rw_67"]="100000000 200000000 300000000 400000000 500000000"
+    ["./hc_68"]="1000000 2000000 4000000 8000000 16000000"
+    ["./mp_70"]="100000000 200000000 300000000 400000000 500000000"
     # Add more programs and their data sizes here if needed
 )
 
 # Define modes for each program
 declare -A PROGRAM_MODES=(
-    ["./mc_31"]="good bad-fs bad-ma"
-    ["./sc_28"]="good bad-fs bad-ma"
-    ["./sc_29"]="good bad-fs bad-ma"
+    ["./mc_31"]="good bad-fs bad-ma bad-both"
+    ["./sc_28"]="good bad-fs bad-ma bad-fs-alloc good-alloc"
+    ["./sc_29"]="good bad-fs bad-ma bad-both bad-fs-alloc good-alloc"
     ["./seq_10"]="good bad"
-    ["./vec_14"]="good bad-fs bad-ma"
+    ["./vec_14"]="good bad-fs bad-ma bad-ma-tlb bad-fs-alloc good-alloc"
     ["./vec_23"]="good bad-fs bad-ma"
+    ["./tr_61"]="good bad-fs bad-ma"
+    ["./lk_51"]="good bad-fs bad-lock"
+    ["./ct_52"]="good bad-fs"
+    ["./sp_53"]="good bad-ma"
+    ["./st_54"]="good bad-fs"
+    ["./pc_56"]="good bad-ma"
+    ["./hm_58"]="good bad-fs"
+    ["./mm_60"]="good bad-fs bad-ma"
+    ["./rw_67"]="good bad-fs"
+    ["./hc_68"]="good bad-fs"
+    ["./mp_70"]="good bad-fs"
     # Add more programs and their modes here if needed
 )
 
@@ -72,144 +123,86 @@ declare -A PROGRAM_THREADS=(
     ["./seq_10"]="1 2 3 4 5 6 7 8"
     ["./vec_14"]="1 2 3 4 5 6 7 8"
     ["./vec_23"]="1 2 3 4 5 6 7 8"
+    ["./tr_61"]="1 2 3 4 5 6 7 8"
+    ["./lk_51"]="1 2 3 4 5 6 7 8"
+    ["./ct_52"]="1 2 3 4 5 6 7 8"
+    ["./sp_53"]="1 2 3 4 5 6 7 8"
+    ["./st_54"]="1 2 3 4 5 6 7 8"
+    ["./pc_56"]="1 2 3 4 5 6 7 8"
+    ["./hm_58"]="1 2 3 4 5 6 7 8"
+    ["./mm_60"]="1 2 3 4 5 6 7 8"
+    ["./rw_67"]="1 2 3 4 5 6 7 8"
+    ["./hc_68"]="1 2 3 4 5 6 7 8"
+    ["./mp_70"]="1 2 3 4 5 6 7 8"
     # Add more programs and their thread counts here if needed
 )
 
-# ==============================================================================
-# Function: write_header
-# Description: Writes the CSV header if the output file does not exist.
-# ==============================================================================
-write_header() {
-    echo "Program,Mode,Threads,Data_Size,Run,cache_references,cache_misses,L1_dcache_loads,L1_dcache_load_misses,L1_dcache_prefetches,dTLB_loads,dTLB_load_misses,branch_instructions,branch_misses,context_switches,cpu_migrations,stalled_cycles_backend,stalled_cycles_frontend,cpu_cycles,instructions,elapsed_time,user_time,sys_time" > "$OUTPUT_FILE"
-    echo "Created new output file and added header: $OUTPUT_FILE"
-}
+# Define extra option sets per "program mode" pair, separated by ';'.
+# Each set is passed after the thread count and recorded in the Options column;
+# pairs without an entry run once with no options, and an empty set (leading ';')
+# keeps that plain run alongside the listed ones.
+# vec_14 bad-ma-tlb spans: 32 pages (128 KiB) fits the L1 dTLB, 1024 pages (4 MiB) fits
+# the STLB, 16384 (64 MiB) and 131072 (512 MiB) exceed STLB reach with 4 KiB pages.
+# One line is read per page, so the spans also touch 2 KiB, 64 KiB, 1 MiB and 8 MiB of lines:
+# the largest spans add L2 and possibly LLC misses, and their --hugepages=on runs (same lines,
+# few TLB entries) separate the TLB share from the cache share.
+declare -A PROGRAM_OPTIONS=(
+    ["./vec_14 bad-ma-tlb"]="--pages=32 --hugepages=off;--pages=1024 --hugepages=off;--pages=16384 --hugepages=off;--pages=131072 --hugepages=off;--pages=16384 --hugepages=on;--pages=131072 --hugepages=on"
+    # Task-based variants: per-task result slots, padded (good) or packed (bad-fs);
+    # threading backends: the same kernel body on fork-join pthreads and on a futex-barrier pool;
+    # memory orders of the per-thread counter updates (padded in good, packed in bad-fs)
+    ["./sc_28 good"]=";--backend=pthread;--backend=pool;--order=store;--order=relaxed;--order=seq_cst;--order=cas"
+    ["./sc_28 bad-fs"]=";--backend=pthread;--backend=pool;--order=store;--order=relaxed;--order=seq_cst;--order=cas"
+    ["./sc_29 good"]=";--tasking=taskloop;--tasking=recursive;--backend=pthread;--backend=pool"
+    ["./sc_29 bad-fs"]=";--tasking=taskloop;--tasking=recursive;--backend=pthread;--backend=pool"
+    ["./mc_31 good"]=";--tasking=taskloop;--tasking=recursive;--backend=pthread;--backend=pool"
+    ["./mc_31 bad-fs"]=";--tasking=taskloop;--tasking=recursive;--backend=pthread;--backend=pool"
+    ["./vec_14 good"]=";--backend=pthread;--backend=pool"
+    ["./vec_14 bad-fs"]=";--backend=pthread;--backend=pool"
+    ["./vec_23 good"]=";--tasking=taskloop;--tasking=recursive;--backend=pthread;--backend=pool"
+    ["./vec_23 bad-fs"]=";--tasking=taskloop;--tasking=recursive;--backend=pthread;--backend=pool"
+    # The later false-sharing pairs on every backend (tr_61 good gets its tuned tile below)
+    ["./lk_51 good"]=";--backend=pthread;--backend=pool"
+    ["./lk_51 bad-fs"]=";--backend=pthread;--backend=pool"
+    ["./ct_52 good"]=";--backend=pthread;--backend=pool"
+    ["./ct_52 bad-fs"]=";--backend=pthread;--backend=pool"
+    ["./hm_58 good"]=";--backend=pthread;--backend=pool"
+    ["./hm_58 bad-fs"]=";--backend=pthread;--backend=pool"
+    ["./mm_60 good"]=";--backend=pthread;--backend=pool"
+    ["./mm_60 bad-fs"]=";--backend=pthread;--backend=pool"
+    ["./tr_61 bad-fs"]=";--backend=pthread;--backend=pool"
+    ["./hc_68 good"]=";--backend=pthread;--backend=pool"
+    ["./hc_68 bad-fs"]=";--backend=pthread;--backend=pool"
+    # sp_53 on a banded matrix, where RCM recovers the band (mean |i-j| about 4 against about
+    # n/3 for the shuffled baseline); on the powerlaw default it barely changes locality
+    ["./sp_53 good"]="--matrix=banded"
+    ["./sp_53 bad-ma"]="--matrix=banded"
+    # Read-write sharing: the writer stores every iteration, every 16th and every 256th,
+    # and every iteration again on the pthread and pool backends
+    ["./rw_67 good"]=";--write-every=16;--write-every=256;--backend=pthread;--backend=pool"
+    ["./rw_67 bad-fs"]=";--write-every=16;--write-every=256;--backend=pthread;--backend=pool"
+    # Out-of-core example (needs disk space for the file; created on first use):
+    # ["./sc_29 bad-ma"]="--input=/data/sc_29.bin --madvise=random --drop-cache;--input=/data/sc_29.bin --madvise=willneed"
+    # Add more program/mode option sets here if needed
+)
 
 # ==============================================================================
-# Initialize Output CSV File
+# Shared CSV Layout and perf Helpers
 # ==============================================================================
-if [ ! -f "$OUTPUT_FILE" ]; then
-    write_header
-else
-    echo "Output file exists. Appending data to $OUTPUT_FILE"
+source "$(dirname "$0")/perf_common.sh"
+
+init_output_file
+
+# Core-to-core latency matrix (measured once per host) and its representative pairs
+load_core_latency
+PIN_PAIRS=()
+if [ -n "$PIN_THREADS" ]; then
+    while read -r PAIR_CLASS PAIR_CPUS; do
+        PIN_PAIRS+=("$PAIR_CLASS:$PAIR_CPUS")
+    done < <(representative_pairs)
+    [ ${#PIN_PAIRS[@]} -gt 0 ] && echo "Pinned runs at $PIN_THREADS threads on: ${PIN_PAIRS[*]}"
 fi
 
-# ==============================================================================
-# Function: extract_metrics
-# Description: Parses 'perf' output and extracts relevant performance metrics.
-# ==============================================================================
-extract_metrics() {
-    local perf_output="$1"
-
-    # Use awk to parse the perf output
-    echo "$perf_output" | awk '
-    BEGIN {
-        FS=" ";
-        OFS=",";
-        # Initialize all variables to "0" to handle cases where metrics are missing
-        cache_references = cache_misses = L1_dcache_loads = L1_dcache_load_misses = L1_dcache_prefetches = dTLB_loads = dTLB_load_misses = branch_instructions = branch_misses = context_switches = cpu_migrations = stalled_cycles_backend = stalled_cycles_frontend = cpu_cycles = instructions = elapsed_time = user_time = sys_time = "0";
-    }
-    /cache-references/ {cache_references=$1}
-    /cache-misses/ {cache_misses=$1}
-    /L1-dcache-loads/ {L1_dcache_loads=$1}
-    /L1-dcache-load-misses/ {L1_dcache_load_misses=$1}
-    /L1-dcache-prefetches/ {L1_dcache_prefetches=$1}
-    /dTLB-loads/ {dTLB_loads=$1}
-    /dTLB-load-misses/ {dTLB_load_misses=$1}
-    /branch-instructions/ {branch_instructions=$1}
-    /branch-misses/ {branch_misses=$1}
-    /context-switches/ {context_switches=$1}
-    /cpu-migrations/ {cpu_migrations=$1}
-    /stalled-cycles-backend/ {stalled_cycles_backend=$1}
-    /stalled-cycles-frontend/ {stalled_cycles_frontend=$1}
-    /cycles / {cpu_cycles=$1}
-    /instructions / {instructions=$1}
-    /seconds time elapsed/ {elapsed_time=$1}
-    /seconds user/ {user_time=$1}
-    /seconds sys/ {sys_time=$1}
-    END {
-        # Replace <not counted> with 0
-        gsub(/<not counted>/, "0", cache_references);
-        gsub(/<not counted>/, "0", cache_misses);
-        gsub(/<not counted>/, "0", L1_dcache_loads);
-        gsub(/<not counted>/, "0", L1_dcache_load_misses);
-        gsub(/<not counted>/, "0", L1_dcache_prefetches);
-        gsub(/<not counted>/, "0", dTLB_loads);
-        gsub(/<not counted>/, "0", dTLB_load_misses);
-        gsub(/<not counted>/, "0", branch_instructions);
-        gsub(/<not counted>/, "0", branch_misses);
-        gsub(/<not counted>/, "0", context_switches);
-        gsub(/<not counted>/, "0", cpu_migrations);
-        gsub(/<not counted>/, "0", stalled_cycles_backend);
-        gsub(/<not counted>/, "0", stalled_cycles_frontend);
-        gsub(/<not counted>/, "0", cpu_cycles);
-        gsub(/<not counted>/, "0", instructions);
-        gsub(/<not counted>/, "0", elapsed_time);
-        gsub(/<not counted>/, "0", user_time);
-        gsub(/<not counted>/, "0", sys_time);
-
-        # Remove commas from all numeric values to prevent CSV cell splitting
-        gsub(/,/, "", cache_references);
-        gsub(/,/, "", cache_misses);
-        gsub(/,/, "", L1_dcache_loads);
-        gsub(/,/, "", L1_dcache_load_misses);
-        gsub(/,/, "", L1_dcache_prefetches);
-        gsub(/,/, "", dTLB_loads);
-        gsub(/,/, "", dTLB_load_misses);
-        gsub(/,/, "", branch_instructions);
-        gsub(/,/, "", branch_misses);
-        gsub(/,/, "", context_switches);
-        gsub(/,/, "", cpu_migrations);
-        gsub(/,/, "", stalled_cycles_backend);
-        gsub(/,/, "", stalled_cycles_frontend);
-        gsub(/,/, "", cpu_cycles);
-        gsub(/,/, "", instructions);
-        gsub(/,/, "", elapsed_time);
-        gsub(/,/, "", user_time);
-        gsub(/,/, "", sys_time);
-
-        print cache_references, cache_misses, L1_dcache_loads, L1_dcache_load_misses, L1_dcache_prefetches, dTLB_loads, dTLB_load_misses, branch_instructions, branch_misses, context_switches, cpu_migrations, stalled_cycles_backend, stalled_cycles_frontend, cpu_cycles, instructions, elapsed_time, user_time, sys_time;
-    }'
-}
-
-# ==============================================================================
-# Function: run_perf_and_log
-# Description: Executes a program with given parameters, collects perf metrics,
-#              and logs the results into the CSV file.
-# ==============================================================================
-run_perf_and_log() {
-    local program="$1"
-    local mode="$2"
-    local data_size="$3"
-    local threads="$4"
-    local run="$5"
-
-    echo "    Run #$run"
-    echo "    Executing: $program $mode $data_size $threads"
-
-    # Execute the program with current configuration and capture perf output
-    PERF_OUTPUT=$(perf stat -e cache-references,cache-misses,L1-dcache-loads,L1-dcache-load-misses,L1-dcache-prefetches,dTLB-loads,dTLB-load-misses,branch-instructions,branch-misses,context-switches,cpu-migrations,stalled-cycles-backend,stalled-cycles-frontend,cpu-cycles,instructions \
-        "$program" "$mode" "$data_size" "$threads" 2>&1)
-
-    # Check if the program executed successfully
-    if [ $? -ne 0 ]; then
-        echo "Error: Program $program encountered an error during execution."
-        # Log the error in the CSV with an ERROR flag and empty fields for metrics
-        LINE="$program,$mode,$threads,$data_size,$run,ERROR,,,,,,,,,,,,,,,"
-        echo "$LINE" >> "$OUTPUT_FILE"
-        echo "Error during run #$run of program $program with Mode=$mode, Threads=$threads, Data_Size=$data_size" >> "$ERROR_LOG"
-        return 1
-    fi
-
-    # Extract metrics from perf output
-    METRICS=$(extract_metrics "$PERF_OUTPUT")
-
-    # Combine all extracted metrics into a single line
-    LINE="$program,$mode,$threads,$data_size,$run,$METRICS"
-
-    # Append the line to the output CSV file
-    echo "$LINE" >> "$OUTPUT_FILE"
-}
-
 # ==============================================================================
 # Verify Executability of All Programs
 # ==============================================================================
@@ -220,6 +213,22 @@ for PROGRAM in "${!PROGRAMS[@]}"; do
     fi
 done
 
+# ==============================================================================
+# Transpose Tile (tuned once per host)
+# ==============================================================================
+if [ ! -s "$TRANSPOSE_TILE_FILE" ]; then
+    ./tr_61 good "$TRANSPOSE_TILE_SIZE" 1 --tile=auto | sed -n 's/^Mode: good (tiled, \([0-9]*\) x.*/\1/p' > "$TRANSPOSE_TILE_FILE"
+fi
+TRANSPOSE_TILE=$(cat "$TRANSPOSE_TILE_FILE")
+if [ -n "$TRANSPOSE_TILE" ]; then
+    echo "Transpose tile for tr_61 good: $TRANSPOSE_TILE (from $TRANSPOSE_TILE_FILE)"
+    PROGRAM_OPTIONS["./tr_61 good"]="--tile=$TRANSPOSE_TILE;--tile=$TRANSPOSE_TILE --backend=pthread;--tile=$TRANSPOSE_TILE --backend=pool"
+else
+    rm -f "$TRANSPOSE_TILE_FILE"
+    echo "Error: could not tune the tr_61 tile; tr_61 good is skipped."
+    PROGRAM_MODES["./tr_61"]="bad-fs bad-ma"
+fi
+
 # ==============================================================================
 # Main Execution Loop
 # ==============================================================================
@@ -233,12 +242,34 @@ for PROGRAM in "${!PROGRAMS[@]}"; do
     echo "Starting performance tests for program: $PROGRAM"
 
     for MODE in "${MODES[@]}"; do
-        for THREAD in "${THREADS[@]}"; do
-            for DATA_SIZE in "${DATA_SIZES[@]}"; do
-                echo "  Configuration: Mode=$MODE, Threads=$THREAD, Data_Size=$DATA_SIZE"
-
-                for RUN in $(seq 1 "$ITERATIONS"); do
-                    run_perf_and_log "$PROGRAM" "$MODE" "$DATA_SIZE" "$THREAD" "$RUN"
+        OPTION_SETS=("")
+        if [ -n "${PROGRAM_OPTIONS[$PROGRAM $MODE]}" ]; then
+            IFS=';' read -r -a OPTION_SETS <<< "${PROGRAM_OPTIONS[$PROGRAM $MODE]}"
+        fi
+
+        for OPTIONS in "${OPTION_SETS[@]}"; do
+            if [ -n "$CACHE_STATE" ] && [[ " $CACHE_STATE_PROGRAMS " == *" $PROGRAM "* ]]; then
+                OPTIONS="${OPTIONS:+$OPTIONS }--cache=$CACHE_STATE"
+            fi
+            if [ -n "$PREFAULT" ] && [[ " $PREFAULT_PROGRAMS " == *" $PROGRAM "* ]]; then
+                OPTIONS="${OPTIONS:+$OPTIONS }--prefault=$PREFAULT"
+            fi
+            for THREAD in "${THREADS[@]}"; do
+                for DATA_SIZE in "${DATA_SIZES[@]}"; do
+                    echo "  Configuration: Mode=$MODE, Threads=$THREAD, Data_Size=$DATA_SIZE, Options=$OPTIONS"
+
+                    for RUN in $(seq 1 "$ITERATIONS"); do
+                        run_perf_and_log "$PROGRAM" "$MODE" "$DATA_SIZE" "$THREAD" "$RUN" "$OPTIONS"
+                    done
+
+                    # The same configuration with its threads on each representative CPU pair
+                    if [ "$THREAD" = "$PIN_THREADS" ]; then
+                        for PIN in "${PIN_PAIRS[@]}"; do
+                            for RUN in $(seq 1 "$ITERATIONS"); do
+                                run_perf_and_log "$PROGRAM" "$MODE" "$DATA_SIZE" "$THREAD" "$RUN" "$OPTIONS" "$PIN"
+                            done
+                        done
+                    fi
                 done
             done
         done
@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <time.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Dependent pointer chasing: every load address comes from the previous load
+// - Linked lists and binary trees whose nodes are laid out in sequential, random or
+//   clustered (random within page-sized groups) order
+// - Per-thread private structures or one structure shared by all threads
+// - Reporting nanoseconds per hop, i.e. latency-bound rather than bandwidth-bound access
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Nodes per cluster in clustered order (64 nodes of 64 bytes = one 4 KiB page)
+#define DEFAULT_CLUSTER_NODES 64
+
+// List node padded to a full cache line so every hop touches a new line
+typedef struct ListNode {
+    struct ListNode *next;
+    unsigned long value;
+    char padding[CACHE_LINE_SIZE - sizeof(struct ListNode *) - sizeof(unsigned long)];
+} ListNode;
+
+// Tree node padded to a full cache line
+typedef struct TreeNode {
+    struct TreeNode *child[2];
+    unsigned long value;
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(struct TreeNode *) - sizeof(unsigned long)];
+} TreeNode;
+
+typedef enum {
+    ORDER_SEQUENTIAL,
+    ORDER_RANDOM,
+    ORDER_CLUSTERED
+} NodeOrder;
+
+// Function to shuffle an array of indices for random access
+void shuffle_indices(unsigned long *indices, unsigned long size, unsigned int *seed) {
+    for (unsigned long i = size - 1; i > 0; i--) {
+        unsigned long j = ((unsigned long) rand_r(seed) * ((unsigned long) RAND_MAX + 1) + rand_r(seed)) % (i + 1);
+        unsigned long temp = indices[i];
+        indices[i] = indices[j];
+        indices[j] = temp;
+    }
+}
+
+// Function to build the placement order: slot[k] is the memory slot of logical node k
+unsigned long *build_order(unsigned long size, NodeOrder order, unsigned long cluster, unsigned int *seed) {
+    unsigned long *slot = (unsigned long *) malloc(size * sizeof(unsigned long));
+    if (!slot) {
+        fprintf(stderr, "Memory allocation failed for the node order.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned long i = 0; i < size; i++) slot[i] = i;
+
+    if (order == ORDER_RANDOM) {
+        shuffle_indices(slot, size, seed);
+    } else if (order == ORDER_CLUSTERED) {
+        for (unsigned long begin = 0; begin < size; begin += cluster) {
+            unsigned long len = (size - begin < cluster) ? size - begin : cluster;
+            if (len > 1) shuffle_indices(slot + begin, len, seed);
+        }
+    }
+    return slot;
+}
+
+// Function to allocate and link a circular list of 'size' nodes in the given order. The pool is
+// prefaulted as requested over 'num_threads' threads of 'backend' before it is linked.
+ListNode *build_list(unsigned long size, NodeOrder order, unsigned long cluster, unsigned int *seed, ListNode **head,
+                     PrefaultMode prefault, int num_threads, ThreadBackend backend) {
+    ListNode *pool = NULL;
+    if (posix_memalign((void **) &pool, CACHE_LINE_SIZE, size * sizeof(ListNode)) != 0) {
+        fprintf(stderr, "Memory allocation failed for %lu list nodes.\n", size);
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, pool, size, sizeof(ListNode), 1, num_threads, PARTITION_LINE, backend);
+    unsigned long *slot = build_order(size, order, cluster, seed);
+    for (unsigned long k = 0; k < size; k++) {
+        ListNode *node = &pool[slot[k]];
+        node->next = &pool[slot[(k + 1) % size]];
+        node->value = k + 1;
+    }
+    *head = &pool[slot[0]];
+    free(slot);
+    return pool;
+}
+
+// Function to allocate and link a complete binary tree of 'size' nodes (BFS numbering) in the given
+// order, prefaulted as for build_list()
+TreeNode *build_tree(unsigned long size, NodeOrder order, unsigned long cluster, unsigned int *seed, TreeNode **root,
+                     PrefaultMode prefault, int num_threads, ThreadBackend backend) {
+    TreeNode *pool = NULL;
+    if (posix_memalign((void **) &pool, CACHE_LINE_SIZE, size * sizeof(TreeNode)) != 0) {
+        fprintf(stderr, "Memory allocation failed for %lu tree nodes.\n", size);
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, pool, size, sizeof(TreeNode), 1, num_threads, PARTITION_LINE, backend);
+    unsigned long *slot = build_order(size, order, cluster, seed);
+    for (unsigned long k = 0; k < size; k++) {
+        TreeNode *node = &pool[slot[k]];
+        node->child[0] = (2 * k + 1 < size) ? &pool[slot[2 * k + 1]] : NULL;
+        node->child[1] = (2 * k + 2 < size) ? &pool[slot[2 * k + 2]] : NULL;
+        node->value = k + 1;
+    }
+    *root = &pool[slot[0]];
+    free(slot);
+    return pool;
+}
+
+// Function to follow 'hops' next pointers starting at 'node'
+unsigned long chase_list(ListNode *node, unsigned long hops) {
+    unsigned long sum = 0;
+    for (unsigned long h = 0; h < hops; h++) {
+        sum += node->value;
+        node = node->next;
+    }
+    return sum;
+}
+
+// Function to perform random root-to-leaf descents totalling 'hops' child hops
+unsigned long chase_tree(TreeNode *root, unsigned long hops, unsigned long seed) {
+    unsigned long sum = 0;
+    unsigned long state = seed | 1;
+    TreeNode *node = root;
+    for (unsigned long h = 0; h < hops; h++) {
+        sum += node->value;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        TreeNode *next = node->child[state & 1];
+        node = next ? next : root;
+    }
+    return sum;
+}
+
+// Per-thread chase result, one cache line each
+typedef struct {
+    unsigned long sum;
+    double elapsed;
+} __attribute__((aligned(CACHE_LINE_SIZE))) ChaseResult;
+
+// Shared state of the build and chase regions, handed to the per-thread bodies on every backend
+typedef struct {
+    unsigned long size;
+    NodeOrder order;
+    unsigned long cluster;
+    int use_tree;
+    int shared;
+    PrefaultMode prefault;
+    unsigned long hops;
+    void **pools;
+    ListNode **heads;
+    TreeNode **roots;
+    ChaseResult *results;
+} ChaseContext;
+
+// Per-thread body: build the thread's private structure (first-touched, or prefaulted by a
+// one-thread OpenMP team on this thread), or find its starting point in the shared list
+void build_body(int tid, int num_threads, void *arg) {
+    ChaseContext *ctx = (ChaseContext *) arg;
+    unsigned long size = ctx->size;
+
+    if (!ctx->shared) {
+        unsigned int seed = (unsigned) time(NULL) ^ (unsigned) (tid * 2654435761u);
+        if (ctx->use_tree) {
+            ctx->pools[tid] = build_tree(size, ctx->order, ctx->cluster, &seed, &ctx->roots[tid], ctx->prefault, 1,
+                                         BACKEND_OPENMP);
+        } else {
+            ctx->pools[tid] = build_list(size, ctx->order, ctx->cluster, &seed, &ctx->heads[tid], ctx->prefault, 1,
+                                         BACKEND_OPENMP);
+        }
+    } else if (!ctx->use_tree) {
+        // Spread the threads' starting points evenly around the shared list
+        unsigned long skip = (size / num_threads) * tid;
+        for (unsigned long s = 0; s < skip; s++) ctx->heads[tid] = ctx->heads[tid]->next;
+    }
+}
+
+// Per-thread body: chase 'hops' pointers from the thread's starting point
+void chase_body(int tid, int num_threads, void *arg) {
+    (void) num_threads;
+    ChaseContext *ctx = (ChaseContext *) arg;
+    double start_time = omp_get_wtime();
+
+    unsigned long sum;
+    if (ctx->use_tree) {
+        sum = chase_tree(ctx->roots[tid], ctx->hops, (unsigned long) (tid + 1) * 0x9E3779B97F4A7C15UL);
+    } else {
+        sum = chase_list(ctx->heads[tid], ctx->hops);
+    }
+
+    ctx->results[tid].sum = sum;
+    ctx->results[tid].elapsed = omp_get_wtime() - start_time;
+}
+
+const char *order_name(NodeOrder order) {
+    switch (order) {
+    case ORDER_SEQUENTIAL: return "sequential";
+    case ORDER_RANDOM: return "random";
+    case ORDER_CLUSTERED: return "clustered";
+    }
+    return "unknown";
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-ma|clustered] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good      : nodes laid out in traversal order (prefetch-friendly)\n");
+    fprintf(stderr, "  bad-ma    : nodes laid out in a random permutation (latency-bound chasing)\n");
+    fprintf(stderr, "  clustered : random order within page-sized clusters, clusters in order\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --structure=list|tree     linked list or complete binary tree (default list)\n");
+    fprintf(stderr, "  --sharing=shared|private  one structure for all threads or one per thread (default shared)\n");
+    fprintf(stderr, "  --cluster=N               nodes per cluster in clustered order (default 64)\n");
+    fprintf(stderr, "  --passes=N                hops per thread = passes * size (default 4)\n");
+    fprintf(stderr, "  --cache=STATE             cache state the chase starts from: none, warm, cold-stream,\n");
+    fprintf(stderr, "                            cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M              fault the nodes in before they are linked: none, populate or touch\n");
+    fprintf(stderr, "                            (default none)\n");
+    fprintf(stderr, "  --backend=openmp|pthread|pool  runtime that runs the build and chase regions (default openmp)\n");
+    fprintf(stderr, "size is the number of nodes per structure.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    NodeOrder order;
+    if (strcmp(mode, "good") == 0) {
+        order = ORDER_SEQUENTIAL;
+    } else if (strcmp(mode, "bad-ma") == 0) {
+        order = ORDER_RANDOM;
+    } else if (strcmp(mode, "clustered") == 0) {
+        order = ORDER_CLUSTERED;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    int use_tree = 0;
+    int shared = 1;
+    unsigned long cluster = DEFAULT_CLUSTER_NODES;
+    unsigned long passes = 4;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--structure=list") == 0) {
+            use_tree = 0;
+        } else if (strcmp(argv[i], "--structure=tree") == 0) {
+            use_tree = 1;
+        } else if (strcmp(argv[i], "--sharing=shared") == 0) {
+            shared = 1;
+        } else if (strcmp(argv[i], "--sharing=private") == 0) {
+            shared = 0;
+        } else if (strncmp(argv[i], "--cluster=", 10) == 0) {
+            cluster = atol(argv[i] + 10);
+        } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+            passes = atol(argv[i] + 9);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (cluster == 0 || passes == 0) {
+        fprintf(stderr, "Error: --cluster and --passes must be positive integers.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    unsigned long hops = passes * size;
+    unsigned long total_sum = 0;
+    double elapsed = 0.0;
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    // Shared structure: built once, every thread starts at a different node
+    void *shared_pool = NULL;
+    ListNode *shared_head = NULL;
+    TreeNode *shared_root = NULL;
+    if (shared) {
+        unsigned int seed = (unsigned) time(NULL);
+        if (use_tree) {
+            shared_pool = build_tree(size, order, cluster, &seed, &shared_root, prefault, num_threads, backend);
+        } else {
+            shared_pool = build_list(size, order, cluster, &seed, &shared_head, prefault, num_threads, backend);
+        }
+    }
+
+    // Per-thread structures (private sharing) and starting points
+    void **pools = (void **) calloc(num_threads, sizeof(void *));
+    ListNode **heads = (ListNode **) calloc(num_threads, sizeof(ListNode *));
+    TreeNode **roots = (TreeNode **) calloc(num_threads, sizeof(TreeNode *));
+    ChaseResult *results = NULL;
+    if (posix_memalign((void **) &results, CACHE_LINE_SIZE, num_threads * sizeof(ChaseResult)) != 0) results = NULL;
+    if (!pools || !heads || !roots || !results) {
+        fprintf(stderr, "Memory allocation failed for the per-thread structures.\n");
+        return EXIT_FAILURE;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        heads[t] = shared_head;
+        roots[t] = shared_root;
+    }
+
+    // Private structures are built (and first-touched, or prefaulted) by the thread that walks them
+    ChaseContext ctx = { size, order, cluster, use_tree, shared, prefault, hops, pools, heads, roots, results };
+    backend_run(backend, num_threads, build_body, &ctx);
+
+    // Put the nodes in the requested cache state: the shared pool split over the threads, or
+    // each private pool on the thread that walks it
+    if (shared) {
+        CacheRegion region = { shared_pool, size, CACHE_LINE_SIZE, 0 };
+        cache_state_prepare(cache, &region, 1, num_threads, PARTITION_LINE, backend);
+    } else {
+        CacheRegion *regions = (CacheRegion *) malloc(num_threads * sizeof(CacheRegion));
+        if (!regions) {
+            fprintf(stderr, "Memory allocation failed for the per-thread structures.\n");
+            return EXIT_FAILURE;
+        }
+        for (int t = 0; t < num_threads; t++) {
+            regions[t] = (CacheRegion) { pools[t], size, CACHE_LINE_SIZE, 0 };
+        }
+        cache_state_prepare_private(cache, regions, num_threads, num_threads, backend);
+        free(regions);
+    }
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+
+    backend_run(backend, num_threads, chase_body, &ctx);
+    fault_phase_report(&faults, "kernel");
+
+    // Combine the per-thread results: total checksum, slowest thread's time
+    for (int t = 0; t < num_threads; t++) {
+        total_sum += results[t].sum;
+        if (results[t].elapsed > elapsed) elapsed = results[t].elapsed;
+    }
+
+    for (int t = 0; t < num_threads; t++) free(pools[t]);
+    free(pools);
+    free(heads);
+    free(roots);
+    free(results);
+    free(shared_pool);
+
+    printf("Mode: %s (%s %s, %s node order)\n", mode, shared ? "shared" : "private",
+           use_tree ? "tree" : "list", order_name(order));
+    printf("Size: %lu nodes (%lu bytes each)\n", size, (unsigned long) CACHE_LINE_SIZE);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Hops per Thread: %lu\n", hops);
+    printf("Checksum: %lu\n", total_sum);
+    printf("Latency: %.2f ns per hop\n", elapsed * 1e9 / (double) hops);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#ifndef PREFAULT_H
+#define PREFAULT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "partition.h"
+#include "thread_backend.h"
+
+// Page prefaulting and per-phase page-fault accounting.
+//
+// Where an array takes its page faults decides what the timer sees: sc_28 and sc_29 fault their
+// arrays in during load_array, before the timer starts, while vec_23 first touches its matrix
+// inside the timed kernel, so its time is largely fault handling. --prefault faults the arrays
+// in right after allocation:
+//   none     - leave faulting to initialisation or the kernel (the original behaviour)
+//   populate - madvise(MADV_POPULATE_WRITE), or MADV_POPULATE_READ for data only read through a
+//              file mapping, so the kernel fills the page tables in one call (Linux 5.14+;
+//              older kernels fall back to touch). All pages come from the calling thread's node.
+//   touch    - each thread of the kernel's backend touches one byte per page of its own
+//              partition, so pages are also placed on the node of the thread that uses them
+// Independently, FaultPhase reports the minor and major faults and the system time of a phase
+// (setup, kernel). Fault handling is where these programs spend their system time, so the latter
+// approximates the time spent in the fault handler.
+
+// Define base page size used as touch stride
+#define PREFAULT_PAGE_SIZE 4096
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+typedef enum {
+    PREFAULT_NONE,
+    PREFAULT_POPULATE,
+    PREFAULT_TOUCH
+} PrefaultMode;
+
+static inline const char *prefault_mode_name(PrefaultMode mode) {
+    switch (mode) {
+    case PREFAULT_NONE: return "none";
+    case PREFAULT_POPULATE: return "populate";
+    case PREFAULT_TOUCH: return "touch";
+    }
+    return "unknown";
+}
+
+// Function to parse a --prefault=<mode> argument.
+// Returns 1 if the argument was consumed, 0 if it is not a prefault option, -1 if invalid.
+static inline int prefault_parse_option(const char *arg, PrefaultMode *mode) {
+    if (strncmp(arg, "--prefault=", 11) != 0) return 0;
+    const char *value = arg + 11;
+    if (strcmp(value, "none") == 0) *mode = PREFAULT_NONE;
+    else if (strcmp(value, "populate") == 0) *mode = PREFAULT_POPULATE;
+    else if (strcmp(value, "touch") == 0) *mode = PREFAULT_TOUCH;
+    else {
+        fprintf(stderr, "Invalid prefault mode: %s (expected none, populate or touch)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+// Function to access one byte in every page of [begin, end), each within the range
+static inline void prefault_touch(unsigned char *begin, unsigned char *end, int written) {
+    for (unsigned char *p = begin; p < end;
+         p = (unsigned char *) (((uintptr_t) p & ~(uintptr_t) (PREFAULT_PAGE_SIZE - 1)) + PREFAULT_PAGE_SIZE)) {
+        volatile unsigned char *q = p;
+        if (written) {
+            *q = *q;
+        } else {
+            (void) *q;
+        }
+    }
+}
+
+// Range touched by prefault_touch_body()
+typedef struct {
+    unsigned char *base;
+    unsigned long count;
+    size_t elem_size;
+    int written;
+    PartitionPolicy policy;
+} PrefaultContext;
+
+// Per-thread body of touch: fault in the own partition
+static void prefault_touch_body(int tid, int num_threads, void *arg) {
+    PrefaultContext *ctx = (PrefaultContext *) arg;
+    unsigned long first, last;
+    partition_range(ctx->base, ctx->count, ctx->elem_size, ctx->policy, num_threads, tid, &first, &last);
+    prefault_touch(ctx->base + first * ctx->elem_size, ctx->base + last * ctx->elem_size, ctx->written);
+}
+
+// Function to fault in 'count' elements of 'elem_size' bytes at 'base'. 'written' asks for
+// writable pages: set it for anonymous memory (a read would only map the shared zero page) and
+// for file mappings the kernel writes. 'policy' and 'backend' are the kernel's partition and
+// threading backend, used by touch.
+static inline void prefault_range(PrefaultMode mode, void *base, unsigned long count, size_t elem_size,
+                                  int written, int num_threads, PartitionPolicy policy, ThreadBackend backend) {
+    if (mode == PREFAULT_NONE || !base || count == 0) return;
+
+    if (mode == PREFAULT_POPULATE) {
+        uintptr_t start = (uintptr_t) base & ~(uintptr_t) (PREFAULT_PAGE_SIZE - 1);
+        uintptr_t end = (uintptr_t) base + count * elem_size;
+        if (madvise((void *) start, end - start, written ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0) {
+            return;
+        }
+        // Kernel without MADV_POPULATE_*: touch instead
+    }
+
+    PrefaultContext ctx = { (unsigned char *) base, count, elem_size, written, policy };
+    backend_run(backend, num_threads, prefault_touch_body, &ctx);
+}
+
+// Function to print the prefault mode (nothing for none)
+static inline void prefault_report(PrefaultMode mode) {
+    if (mode == PREFAULT_NONE) return;
+    printf("Prefault: %s\n", prefault_mode_name(mode));
+}
+
+// Resource usage at the start of a phase
+typedef struct {
+    long minflt;
+    long majflt;
+    double sys_time;
+} FaultPhase;
+
+static inline void fault_phase_begin(FaultPhase *phase) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    phase->minflt = usage.ru_minflt;
+    phase->majflt = usage.ru_majflt;
+    phase->sys_time = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Function to compute the faults and system time since fault_phase_begin()
+static inline void fault_phase_delta(const FaultPhase *phase, FaultPhase *delta) {
+    FaultPhase now;
+    fault_phase_begin(&now);
+    delta->minflt = now.minflt - phase->minflt;
+    delta->majflt = now.majflt - phase->majflt;
+    delta->sys_time = now.sys_time - phase->sys_time;
+}
+
+// Function to print the faults and system time of a phase from its delta
+static inline void fault_phase_print(const FaultPhase *delta, const char *name) {
+    printf("Faults (%s): minor %ld, major %ld, sys %f seconds\n", name, delta->minflt, delta->majflt,
+           delta->sys_time);
+}
+
+// Function to print the faults and system time since fault_phase_begin()
+static inline void fault_phase_report(const FaultPhase *phase, const char *name) {
+    FaultPhase delta;
+    fault_phase_delta(phase, &delta);
+    fault_phase_print(&delta, name);
+}
+
+#endif // PREFAULT_H
@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Read-write false sharing: one writer thread updates its field while the other threads only
+//   read their own, never-written fields on the same cache line (e.g. a flag next to a hot counter)
+// - Three layouts: packed (writer and reader fields on one line), padded (every field on its own
+//   line) and hot-cold (the writer's hot field on its own line, the readers' cold fields packed
+//   together on another line that nobody writes)
+// - A configurable write rate (--write-every), and reader and writer throughput reported separately
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Readers check the writer's completion flag once per this many reads
+#define READ_BATCH 1024
+
+// Field layouts
+typedef enum {
+    LAYOUT_PACKED,   // writer field, then every reader field, back-to-back
+    LAYOUT_PADDED,   // each field on its own cache line
+    LAYOUT_HOT_COLD  // writer field on its own line, reader fields packed on the following lines
+} FieldLayout;
+
+// The writer's field and each reader's field, placed inside one aligned block
+typedef struct {
+    char *base;
+    _Atomic unsigned long *writer;
+    _Atomic unsigned long **readers;    // readers[r] for r = 0 .. num_readers-1
+    int num_readers;
+    FieldLayout layout;
+} SharedFields;
+
+// Per-thread results, one cache line each
+typedef struct {
+    unsigned long ops;
+    unsigned long checksum;
+    double elapsed;
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(unsigned long) - sizeof(double)];
+} ThreadResult;
+
+// Start line and completion flag of a run, each on its own cache line
+typedef struct {
+    atomic_int ready __attribute__((aligned(CACHE_LINE_SIZE)));
+    atomic_int done __attribute__((aligned(CACHE_LINE_SIZE)));
+} RunControl;
+
+// Shared state of the run, handed to the per-thread body on every backend
+typedef struct {
+    SharedFields *fields;
+    unsigned long size;
+    unsigned long write_every;
+    ThreadResult *results;
+    RunControl *control;
+} RunContext;
+
+const char *layout_name(FieldLayout layout) {
+    switch (layout) {
+    case LAYOUT_PACKED: return "packed";
+    case LAYOUT_PADDED: return "padded";
+    case LAYOUT_HOT_COLD: return "hot-cold";
+    }
+    return "unknown";
+}
+
+// Function to place the writer and reader fields according to the layout.
+// Reader r's field holds r + 1, so every read can be checked. The lines are prefaulted as requested.
+void init_shared_fields(SharedFields *fields, FieldLayout layout, int num_readers, PrefaultMode prefault,
+                        ThreadBackend backend) {
+    size_t words_per_line = CACHE_LINE_SIZE / sizeof(unsigned long);
+    size_t lines = (size_t) num_readers + 2;
+    size_t bytes = lines * CACHE_LINE_SIZE;
+
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, bytes) != 0) ptr = NULL;
+    fields->readers = (_Atomic unsigned long **) malloc((num_readers + 1) * sizeof(_Atomic unsigned long *));
+    if (!ptr || !fields->readers) {
+        fprintf(stderr, "Memory allocation failed for the shared fields.\n");
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, ptr, lines, CACHE_LINE_SIZE, 1, num_readers + 1, PARTITION_LINE, backend);
+    memset(ptr, 0, bytes);
+    fields->base = (char *) ptr;
+    fields->layout = layout;
+    fields->num_readers = num_readers;
+
+    _Atomic unsigned long *words = (_Atomic unsigned long *) ptr;
+    fields->writer = &words[0];
+    for (int r = 0; r < num_readers; r++) {
+        switch (layout) {
+        case LAYOUT_PACKED:
+            fields->readers[r] = &words[1 + r];
+            break;
+        case LAYOUT_PADDED:
+            fields->readers[r] = &words[(size_t) (1 + r) * words_per_line];
+            break;
+        case LAYOUT_HOT_COLD:
+            fields->readers[r] = &words[words_per_line + r];
+            break;
+        }
+        atomic_store_explicit(fields->readers[r], (unsigned long) r + 1, memory_order_relaxed);
+    }
+}
+
+// Function to report how many reader fields share the writer's cache line
+int readers_on_writer_line(const SharedFields *fields) {
+    int count = 0;
+    for (int r = 0; r < fields->num_readers; r++) {
+        if ((char *) fields->readers[r] - fields->base < CACHE_LINE_SIZE) count++;
+    }
+    return count;
+}
+
+// Per-thread body: thread 0 is the writer, the others are readers. Every thread waits at the
+// start line first, since the pthread backend starts its threads one after another.
+void kernel_body(int tid, int num_threads, void *arg) {
+    RunContext *ctx = (RunContext *) arg;
+    RunControl *control = ctx->control;
+    ThreadResult *result = &ctx->results[tid];
+
+    atomic_fetch_add_explicit(&control->ready, 1, memory_order_acq_rel);
+    while (atomic_load_explicit(&control->ready, memory_order_acquire) < num_threads) {
+        sched_yield();
+    }
+
+    double start_time = omp_get_wtime();
+    if (tid == 0) {
+        // Writer: relaxed load + store (single writer), other iterations only count
+        _Atomic unsigned long *field = ctx->fields->writer;
+        unsigned long writes = 0;
+        for (unsigned long i = 0; i < ctx->size; i++) {
+            if (i % ctx->write_every == 0) {
+                unsigned long v = atomic_load_explicit(field, memory_order_relaxed);
+                atomic_store_explicit(field, v + 1, memory_order_relaxed);
+                writes++;
+            }
+        }
+        atomic_store_explicit(&control->done, 1, memory_order_release);
+        result->ops = writes;
+        result->checksum = writes;
+    } else {
+        // Reader: its own field only, never written during the run
+        _Atomic unsigned long *field = ctx->fields->readers[tid - 1];
+        unsigned long reads = 0;
+        unsigned long sum = 0;
+        while (!atomic_load_explicit(&control->done, memory_order_acquire)) {
+            for (int k = 0; k < READ_BATCH; k++) {
+                sum += atomic_load_explicit(field, memory_order_relaxed);
+            }
+            reads += READ_BATCH;
+        }
+        result->ops = reads;
+        result->checksum = sum;
+    }
+    result->elapsed = omp_get_wtime() - start_time;
+}
+
+// Function to run one writer (thread 0) and num_threads - 1 readers.
+// The writer performs 'size' iterations and stores to its field every 'write_every'-th one;
+// the readers read their own field until the writer is done.
+void run_kernel(SharedFields *fields, unsigned long size, unsigned long write_every, int num_threads,
+                ThreadBackend backend, ThreadResult *results) {
+    RunControl *control = NULL;
+    if (posix_memalign((void **) &control, CACHE_LINE_SIZE, sizeof(RunControl)) != 0) {
+        fprintf(stderr, "Memory allocation failed for the completion flag.\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&control->ready, 0);
+    atomic_init(&control->done, 0);
+
+    RunContext ctx = { fields, size, write_every, results, control };
+    backend_run(backend, num_threads, kernel_body, &ctx);
+
+    free(control);
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|hot-cold] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good     : writer and reader fields each on their own cache line\n");
+    fprintf(stderr, "  bad-fs   : writer and reader fields packed on one line (read-write false sharing)\n");
+    fprintf(stderr, "  hot-cold : writer field on its own line, reader fields packed on a read-only line\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --write-every=K  the writer stores every K-th iteration (default 1)\n");
+    fprintf(stderr, "  --cache=STATE    cache state the run starts from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M     fault the fields and results in before initialisation: none, populate or touch\n");
+    fprintf(stderr, "                   (default none)\n");
+    fprintf(stderr, "  --backend=B      runtime that runs the writer and readers: openmp, pthread or pool (default openmp)\n");
+    fprintf(stderr, "size is the number of writer iterations; thread 0 writes, the others read.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    FieldLayout layout;
+    if (strcmp(mode, "good") == 0) {
+        layout = LAYOUT_PADDED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        layout = LAYOUT_PACKED;
+    } else if (strcmp(mode, "hot-cold") == 0) {
+        layout = LAYOUT_HOT_COLD;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    unsigned long write_every = 1;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--write-every=", 14) == 0) {
+            write_every = atol(argv[i] + 14);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (write_every == 0) {
+        fprintf(stderr, "Error: --write-every must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    int num_readers = num_threads - 1;
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    SharedFields fields;
+    init_shared_fields(&fields, layout, num_readers, prefault, backend);
+
+    ThreadResult *results = NULL;
+    if (posix_memalign((void **) &results, CACHE_LINE_SIZE, num_threads * sizeof(ThreadResult)) != 0) {
+        fprintf(stderr, "Memory allocation failed for per-thread results.\n");
+        return EXIT_FAILURE;
+    }
+    prefault_range(prefault, results, num_threads, sizeof(ThreadResult), 1, num_threads, PARTITION_LINE, backend);
+    memset(results, 0, num_threads * sizeof(ThreadResult));
+
+    // Put each thread's field and result slot in the requested cache state on that thread, so a
+    // warm run starts with every reader holding its field's line and the writer holding its own
+    CacheRegion *regions = (CacheRegion *) malloc(2 * num_threads * sizeof(CacheRegion));
+    if (!regions) {
+        fprintf(stderr, "Memory allocation failed for per-thread results.\n");
+        return EXIT_FAILURE;
+    }
+    regions[0] = (CacheRegion) { (void *) fields.writer, 1, sizeof(unsigned long), 1 };
+    for (int t = 1; t < num_threads; t++) {
+        regions[t] = (CacheRegion) { (void *) fields.readers[t - 1], 1, sizeof(unsigned long), 0 };
+    }
+    for (int t = 0; t < num_threads; t++) {
+        regions[num_threads + t] = (CacheRegion) { &results[t], 1, sizeof(ThreadResult), 1 };
+    }
+    cache_state_prepare_private(cache, regions, 2 * num_threads, num_threads, backend);
+    free(regions);
+    fault_phase_report(&faults, "setup");
+
+    fault_phase_begin(&faults);
+    run_kernel(&fields, size, write_every, num_threads, backend, results);
+    fault_phase_report(&faults, "kernel");
+
+    // Check the writer's field and every reader's sum of its (constant) field
+    unsigned long expected_writes = (size + write_every - 1) / write_every;
+    int ok = atomic_load_explicit(fields.writer, memory_order_relaxed) == expected_writes &&
+             results[0].ops == expected_writes;
+    unsigned long total_reads = 0;
+    double reader_time = 0.0;
+    for (int t = 1; t < num_threads; t++) {
+        if (results[t].checksum != results[t].ops * (unsigned long) t) ok = 0;
+        total_reads += results[t].ops;
+        if (results[t].elapsed > reader_time) reader_time = results[t].elapsed;
+    }
+    double writer_time = results[0].elapsed;
+
+    printf("Mode: %s (layout %s, 1 writer, %d readers, %d on the writer's line, write every %lu)\n",
+           mode, layout_name(layout), num_readers, readers_on_writer_line(&fields), write_every);
+    printf("Size: %lu\n", size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Writer Throughput: %.2f M iterations/s, %.2f M writes/s\n",
+           size / writer_time / 1e6, expected_writes / writer_time / 1e6);
+    if (num_readers > 0) {
+        printf("Reader Throughput: %.2f M reads/s total, %.2f M reads/s per reader\n",
+               total_reads / reader_time / 1e6, total_reads / reader_time / 1e6 / num_readers);
+    } else {
+        printf("Reader Throughput: no readers (one thread)\n");
+    }
+    printf("Check: %s\n", ok ? "ok" : "MISMATCH");
+    printf("Execution Time: %f seconds\n", writer_time);
+
+    free(results);
+    free(fields.readers);
+    free(fields.base);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "partition.h"
+
+// This program demonstrates:
+// - One array sum run with every reduction strategy on identical data and identical ranges
+// - Strategies: OpenMP reduction clause, padded per-thread slots, packed per-thread slots,
+//   a single shared atomic, a critical section and a hierarchical (pairwise tree) combine
+// - Splitting each run into an accumulate phase (every thread sums its range) and a combine
+//   phase (partial sums merged into one result), timed separately
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+typedef enum {
+    STRATEGY_OMP,       // reduction(+:sum) on the parallel construct
+    STRATEGY_PADDED,    // per-element updates to a padded per-thread slot, serial combine
+    STRATEGY_PACKED,    // per-element updates to a packed per-thread slot, serial combine
+    STRATEGY_ATOMIC,    // register accumulation, one atomic add per thread into a shared sum
+    STRATEGY_CRITICAL,  // register accumulation, one critical-section add per thread
+    STRATEGY_TREE,      // register accumulation, pairwise combine over log2(threads) levels
+    NUM_STRATEGIES
+} Strategy;
+
+static const char *strategy_names[NUM_STRATEGIES] = {
+    "omp", "padded", "packed", "atomic", "critical", "tree"
+};
+
+// Structure to prevent false sharing by padding
+typedef struct {
+    unsigned long value;
+    char padding[CACHE_LINE_SIZE - sizeof(unsigned long)];
+} PaddedSlot;
+
+// Per-thread end of the accumulate phase, padded so recording it does not disturb neighbours
+typedef struct {
+    double time;
+    char padding[CACHE_LINE_SIZE - sizeof(double)];
+} PaddedTime;
+
+typedef struct {
+    double accumulate;
+    double combine;
+    unsigned long sum;
+} ReductionResult;
+
+// Function to initialize the array with sequential values
+void load_array(unsigned long *array, unsigned long size) {
+    #pragma omp parallel for schedule(static)
+    for (unsigned long i = 0; i < size; i++) {
+        array[i] = i + 1;
+    }
+}
+
+// Function to run one reduction with the given strategy and time its two phases
+ReductionResult run_reduction(Strategy strategy, unsigned long *array, unsigned long size, int num_threads,
+                              PartitionPolicy policy, PaddedSlot *padded, unsigned long *packed,
+                              PaddedTime *acc_end) {
+    unsigned long sum = 0;
+
+    for (int t = 0; t < num_threads; t++) {
+        padded[t].value = 0;
+        packed[t] = 0;
+    }
+
+    double start_time = omp_get_wtime();
+
+    if (strategy == STRATEGY_OMP) {
+        // The runtime combines the private copies when the region ends
+        #pragma omp parallel reduction(+:sum)
+        {
+            int tid = omp_get_thread_num();
+            unsigned long start, end;
+            partition_range(array, size, sizeof(unsigned long), policy, num_threads, tid, &start, &end);
+            for (unsigned long i = start; i < end; i++) {
+                sum += array[i];
+            }
+            acc_end[tid].time = omp_get_wtime();
+        }
+    } else {
+        #pragma omp parallel
+        {
+            int tid = omp_get_thread_num();
+            unsigned long start, end;
+            partition_range(array, size, sizeof(unsigned long), policy, num_threads, tid, &start, &end);
+
+            unsigned long local = 0;
+            if (strategy == STRATEGY_PADDED) {
+                for (unsigned long i = start; i < end; i++) {
+                    padded[tid].value += array[i];
+                }
+            } else if (strategy == STRATEGY_PACKED) {
+                for (unsigned long i = start; i < end; i++) {
+                    packed[tid] += array[i];
+                }
+            } else {
+                for (unsigned long i = start; i < end; i++) {
+                    local += array[i];
+                }
+            }
+            acc_end[tid].time = omp_get_wtime();
+
+            switch (strategy) {
+            case STRATEGY_PADDED: {
+                #pragma omp barrier
+                #pragma omp master
+                {
+                    for (int t = 0; t < num_threads; t++) sum += padded[t].value;
+                }
+                break;
+            }
+            case STRATEGY_PACKED: {
+                #pragma omp barrier
+                #pragma omp master
+                {
+                    for (int t = 0; t < num_threads; t++) sum += packed[t];
+                }
+                break;
+            }
+            case STRATEGY_ATOMIC:
+                #pragma omp atomic
+                sum += local;
+                break;
+            case STRATEGY_CRITICAL:
+                #pragma omp critical
+                {
+                    sum += local;
+                }
+                break;
+            case STRATEGY_TREE: {
+                // Level k: thread t (t a multiple of 2^(k+1)) adds the slot of thread t + 2^k
+                padded[tid].value = local;
+                for (int stride = 1; stride < num_threads; stride *= 2) {
+                    #pragma omp barrier
+                    if (tid % (2 * stride) == 0 && tid + stride < num_threads) {
+                        padded[tid].value += padded[tid + stride].value;
+                    }
+                }
+                #pragma omp barrier
+                #pragma omp master
+                {
+                    sum = padded[0].value;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    double end_time = omp_get_wtime();
+
+    // The combine phase starts when the slowest thread finishes accumulating
+    double last_acc = start_time;
+    for (int t = 0; t < num_threads; t++) {
+        if (acc_end[t].time > last_acc) last_acc = acc_end[t].time;
+    }
+
+    ReductionResult result;
+    result.accumulate = last_acc - start_time;
+    result.combine = end_time - last_acc;
+    result.sum = sum;
+    return result;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [all|omp|padded|packed|atomic|critical|tree|good|bad-fs] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Strategies:\n");
+    fprintf(stderr, "  omp      : reduction(+:sum) clause\n");
+    fprintf(stderr, "  padded   : padded per-thread slots updated per element, serial combine (alias: good)\n");
+    fprintf(stderr, "  packed   : packed per-thread slots updated per element, serial combine (alias: bad-fs)\n");
+    fprintf(stderr, "  atomic   : private accumulation, one atomic add per thread\n");
+    fprintf(stderr, "  critical : private accumulation, one critical-section add per thread\n");
+    fprintf(stderr, "  tree     : private accumulation, pairwise tree combine\n");
+    fprintf(stderr, "  all      : every strategy above, one after the other\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --reps=N                         repetitions per strategy, times are averaged (default 5)\n");
+    fprintf(stderr, "  --partition=naive|line|page|numa range split policy (default line)\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    int first = 0, last = NUM_STRATEGIES - 1;
+    if (strcmp(mode, "good") == 0) {
+        first = last = STRATEGY_PADDED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        first = last = STRATEGY_PACKED;
+    } else if (strcmp(mode, "all") != 0) {
+        first = -1;
+        for (int s = 0; s < NUM_STRATEGIES; s++) {
+            if (strcmp(mode, strategy_names[s]) == 0) first = last = s;
+        }
+        if (first < 0) {
+            fprintf(stderr, "Invalid mode: %s\n", mode);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Parse optional arguments
+    int reps = 5;
+    PartitionPolicy policy = PARTITION_LINE;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--reps=", 7) == 0) {
+            reps = atoi(argv[i] + 7);
+            continue;
+        }
+        int parsed = partition_parse_option(argv[i], &policy);
+        if (parsed == 0) {
+            fprintf(stderr, "Invalid option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (parsed < 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (reps <= 0) {
+        fprintf(stderr, "Error: --reps must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    unsigned long *array = (unsigned long *) malloc(size * sizeof(unsigned long));
+    PaddedSlot *padded = NULL;
+    PaddedTime *acc_end = NULL;
+    unsigned long *packed = (unsigned long *) malloc(num_threads * sizeof(unsigned long));
+    if (!array || !packed ||
+        posix_memalign((void **) &padded, CACHE_LINE_SIZE, num_threads * sizeof(PaddedSlot)) != 0 ||
+        posix_memalign((void **) &acc_end, CACHE_LINE_SIZE, num_threads * sizeof(PaddedTime)) != 0) {
+        fprintf(stderr, "Memory allocation failed for size %lu\n", size);
+        return EXIT_FAILURE;
+    }
+    load_array(array, size);
+
+    unsigned long expected = size * (size + 1) / 2;
+    int all_ok = 1;
+    double total_time = 0.0;
+
+    printf("Mode: %s\n", mode);
+    printf("Size: %lu\n", size);
+    printf("Threads: %d\n", num_threads);
+    printf("Partition: %s\n", partition_policy_name(policy));
+    printf("Repetitions: %d\n", reps);
+    printf("%-10s %16s %16s %16s  %s\n", "Strategy", "Accumulate (s)", "Combine (s)", "Total (s)", "Sum");
+
+    for (int s = first; s <= last; s++) {
+        double accumulate = 0.0, combine = 0.0;
+        unsigned long sum = 0;
+        for (int r = 0; r < reps; r++) {
+            ReductionResult result = run_reduction((Strategy) s, array, size, num_threads, policy, padded, packed, acc_end);
+            accumulate += result.accumulate;
+            combine += result.combine;
+            sum = result.sum;
+            if (sum != expected) all_ok = 0;
+        }
+        accumulate /= reps;
+        combine /= reps;
+        total_time += (accumulate + combine) * reps;
+
+        printf("%-10s %16.6f %16.9f %16.6f  %lu (%s)\n", strategy_names[s], accumulate, combine,
+               accumulate + combine, sum, sum == expected ? "ok" : "MISMATCH");
+    }
+
+    printf("Execution Time: %f seconds\n", total_time);
+
+    free(array);
+    free(packed);
+    free(padded);
+    free(acc_end);
+
+    return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,10 +4,11 @@ import matplotlib.pyplot as plt
 import seaborn as sns
 
 from sklearn.model_selection import train_test_split, cross_val_score, GridSearchCV
-from sklearn.preprocessing import StandardScaler, LabelEncoder
+from sklearn.preprocessing import StandardScaler
 from sklearn.linear_model import LogisticRegression
-from sklearn.tree import DecisionTreeClassifier, plot_tree
-from sklearn.metrics import classification_report, confusion_matrix, accuracy_score
+from sklearn.tree import DecisionTreeClassifier
+from sklearn.calibration import CalibratedClassifierCV, calibration_curve
+from sklearn.metrics import classification_report, confusion_matrix, accuracy_score, brier_score_loss, hamming_loss
 from imblearn.over_sampling import SMOTE
 from sklearn.feature_selection import RFE
 
@@ -17,10 +18,24 @@ warnings.filterwarnings('ignore')
 
 # 1. Load the Dataset
 df = pd.read_csv('perf_data.csv')
+# Runs without extra options have an empty Options field; keep them as their own group
+df['Options'] = df['Options'].fillna('')
+# Co-run aggressor rows (older corun_perf.sh wrote them here) span several restarted runs and are
+# no sample of their mode
+df = df[~df['Options'].str.contains('role=aggressor', regex=False)]
+# Mean core-to-core latency of the CPUs a run used (cl_72 matrix); empty without a calibration
+if 'c2c_latency_ns' not in df.columns:
+    df['c2c_latency_ns'] = 0
+df['c2c_latency_ns'] = df['c2c_latency_ns'].fillna(0)
+# Page faults and system time of the timed kernel alone (prefault.h report); 0 for other programs
+for col in ['kernel_faults_minor', 'kernel_faults_major', 'kernel_fault_sys_time']:
+    if col not in df.columns:
+        df[col] = 0
+    df[col] = df[col].fillna(0)
 
 # 2. Data Aggregation: Combine multiple runs per configuration
 # Assuming 3 runs per configuration
-aggregated_df = df.groupby(['Program', 'Mode', 'Threads', 'Data_Size']).agg({
+aggregated_df = df.groupby(['Program', 'Mode', 'Threads', 'Data_Size', 'Options']).agg({
     'cache_references': ['mean', 'std'],
     'cache_misses': ['mean', 'std'],
     'L1_dcache_loads': ['mean', 'std'],
@@ -38,142 +53,187 @@ aggregated_df = df.groupby(['Program', 'Mode', 'Threads', 'Data_Size']).agg({
     'instructions': ['mean', 'std'],
     'elapsed_time': ['mean', 'std'],
     'user_time': ['mean', 'std'],
-    'sys_time': ['mean', 'std']
+    'sys_time': ['mean', 'std'],
+    'page_faults_minor': ['mean', 'std'],
+    'page_faults_major': ['mean', 'std'],
+    'io_wait_time': ['mean', 'std'],
+    'kernel_faults_minor': ['mean', 'std'],
+    'kernel_faults_major': ['mean', 'std'],
+    'kernel_fault_sys_time': ['mean', 'std'],
+    'c2c_latency_ns': ['mean', 'std']
 }).reset_index()
 
 # Flatten MultiIndex columns
 aggregated_df.columns = ['_'.join(col).strip('_') for col in aggregated_df.columns.values]
 
-# 3. Handle Missing Values (if any)
-aggregated_df.dropna(inplace=True)
+# Coherence-related counters normalised by the host's core-to-core latency: the estimated share of
+# each thread's time spent on line transfers, so the same miss count weighs more on a host (or a
+# CPU pair) with slower transfers. 0 when the host has no calibration.
+c2c_seconds = aggregated_df['c2c_latency_ns_mean'] / 1e9
+thread_seconds = aggregated_df['elapsed_time_mean'] * aggregated_df['Threads']
+for counter in ['cache_misses', 'L1_dcache_load_misses']:
+    share = aggregated_df[f'{counter}_mean'] * c2c_seconds / thread_seconds
+    aggregated_df[f'{counter}_c2c_time_share'] = share.replace([np.inf, -np.inf], np.nan).fillna(0)
 
-# 4. Encode the Target Variable
-label_encoder = LabelEncoder()
-aggregated_df['Mode_encoded'] = label_encoder.fit_transform(aggregated_df['Mode_mean'])  # Assuming 'Mode' is the first column
-# Note: Adjust 'Mode_mean' based on your actual column naming after aggregation
+# Share of the run's thread-seconds spent handling page faults in the kernel, so fault cost is a
+# feature of its own rather than noise in the timings
+fault_share = aggregated_df['kernel_fault_sys_time_mean'] / thread_seconds
+aggregated_df['kernel_fault_time_share'] = fault_share.replace([np.inf, -np.inf], np.nan).fillna(0)
 
-# 5. Define Features and Target
-# Exclude 'Program', 'Mode_mean', and 'Mode_std' if present
-feature_columns = [col for col in aggregated_df.columns if col not in ['Program_mean', 'Program_std', 'Mode_mean', 'Mode_std', 'Mode_encoded']]
+# 3. Handle Missing Values (if any)
+aggregated_df.dropna(inplace=True)
+aggregated_df.reset_index(drop=True, inplace=True)
+
+# 4. Multi-label Targets: one binary label per pathology
+# A mode can carry several pathologies (bad-both has packed slots and a random gather at once).
+# Modes outside every list (good, good-alloc and the program-specific variants) are negatives.
+# bad-fs-alloc counts as false sharing: a multi-threaded run whose malloc'd accumulators share
+# no line exits with an error, so every row that reaches the CSV has packed them.
+PATHOLOGIES = {
+    'false_sharing': ['bad-fs', 'bad-fs-alloc', 'bad-both'],
+    'bad_access': ['bad-ma', 'bad-ma-tlb', 'bad', 'bad-both'],
+    'lock_contention': ['bad-lock'],
+    'interference': ['interference'],
+}
+labels = pd.DataFrame({name: aggregated_df['Mode'].isin(modes).astype(int) for name, modes in PATHOLOGIES.items()})
+print("Configurations per pathology:")
+print(labels.sum().to_string())
+
+# 5. Define Features and Targets
+# Exclude the non-numeric group keys
+feature_columns = [col for col in aggregated_df.columns if col not in ['Program', 'Mode', 'Options']]
 
 X = aggregated_df[feature_columns]
-y = aggregated_df['Mode_encoded']
 
 # 6. Split the Data
-X_train, X_test, y_train, y_test = train_test_split(
-    X, y, test_size=0.2, stratify=y, random_state=42
+# Stratify on the mode so every mode, bad-both included, appears in both halves
+X_train, X_test, Y_train, Y_test, mode_train, mode_test = train_test_split(
+    X, labels, aggregated_df['Mode'], test_size=0.2, stratify=aggregated_df['Mode'], random_state=42
 )
 
+# A detector needs enough training configurations of both classes (SMOTE and the calibration use
+# 5 neighbours or folds), so the gate applies to the training split the detectors are fitted on
+MIN_CLASS_COUNT = 10
+detectors = [name for name in PATHOLOGIES if Y_train[name].value_counts().reindex([0, 1], fill_value=0).min() >= MIN_CLASS_COUNT]
+print(f"Detectors trained: {detectors}")
+
 # 7. Normalize the Features
 scaler = StandardScaler()
 X_train_scaled = scaler.fit_transform(X_train)
 X_test_scaled = scaler.transform(X_test)
 
-# 8. Handle Class Imbalance using SMOTE
 smote = SMOTE(random_state=42)
-X_train_res, y_train_res = smote.fit_resample(X_train_scaled, y_train)
-
-# 9. Feature Selection using Lasso Logistic Regression
-logreg = LogisticRegression(penalty='l1', solver='saga', multi_class='multinomial', max_iter=10000, random_state=42)
-logreg.fit(X_train_res, y_train_res)
-
-# Get absolute coefficients
-coef = np.abs(logreg.coef_)
-
-# Average the coefficients across classes
-avg_coef = np.mean(coef, axis=0)
-
-# Create a DataFrame for feature importances
-feature_importance = pd.DataFrame({
-    'Feature': feature_columns,
-    'Importance': avg_coef
-}).sort_values(by='Importance', ascending=False)
-
-# Plot Feature Importances
-plt.figure(figsize=(12, 8))
-sns.barplot(x='Importance', y='Feature', data=feature_importance)
-plt.title('Feature Importance from Lasso Logistic Regression')
-plt.xlabel('Average Absolute Coefficient')
-plt.ylabel('Feature')
-plt.tight_layout()
-plt.show()
-
-# Select features with importance above a threshold (e.g., 0.01)
-threshold = 0.01
-selected_features = feature_importance[feature_importance['Importance'] > threshold]['Feature'].tolist()
-print(f"Selected Features (Importance > {threshold}):")
-print(selected_features)
-
-# 10. Optional: Recursive Feature Elimination (RFE) with Decision Tree
-dt_clf_rfe = DecisionTreeClassifier(criterion='entropy', random_state=42)
-rfe = RFE(estimator=dt_clf_rfe, n_features_to_select=10)
-rfe.fit(X_train_res, y_train_res)
-
-rfe_selected_features = [feature for feature, support in zip(feature_columns, rfe.support_) if support]
-print("Selected Features via RFE:")
-print(rfe_selected_features)
-
-# Combine both feature selection methods
-final_selected_features = list(set(selected_features + rfe_selected_features))
-print("Final Selected Features:")
-print(final_selected_features)
-
-# 11. Retrain the Decision Tree Classifier with Selected Features
-# Extract selected features from the scaled training and testing data
-X_train_final = X_train[final_selected_features]
-X_test_final = X_test[final_selected_features]
-
-# Scale the selected features
-X_train_final_scaled = scaler.fit_transform(X_train_final)
-X_test_final_scaled = scaler.transform(X_test_final)
-
-# Handle class imbalance again on the new selected features
-X_train_final_res, y_train_final_res = smote.fit_resample(X_train_final_scaled, y_train)
-
-# Initialize and Train the Decision Tree Classifier
-dt_clf = DecisionTreeClassifier(criterion='entropy', random_state=42)
-dt_clf.fit(X_train_final_res, y_train_final_res)
-
-# 12. Model Evaluation
-y_pred = dt_clf.predict(X_test_final_scaled)
-
-# Classification Report
-print("Classification Report:")
-print(classification_report(y_test, y_pred, target_names=label_encoder.classes_))
-
-# Confusion Matrix
-conf_matrix = confusion_matrix(y_test, y_pred)
-print("Confusion Matrix:")
-print(conf_matrix)
-
-# Plot Confusion Matrix
-plt.figure(figsize=(8,6))
-sns.heatmap(conf_matrix, annot=True, fmt='d', cmap='Blues',
-            xticklabels=label_encoder.classes_,
-            yticklabels=label_encoder.classes_)
-plt.ylabel('Actual')
-plt.xlabel('Predicted')
-plt.title('Confusion Matrix - Decision Tree Classifier')
-plt.show()
-
-# 13. Cross-Validation
-cv_scores = cross_val_score(dt_clf, X_train_final_res, y_train_final_res, cv=5, scoring='accuracy')
-print(f"Cross-Validation Accuracy Scores: {cv_scores}")
-print(f"Mean Accuracy: {cv_scores.mean()*100:.2f}% ± {cv_scores.std()*100:.2f}%")
-
-# 14. Visualize the Decision Tree
-plt.figure(figsize=(20,10))
-plot_tree(dt_clf, feature_names=final_selected_features, class_names=label_encoder.classes_,
-          filled=True, rounded=True, fontsize=12)
-plt.title('Decision Tree Classifier')
-plt.show()
-
-# 15. Save the Model and Scaler for Future Use
+models = {}
+feature_importances = {}
+test_probabilities = pd.DataFrame(index=X_test.index)
+
+# 8. One independent detector per pathology
+for name in detectors:
+    print(f"===== Detector: {name} =====")
+    y_train = Y_train[name]
+    y_test = Y_test[name]
+
+    # 8a. Handle Class Imbalance using SMOTE (for feature selection)
+    X_train_res, y_train_res = smote.fit_resample(X_train_scaled, y_train)
+
+    # 8b. Feature Selection using Lasso Logistic Regression
+    logreg = LogisticRegression(penalty='l1', solver='saga', max_iter=10000, random_state=42)
+    logreg.fit(X_train_res, y_train_res)
+
+    feature_importance = pd.DataFrame({
+        'Feature': feature_columns,
+        'Importance': np.abs(logreg.coef_[0])
+    }).sort_values(by='Importance', ascending=False)
+    feature_importances[name] = feature_importance
+
+    # Plot Feature Importances
+    plt.figure(figsize=(12, 8))
+    sns.barplot(x='Importance', y='Feature', data=feature_importance)
+    plt.title(f'Feature Importance from Lasso Logistic Regression - {name}')
+    plt.xlabel('Absolute Coefficient')
+    plt.ylabel('Feature')
+    plt.tight_layout()
+    plt.show()
+
+    # Select features with importance above a threshold (e.g., 0.01)
+    threshold = 0.01
+    selected_features = feature_importance[feature_importance['Importance'] > threshold]['Feature'].tolist()
+    print(f"Selected Features (Importance > {threshold}):")
+    print(selected_features)
+
+    # 8c. Recursive Feature Elimination (RFE) with Decision Tree
+    dt_clf_rfe = DecisionTreeClassifier(criterion='entropy', random_state=42)
+    rfe = RFE(estimator=dt_clf_rfe, n_features_to_select=min(10, len(feature_columns)))
+    rfe.fit(X_train_res, y_train_res)
+
+    rfe_selected_features = [feature for feature, support in zip(feature_columns, rfe.support_) if support]
+    print("Selected Features via RFE:")
+    print(rfe_selected_features)
+
+    # Combine both feature selection methods
+    final_selected_features = sorted(set(selected_features + rfe_selected_features))
+    print("Final Selected Features:")
+    print(final_selected_features)
+
+    # 8d. Train a Calibrated Decision Tree on the selected features
+    # The calibration is fitted on the real (not resampled) training data, so the probabilities
+    # follow the actual class frequencies; class weights take the place of SMOTE here.
+    detector_scaler = StandardScaler()
+    X_train_final_scaled = detector_scaler.fit_transform(X_train[final_selected_features])
+    X_test_final_scaled = detector_scaler.transform(X_test[final_selected_features])
+
+    dt_clf = DecisionTreeClassifier(criterion='entropy', class_weight='balanced', random_state=42)
+    calibrated_clf = CalibratedClassifierCV(estimator=dt_clf, method='sigmoid', cv=5)
+    calibrated_clf.fit(X_train_final_scaled, y_train)
+
+    # 8e. Model Evaluation
+    y_prob = calibrated_clf.predict_proba(X_test_final_scaled)[:, 1]
+    y_pred = (y_prob >= 0.5).astype(int)
+    test_probabilities[name] = y_prob
+
+    print("Classification Report:")
+    print(classification_report(y_test, y_pred, labels=[0, 1], target_names=['absent', 'present'], zero_division=0))
+    print("Confusion Matrix (rows: actual, columns: predicted, order absent, present):")
+    print(confusion_matrix(y_test, y_pred, labels=[0, 1]))
+    print(f"Brier Score: {brier_score_loss(y_test, y_prob):.4f}")
+
+    cv_scores = cross_val_score(calibrated_clf, X_train_final_scaled, y_train, cv=5, scoring='accuracy')
+    print(f"Cross-Validation Accuracy Scores: {cv_scores}")
+    print(f"Mean Accuracy: {cv_scores.mean()*100:.2f}% ± {cv_scores.std()*100:.2f}%")
+
+    # Reliability diagram: predicted probability against the observed frequency
+    prob_true, prob_pred = calibration_curve(y_test, y_prob, n_bins=5)
+    plt.figure(figsize=(6, 6))
+    plt.plot([0, 1], [0, 1], linestyle='--', color='gray')
+    plt.plot(prob_pred, prob_true, marker='o')
+    plt.xlabel('Predicted Probability')
+    plt.ylabel('Observed Frequency')
+    plt.title(f'Calibration - {name}')
+    plt.show()
+
+    models[name] = {'model': calibrated_clf, 'scaler': detector_scaler, 'features': final_selected_features}
+
+# 9. Joint Evaluation: the set of pathologies reported for each test configuration
+predicted = (test_probabilities[detectors] >= 0.5).astype(int)
+print("Subset Accuracy (every pathology right):", f"{accuracy_score(Y_test[detectors], predicted) * 100:.2f}%")
+print("Hamming Loss:", f"{hamming_loss(Y_test[detectors], predicted):.4f}")
+print("Mean Probability per Mode (rows: actual mode, columns: detector):")
+print(test_probabilities[detectors].groupby(mode_test).mean().round(2).to_string())
+
+# Configurations reported with more than one pathology
+test_keys = aggregated_df.loc[X_test.index, ['Program', 'Mode', 'Threads', 'Data_Size', 'Options']]
+multiple = predicted.sum(axis=1) > 1
+print(f"Configurations with several pathologies detected: {int(multiple.sum())}")
+for index in predicted.index[multiple]:
+    key = test_keys.loc[index]
+    found = ', '.join(f"{name} ({test_probabilities.loc[index, name] * 100:.0f}%)"
+                      for name in detectors if predicted.loc[index, name])
+    print(f"  {key['Program']} {key['Mode']} threads={key['Threads']} size={key['Data_Size']} {key['Options']}: {found}")
+
+# 10. Save the Detectors for Future Use
 import joblib
 
-joblib.dump(dt_clf, 'decision_tree_classifier.pkl')
-joblib.dump(scaler, 'scaler.pkl')
-joblib.dump(label_encoder, 'label_encoder.pkl')
-joblib.dump(feature_importance, 'feature_importance.pkl')
+joblib.dump({'pathologies': PATHOLOGIES, 'detectors': models}, 'pathology_detectors.pkl')
+joblib.dump(feature_importances, 'feature_importance.pkl')
 
-print("Model, scaler, label encoder, and feature importance have been saved.")
+print("Pathology detectors (calibrated models with their scalers and features) and feature importance have been saved.")
@@ -0,0 +1,152 @@
+import sys
+
+import pandas as pd
+import numpy as np
+
+from sklearn.tree import DecisionTreeClassifier, export_text
+from sklearn.model_selection import LeaveOneGroupOut, cross_val_predict
+from sklearn.metrics import classification_report, confusion_matrix, accuracy_score
+import joblib
+
+# PMU-free classifier: diagnoses good / bad-fs / bad-ma from the shape of a
+# scaling curve recorded by scaling_sweep.sh (wall/kernel time at several thread
+# counts and affinities, plus the software events task-clock, context switches,
+# CPU migrations and page faults). No hardware counter is used, so the model
+# also applies on VMs where 'perf stat' reports <not supported> for PMU events.
+#
+# Usage: python3 scaling_classifier.py [scaling_data.csv]              train
+#        python3 scaling_classifier.py --predict [scaling_data.csv]    diagnose
+
+# Suppress warnings for cleaner output
+import warnings
+warnings.filterwarnings('ignore')
+
+LABELS = ['good', 'bad-fs', 'bad-ma']
+CURVE_KEYS = ['Program', 'Mode', 'Data_Size']
+MODEL_FILE = 'scaling_classifier.pkl'
+
+
+# 1. Load the Runs
+def load_runs(path):
+    df = pd.read_csv(path)
+    # Failed runs carry ERROR instead of a wall time
+    df['wall_time'] = pd.to_numeric(df['wall_time'], errors='coerce')
+    df = df.dropna(subset=['wall_time'])
+    for col in ['kernel_time', 'task_clock_ms', 'context_switches', 'cpu_migrations', 'page_faults']:
+        df[col] = pd.to_numeric(df[col], errors='coerce').fillna(0)
+    # Programs that report no kernel time fall back to the wall time
+    df.loc[df['kernel_time'] <= 0, 'kernel_time'] = df['wall_time']
+    return df
+
+
+# 2. Build one feature row per curve (Program, Mode, Data_Size)
+def curve_features(df):
+    points = df.groupby(CURVE_KEYS + ['Affinity', 'Threads']).agg(
+        time=('kernel_time', 'mean'),
+        time_std=('kernel_time', 'std'),
+        wall=('wall_time', 'mean'),
+        task_clock_ms=('task_clock_ms', 'mean'),
+        context_switches=('context_switches', 'mean'),
+        cpu_migrations=('cpu_migrations', 'mean'),
+        page_faults=('page_faults', 'mean'),
+    ).reset_index()
+    points['time_std'] = points['time_std'].fillna(0)
+
+    rows = []
+    for key, curve in points.groupby(CURVE_KEYS):
+        row = dict(zip(CURVE_KEYS, key))
+        for affinity, aff_curve in curve.groupby('Affinity'):
+            aff_curve = aff_curve.sort_values('Threads')
+            threads = aff_curve['Threads'].to_numpy(dtype=float)
+            times = aff_curve['time'].to_numpy()
+            base = aff_curve.iloc[0]
+            speedup = base['time'] / times
+            t_max = threads[-1]
+            top = aff_curve.iloc[-1]
+
+            # Speedup and efficiency at each thread count: how far from linear the curve bends
+            for t, s in zip(threads[1:], speedup[1:]):
+                row[f'speedup_{affinity}_{int(t)}'] = s
+                row[f'efficiency_{affinity}_{int(t)}'] = s / t
+            # Log-log slope of speedup against threads: 1 is linear, 0 flat, below 0 slowdown
+            if len(threads) > 1:
+                row[f'scaling_slope_{affinity}'] = np.polyfit(np.log(threads), np.log(speedup), 1)[0]
+            # Run-to-run variance, relative to the mean time, at one thread and at the top count
+            row[f'cv_{affinity}_1'] = base['time_std'] / base['time']
+            row[f'cv_{affinity}_max'] = top['time_std'] / top['time']
+            # CPU time per wall second per thread: below 1 means threads wait rather than work
+            if top['task_clock_ms'] > 0:
+                row[f'utilization_{affinity}_max'] = top['task_clock_ms'] / 1000.0 / top['wall'] / t_max
+            # Scheduler activity and page faults per second at the top count, and the fault
+            # growth with threads (first-touch and TLB behaviour)
+            row[f'context_switches_per_s_{affinity}_max'] = top['context_switches'] / top['wall']
+            row[f'migrations_per_s_{affinity}_max'] = top['cpu_migrations'] / top['wall']
+            row[f'page_faults_per_s_{affinity}_max'] = top['page_faults'] / top['wall']
+            row[f'page_fault_growth_{affinity}'] = top['page_faults'] / base['page_faults'] if base['page_faults'] > 0 else 1.0
+            row[f'max_threads_{affinity}'] = t_max
+
+        # Spread over close at the top thread count: sharing between threads costs more across cores
+        if {'close', 'spread'} <= set(curve['Affinity']):
+            t_top = curve['Threads'].max()
+            close = curve[(curve['Affinity'] == 'close') & (curve['Threads'] == t_top)]['time']
+            spread = curve[(curve['Affinity'] == 'spread') & (curve['Threads'] == t_top)]['time']
+            if len(close) and len(spread):
+                row['spread_over_close_max'] = spread.iloc[0] / close.iloc[0]
+        rows.append(row)
+
+    features = pd.DataFrame(rows)
+    feature_columns = [col for col in features.columns if col not in CURVE_KEYS]
+    features[feature_columns] = features[feature_columns].replace([np.inf, -np.inf], np.nan).fillna(0)
+    return features, feature_columns
+
+
+def train(path):
+    df = load_runs(path)
+    df = df[df['Mode'].isin(LABELS)]
+    features, feature_columns = curve_features(df)
+    print(f"Curves: {len(features)} from {features['Program'].nunique()} programs")
+    print(features.groupby('Mode').size().to_string())
+
+    X = features[feature_columns]
+    y = features['Mode']
+    groups = features['Program']
+
+    # 3. Leave-one-program-out evaluation: each kernel is diagnosed by a tree that never saw it,
+    #    as an unknown workload on the VM fleet would be
+    dt_clf = DecisionTreeClassifier(criterion='entropy', max_depth=4, class_weight='balanced', random_state=42)
+    if groups.nunique() > 1:
+        y_pred = cross_val_predict(dt_clf, X, y, groups=groups, cv=LeaveOneGroupOut())
+        print("Leave-One-Program-Out Classification Report:")
+        print(classification_report(y, y_pred, labels=LABELS, zero_division=0))
+        print("Confusion Matrix (rows: actual, columns: predicted, order good, bad-fs, bad-ma):")
+        print(confusion_matrix(y, y_pred, labels=LABELS))
+        print(f"Leave-One-Program-Out Accuracy: {accuracy_score(y, y_pred) * 100:.2f}%")
+
+    # 4. Train on every curve and save the model with its feature list
+    dt_clf.fit(X, y)
+    print("Decision Tree:")
+    print(export_text(dt_clf, feature_names=feature_columns))
+    joblib.dump({'model': dt_clf, 'features': feature_columns}, MODEL_FILE)
+    print(f"Model and feature list have been saved to {MODEL_FILE}.")
+
+
+def predict(path):
+    saved = joblib.load(MODEL_FILE)
+    df = load_runs(path)
+    features, _ = curve_features(df)
+    # Curves measured at other thread counts or affinities lack some features; they count as 0
+    X = features.reindex(columns=saved['features'], fill_value=0)
+    model = saved['model']
+    probabilities = model.predict_proba(X)
+    for (_, row), probs in zip(features.iterrows(), probabilities):
+        best = int(np.argmax(probs))
+        print(f"{row['Program']} {row['Mode']} {row['Data_Size']}: {model.classes_[best]} "
+              f"({probs[best] * 100:.0f}%)")
+
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+    if args and args[0] == '--predict':
+        predict(args[1] if len(args) > 1 else 'scaling_data.csv')
+    else:
+        train(args[0] if args else 'scaling_data.csv')
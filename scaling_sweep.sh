@@ -0,0 +1,203 @@
+#!/bin/bash
+
+# ==============================================================================
+# Script Name: scaling_sweep.sh
+# Description: Runs each program/mode/size at several thread counts and thread
+#              affinities and records a scaling curve from wall time and
+#              software events only (task-clock, context switches, CPU
+#              migrations, page faults). These need no hardware counters, so
+#              the sweep also works on VMs where 'perf stat' reports
+#              <not supported> for the PMU events. Without 'perf' at all the
+#              software columns stay 0 and only the times are recorded.
+#
+#              The rows go to scaling_data.csv; scaling_classifier.py turns
+#              them into curve features and classifies good / bad-fs / bad-ma.
+#
+# Usage:       bash scaling_sweep.sh                      # training sweep below
+#              bash scaling_sweep.sh PROGRAM MODE SIZE     # one workload, e.g. to
+#                                                          # diagnose it with
+#                                                          # scaling_classifier.py --predict
+# ==============================================================================
+
+# ==============================================================================
+# Configuration Variables
+# ==============================================================================
+
+# Number of iterations per point of the curve (the spread gives the variance features)
+ITERATIONS=3
+
+# Output files
+OUTPUT_FILE="scaling_data.csv"
+ERROR_LOG="error.log"
+LOG_FILE="scaling_run.log"
+
+# Points of the curve: thread counts, and OpenMP affinities (OMP_PROC_BIND with
+# OMP_PLACES=cores): 'close' packs threads onto neighbouring cores, 'spread'
+# scatters them, so sharing between threads costs differently in the two
+THREAD_COUNTS="1 2 4 8"
+AFFINITIES="close spread"
+
+# Software events, available without PMU access
+SW_EVENTS="task-clock,context-switches,cpu-migrations,page-faults"
+
+# Training programs: the threaded kernels among the original six (seq_10 is
+# single-threaded and has no scaling curve), two sizes each
+declare -A SCALING_PROGRAMS=(
+    ["./vec_14"]="100000000 300000000"
+    ["./sc_28"]="1000000000 2000000000"
+    ["./mc_31"]="2000 4000"
+    ["./vec_23"]="4000 8000"
+    ["./sc_29"]="100000000 300000000"
+    # Add more programs and their data sizes here if needed
+)
+
+declare -A SCALING_MODES=(
+    ["./vec_14"]="good bad-fs bad-ma"
+    ["./sc_28"]="good bad-fs bad-ma"
+    ["./mc_31"]="good bad-fs bad-ma"
+    ["./vec_23"]="good bad-fs bad-ma"
+    ["./sc_29"]="good bad-fs bad-ma"
+    # Add more programs and their modes here if needed
+)
+
+# A single workload given on the command line replaces the training sweep
+if [ $# -ge 3 ]; then
+    SCALING_PROGRAMS=(["$1"]="$3")
+    SCALING_MODES=(["$1"]="$2")
+elif [ $# -ne 0 ]; then
+    echo "Usage: $0 [PROGRAM MODE SIZE]"
+    exit 1
+fi
+
+# ==============================================================================
+# Redirect All Output to Log File
+# ==============================================================================
+
+# Redirect both stdout and stderr to LOG_FILE while displaying in terminal
+exec > >(tee -a "$LOG_FILE") 2>&1
+
+# ==============================================================================
+# Output File
+# ==============================================================================
+CSV_HEADER="Program,Mode,Data_Size,Affinity,Threads,Run,wall_time,kernel_time,task_clock_ms,context_switches,cpu_migrations,page_faults"
+
+if [ ! -f "$OUTPUT_FILE" ]; then
+    echo "$CSV_HEADER" > "$OUTPUT_FILE"
+    echo "Created new output file and added header: $OUTPUT_FILE"
+elif [ "$(head -n 1 "$OUTPUT_FILE")" != "$CSV_HEADER" ]; then
+    LEGACY_FILE="${OUTPUT_FILE}.legacy_$(date +%F_%T)"
+    mv "$OUTPUT_FILE" "$LEGACY_FILE"
+    echo "$CSV_HEADER" > "$OUTPUT_FILE"
+    echo "Output file has an outdated header; moved it to $LEGACY_FILE"
+else
+    echo "Output file exists. Appending data to $OUTPUT_FILE"
+fi
+
+if command -v perf > /dev/null 2>&1; then
+    HAVE_PERF=1
+else
+    HAVE_PERF=0
+    echo "Warning: 'perf' not found; recording wall and kernel time only."
+fi
+
+# ==============================================================================
+# Verify Executability of All Programs
+# ==============================================================================
+for PROGRAM in "${!SCALING_PROGRAMS[@]}"; do
+    if [ ! -x "$PROGRAM" ]; then
+        echo "Error: Program $PROGRAM not found or not executable."
+        exit 1
+    fi
+done
+
+# ==============================================================================
+# Function: extract_sw_events
+# Description: Parses 'perf stat -x,' output (value,unit,event,...) into
+#              task_clock_ms,context_switches,cpu_migrations,page_faults.
+#              Unsupported or missing events are 0.
+# ==============================================================================
+extract_sw_events() {
+    awk -F, '
+    BEGIN { task_clock = context_switches = cpu_migrations = page_faults = 0 }
+    $1 ~ /^[0-9.]+$/ && $3 ~ /^task-clock/ { task_clock = $1 }
+    $1 ~ /^[0-9.]+$/ && $3 ~ /^context-switches/ { context_switches = $1 }
+    $1 ~ /^[0-9.]+$/ && $3 ~ /^cpu-migrations/ { cpu_migrations = $1 }
+    $1 ~ /^[0-9.]+$/ && $3 ~ /^page-faults/ { page_faults = $1 }
+    END { print task_clock "," context_switches "," cpu_migrations "," page_faults }
+    ' "$1"
+}
+
+# ==============================================================================
+# Function: run_scaling_point
+# Description: Runs one point of a curve under the given affinity, and logs
+#              wall time, the kernel time the program reports (the sum of its
+#              "Execution Time: X seconds" lines, or the wall time if it
+#              prints none) and the software events.
+# ==============================================================================
+run_scaling_point() {
+    local program="$1"
+    local mode="$2"
+    local data_size="$3"
+    local affinity="$4"
+    local threads="$5"
+    local run="$6"
+
+    echo "    Run #$run"
+    echo "    Executing: OMP_PROC_BIND=$affinity $program $mode $data_size $threads"
+
+    local perf_file
+    perf_file=$(mktemp)
+    local start_ns end_ns output status
+    start_ns=$(date +%s%N)
+    if [ "$HAVE_PERF" -eq 1 ]; then
+        output=$(OMP_PROC_BIND="$affinity" OMP_PLACES=cores perf stat -x, -o "$perf_file" -e "$SW_EVENTS" \
+                 "$program" "$mode" "$data_size" "$threads")
+    else
+        output=$(OMP_PROC_BIND="$affinity" OMP_PLACES=cores "$program" "$mode" "$data_size" "$threads")
+    fi
+    status=$?
+    end_ns=$(date +%s%N)
+
+    if [ "$status" -ne 0 ]; then
+        echo "Error: Program $program encountered an error during execution."
+        echo "$program,$mode,$data_size,$affinity,$threads,$run,ERROR,,,,," >> "$OUTPUT_FILE"
+        echo "Error during scaling run #$run of program $program with Mode=$mode, Affinity=$affinity, Threads=$threads, Data_Size=$data_size" >> "$ERROR_LOG"
+        rm -f "$perf_file"
+        return 1
+    fi
+
+    local wall_time kernel_time events
+    wall_time=$(awk -v s="$start_ns" -v e="$end_ns" 'BEGIN { printf "%.6f", (e - s) / 1e9 }')
+    kernel_time=$(echo "$output" | awk -v wall="$wall_time" '
+        match($0, /Execution Time: [0-9.]+ seconds/) { split(substr($0, RSTART, RLENGTH), f, " "); total += f[3]; found = 1 }
+        END { if (found) printf "%.6f", total; else print wall }')
+    events=$(extract_sw_events "$perf_file")
+    rm -f "$perf_file"
+
+    echo "$program,$mode,$data_size,$affinity,$threads,$run,$wall_time,$kernel_time,$events" >> "$OUTPUT_FILE"
+}
+
+# ==============================================================================
+# Main Execution Loop
+# ==============================================================================
+echo "Starting scaling sweep."
+
+for PROGRAM in "${!SCALING_PROGRAMS[@]}"; do
+    DATA_SIZES=(${SCALING_PROGRAMS[$PROGRAM]})
+    MODES=(${SCALING_MODES[$PROGRAM]})
+
+    for MODE in "${MODES[@]}"; do
+        for DATA_SIZE in "${DATA_SIZES[@]}"; do
+            for AFFINITY in $AFFINITIES; do
+                for THREAD in $THREAD_COUNTS; do
+                    echo "  Configuration: Program=$PROGRAM, Mode=$MODE, Data_Size=$DATA_SIZE, Affinity=$AFFINITY, Threads=$THREAD"
+                    for RUN in $(seq 1 "$ITERATIONS"); do
+                        run_scaling_point "$PROGRAM" "$MODE" "$DATA_SIZE" "$AFFINITY" "$THREAD" "$RUN"
+                    done
+                done
+            done
+        done
+    done
+done
+
+echo "Scaling sweep complete. Data saved to $OUTPUT_FILE."
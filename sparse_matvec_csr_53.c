@@ -0,0 +1,596 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <time.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Sparse matrix-vector multiplication (y = A * x) over a CSR matrix
+// - Banded, power-law and uniformly random sparsity patterns, or a Matrix Market file
+// - Irregular but partly local gathers from x, unlike a fully shuffled index array
+// - Reverse Cuthill-McKee (RCM) reordering to recover locality
+// - Reporting GFLOP/s and effective memory bandwidth
+
+// Compressed sparse row matrix
+typedef struct {
+    unsigned long n;
+    unsigned long nnz;
+    unsigned long *row_ptr;
+    unsigned int *col_idx;
+    double *values;
+} CSRMatrix;
+
+// Simple xorshift generator: rand() is too coarse for multi-million-row patterns
+static inline unsigned long xorshift64(unsigned long *state) {
+    unsigned long x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+void free_csr(CSRMatrix *A) {
+    free(A->row_ptr);
+    free(A->col_idx);
+    free(A->values);
+}
+
+static int compare_uint(const void *a, const void *b) {
+    unsigned int x = *(const unsigned int *) a;
+    unsigned int y = *(const unsigned int *) b;
+    return (x > y) - (x < y);
+}
+
+// Function to build a CSR matrix from an edge list, adding each edge in both directions
+// plus the diagonal, then sorting and de-duplicating every row
+void csr_from_edges(CSRMatrix *A, unsigned long n, const unsigned int *src, const unsigned int *dst,
+                    unsigned long num_edges, int symmetric) {
+    unsigned long *counts = (unsigned long *) calloc(n + 1, sizeof(unsigned long));
+    if (!counts) {
+        fprintf(stderr, "Memory allocation failed for CSR row counts.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned long i = 0; i < n; i++) counts[i + 1]++;
+    for (unsigned long e = 0; e < num_edges; e++) {
+        counts[src[e] + 1]++;
+        if (symmetric && src[e] != dst[e]) counts[dst[e] + 1]++;
+    }
+    for (unsigned long i = 0; i < n; i++) counts[i + 1] += counts[i];
+
+    unsigned long capacity = counts[n];
+    unsigned int *cols = (unsigned int *) malloc(capacity * sizeof(unsigned int));
+    unsigned long *fill = (unsigned long *) malloc(n * sizeof(unsigned long));
+    if (!cols || !fill) {
+        fprintf(stderr, "Memory allocation failed for CSR columns.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(fill, counts, n * sizeof(unsigned long));
+
+    for (unsigned long i = 0; i < n; i++) cols[fill[i]++] = (unsigned int) i;
+    for (unsigned long e = 0; e < num_edges; e++) {
+        cols[fill[src[e]]++] = dst[e];
+        if (symmetric && src[e] != dst[e]) cols[fill[dst[e]]++] = src[e];
+    }
+    free(fill);
+
+    // Sort each row and squeeze out duplicate columns in place
+    A->n = n;
+    A->row_ptr = (unsigned long *) malloc((n + 1) * sizeof(unsigned long));
+    if (!A->row_ptr) {
+        fprintf(stderr, "Memory allocation failed for CSR row pointers.\n");
+        exit(EXIT_FAILURE);
+    }
+    unsigned long out = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        unsigned long begin = counts[i], end = counts[i + 1];
+        qsort(cols + begin, end - begin, sizeof(unsigned int), compare_uint);
+        A->row_ptr[i] = out;
+        for (unsigned long k = begin; k < end; k++) {
+            if (k == begin || cols[k] != cols[k - 1]) cols[out++] = cols[k];
+        }
+    }
+    A->row_ptr[n] = out;
+    A->nnz = out;
+    free(counts);
+
+    A->col_idx = (unsigned int *) realloc(cols, out * sizeof(unsigned int));
+    A->values = (double *) malloc(out * sizeof(double));
+    if (!A->col_idx || !A->values) {
+        fprintf(stderr, "Memory allocation failed for CSR values.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Diagonally dominant values: the exact numbers do not matter for the access pattern
+    for (unsigned long i = 0; i < n; i++) {
+        for (unsigned long k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            A->values[k] = (A->col_idx[k] == i) ? (double) (A->row_ptr[i + 1] - A->row_ptr[i]) : -1.0;
+        }
+    }
+}
+
+// Function to generate a symmetric sparsity pattern with about nnz_per_row entries per row:
+//   banded   : all columns within nnz_per_row/2 of the diagonal (clamped at the last column, no
+//              wrap-around into the corners)
+//   powerlaw : half of the edges local (within a small window), half towards heavy-tailed hubs
+//   random   : uniformly random columns
+void generate_matrix(CSRMatrix *A, const char *kind, unsigned long n, unsigned long nnz_per_row) {
+    unsigned long half = nnz_per_row / 2 ? nnz_per_row / 2 : 1;
+    unsigned long num_edges = n * half;
+    unsigned int *src = (unsigned int *) malloc(num_edges * sizeof(unsigned int));
+    unsigned int *dst = (unsigned int *) malloc(num_edges * sizeof(unsigned int));
+    if (!src || !dst) {
+        fprintf(stderr, "Memory allocation failed for the edge list.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long state = (unsigned long) time(NULL) * 2654435761UL + 1;
+    unsigned long e = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        for (unsigned long k = 1; k <= half; k++) {
+            unsigned long j;
+            if (strcmp(kind, "banded") == 0) {
+                j = (i + k < n) ? i + k : n - 1;
+            } else if (strcmp(kind, "powerlaw") == 0) {
+                if (k % 2) {
+                    j = (i + 1 + xorshift64(&state) % 64) % n;
+                } else {
+                    // u^3 concentrates endpoints on low indices, giving heavy-tailed degrees
+                    double u = (double) (xorshift64(&state) >> 11) / 9007199254740992.0;
+                    j = (unsigned long) (u * u * u * (double) n);
+                }
+            } else {
+                j = xorshift64(&state) % n;
+            }
+            src[e] = (unsigned int) i;
+            dst[e] = (unsigned int) j;
+            e++;
+        }
+    }
+
+    csr_from_edges(A, n, src, dst, e, 1);
+    free(src);
+    free(dst);
+}
+
+// Function to load a square Matrix Market coordinate file (real, integer or pattern)
+int load_matrix_market(CSRMatrix *A, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Cannot open matrix file %s\n", path);
+        return -1;
+    }
+
+    char line[1024];
+    int symmetric = 0;
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, "%%MatrixMarket matrix coordinate", 32) != 0) {
+        fprintf(stderr, "%s is not a Matrix Market coordinate file.\n", path);
+        fclose(fp);
+        return -1;
+    }
+    if (strstr(line, "symmetric")) symmetric = 1;
+
+    do {
+        if (!fgets(line, sizeof(line), fp)) {
+            fprintf(stderr, "Unexpected end of file in %s\n", path);
+            fclose(fp);
+            return -1;
+        }
+    } while (line[0] == '%');
+
+    unsigned long rows, cols, entries;
+    if (sscanf(line, "%lu %lu %lu", &rows, &cols, &entries) != 3 || rows != cols || rows == 0) {
+        fprintf(stderr, "Only square matrices are supported (%s).\n", path);
+        fclose(fp);
+        return -1;
+    }
+
+    unsigned int *src = (unsigned int *) malloc(entries * sizeof(unsigned int));
+    unsigned int *dst = (unsigned int *) malloc(entries * sizeof(unsigned int));
+    if (!src || !dst) {
+        fprintf(stderr, "Memory allocation failed for the edge list.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long e = 0;
+    while (e < entries && fgets(line, sizeof(line), fp)) {
+        unsigned long r, c;
+        if (line[0] == '%' || sscanf(line, "%lu %lu", &r, &c) != 2) continue;
+        if (r == 0 || c == 0 || r > rows || c > cols) continue;
+        src[e] = (unsigned int) (r - 1);
+        dst[e] = (unsigned int) (c - 1);
+        e++;
+    }
+    fclose(fp);
+
+    // Values are regenerated; only the sparsity pattern drives the access behaviour
+    csr_from_edges(A, rows, src, dst, e, symmetric);
+    free(src);
+    free(dst);
+    return 0;
+}
+
+// Function to shuffle an array of indices for random access
+void shuffle_indices(unsigned long *indices, unsigned long size) {
+    srand((unsigned)time(NULL));
+    for (unsigned long i = size - 1; i > 0; i--) {
+        unsigned long j = ((unsigned long) rand() * ((unsigned long) RAND_MAX + 1) + rand()) % (i + 1);
+        unsigned long temp = indices[i];
+        indices[i] = indices[j];
+        indices[j] = temp;
+    }
+}
+
+// Function to apply a symmetric permutation B = P A P^T, where perm[new] = old. B's arrays are
+// prefaulted as requested on the kernel's backend before they are filled; the fill itself stays
+// an OpenMP dynamic loop, since row lengths vary too much for a static split.
+void permute_csr(CSRMatrix *B, const CSRMatrix *A, const unsigned long *perm, PrefaultMode prefault, int num_threads,
+                 ThreadBackend backend) {
+    unsigned long n = A->n;
+    unsigned long *inverse = (unsigned long *) malloc(n * sizeof(unsigned long));
+    B->row_ptr = (unsigned long *) malloc((n + 1) * sizeof(unsigned long));
+    B->col_idx = (unsigned int *) malloc(A->nnz * sizeof(unsigned int));
+    B->values = (double *) malloc(A->nnz * sizeof(double));
+    if (!inverse || !B->row_ptr || !B->col_idx || !B->values) {
+        fprintf(stderr, "Memory allocation failed for the permuted matrix.\n");
+        exit(EXIT_FAILURE);
+    }
+    B->n = n;
+    B->nnz = A->nnz;
+    prefault_range(prefault, B->row_ptr, n + 1, sizeof(unsigned long), 1, num_threads, PARTITION_LINE, backend);
+    prefault_range(prefault, B->col_idx, A->nnz, sizeof(unsigned int), 1, num_threads, PARTITION_LINE, backend);
+    prefault_range(prefault, B->values, A->nnz, sizeof(double), 1, num_threads, PARTITION_LINE, backend);
+
+    for (unsigned long i = 0; i < n; i++) inverse[perm[i]] = i;
+
+    B->row_ptr[0] = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        unsigned long old = perm[i];
+        B->row_ptr[i + 1] = B->row_ptr[i] + (A->row_ptr[old + 1] - A->row_ptr[old]);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (unsigned long i = 0; i < n; i++) {
+        unsigned long old = perm[i];
+        unsigned long out = B->row_ptr[i];
+        for (unsigned long k = A->row_ptr[old]; k < A->row_ptr[old + 1]; k++) {
+            // Insertion sort keeps the new row ordered by column; rows are short
+            unsigned int c = (unsigned int) inverse[A->col_idx[k]];
+            double v = A->values[k];
+            unsigned long pos = out + (k - A->row_ptr[old]);
+            while (pos > out && B->col_idx[pos - 1] > c) {
+                B->col_idx[pos] = B->col_idx[pos - 1];
+                B->values[pos] = B->values[pos - 1];
+                pos--;
+            }
+            B->col_idx[pos] = c;
+            B->values[pos] = v;
+        }
+    }
+
+    free(inverse);
+}
+
+// Function to compute the Reverse Cuthill-McKee ordering (perm[new] = old).
+// Each connected component is started from its lowest-degree vertex.
+void rcm_order(const CSRMatrix *A, unsigned long *perm) {
+    unsigned long n = A->n;
+    unsigned long *degree = (unsigned long *) malloc(n * sizeof(unsigned long));
+    unsigned long *by_degree = (unsigned long *) malloc(n * sizeof(unsigned long));
+    unsigned long *bucket = (unsigned long *) calloc(n + 1, sizeof(unsigned long));
+    char *visited = (char *) calloc(n, 1);
+    if (!degree || !by_degree || !bucket || !visited) {
+        fprintf(stderr, "Memory allocation failed for RCM.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Counting sort of vertices by degree (degrees are bounded by n)
+    for (unsigned long i = 0; i < n; i++) {
+        degree[i] = A->row_ptr[i + 1] - A->row_ptr[i];
+        bucket[degree[i]]++;
+    }
+    unsigned long running = 0;
+    for (unsigned long d = 0; d <= n; d++) {
+        unsigned long c = bucket[d];
+        bucket[d] = running;
+        running += c;
+    }
+    for (unsigned long i = 0; i < n; i++) by_degree[bucket[degree[i]]++] = i;
+    free(bucket);
+
+    // Breadth-first search, visiting neighbours in increasing degree order
+    unsigned long head = 0, tail = 0;
+    for (unsigned long s = 0; s < n; s++) {
+        unsigned long start = by_degree[s];
+        if (visited[start]) continue;
+        visited[start] = 1;
+        perm[tail++] = start;
+
+        while (head < tail) {
+            unsigned long v = perm[head++];
+            unsigned long first = tail;
+            for (unsigned long k = A->row_ptr[v]; k < A->row_ptr[v + 1]; k++) {
+                unsigned long w = A->col_idx[k];
+                if (!visited[w]) {
+                    visited[w] = 1;
+                    perm[tail++] = w;
+                }
+            }
+            // Insertion sort of the newly queued neighbours by degree
+            for (unsigned long a = first + 1; a < tail; a++) {
+                unsigned long w = perm[a];
+                unsigned long b = a;
+                while (b > first && degree[perm[b - 1]] > degree[w]) {
+                    perm[b] = perm[b - 1];
+                    b--;
+                }
+                perm[b] = w;
+            }
+        }
+    }
+
+    // Reverse the Cuthill-McKee order
+    for (unsigned long i = 0; i < n / 2; i++) {
+        unsigned long temp = perm[i];
+        perm[i] = perm[n - 1 - i];
+        perm[n - 1 - i] = temp;
+    }
+
+    free(degree);
+    free(by_degree);
+    free(visited);
+}
+
+// Function to report the bandwidth and mean distance from the diagonal (locality indicators)
+void matrix_profile(const CSRMatrix *A, unsigned long *bandwidth, double *mean_distance) {
+    unsigned long max_dist = 0;
+    double total = 0.0;
+    #pragma omp parallel for reduction(max:max_dist) reduction(+:total) schedule(static)
+    for (unsigned long i = 0; i < A->n; i++) {
+        for (unsigned long k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            unsigned long c = A->col_idx[k];
+            unsigned long d = c > i ? c - i : i - c;
+            if (d > max_dist) max_dist = d;
+            total += (double) d;
+        }
+    }
+    *bandwidth = max_dist;
+    *mean_distance = total / (double) A->nnz;
+}
+
+// Shared state of the vector initialisation and the SpMV, handed to the per-thread body on every backend
+typedef struct {
+    const CSRMatrix *A;
+    double *x;
+    double *y;
+} SpmvContext;
+
+// Per-thread body: x = 1 and y = 0 over the thread's static block of rows
+void init_vectors_body(int tid, int num_threads, void *arg) {
+    SpmvContext *ctx = (SpmvContext *) arg;
+    unsigned long start, end;
+    backend_static_range(ctx->A->n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        ctx->x[i] = 1.0;
+        ctx->y[i] = 0.0;
+    }
+}
+
+// Per-thread body: y = A * x over the thread's static block of rows
+void spmv_body(int tid, int num_threads, void *arg) {
+    SpmvContext *ctx = (SpmvContext *) arg;
+    const CSRMatrix *A = ctx->A;
+    const double *x = ctx->x;
+    unsigned long start, end;
+    backend_static_range(A->n, num_threads, tid, &start, &end);
+    for (unsigned long i = start; i < end; i++) {
+        double sum = 0.0;
+        for (unsigned long k = A->row_ptr[i]; k < A->row_ptr[i + 1]; k++) {
+            sum += A->values[k] * x[A->col_idx[k]];
+        }
+        ctx->y[i] = sum;
+    }
+}
+
+// Function to perform y = A * x, iters times, one parallel region per product
+double spmv(const CSRMatrix *A, double *x, double *y, int iters, int num_threads, ThreadBackend backend) {
+    SpmvContext ctx = { A, x, y };
+    double start_time = omp_get_wtime();
+    for (int it = 0; it < iters; it++) {
+        backend_run(backend, num_threads, spmv_body, &ctx);
+    }
+    return omp_get_wtime() - start_time;
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-ma] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good    : RCM-reordered matrix (recovered locality)\n");
+    fprintf(stderr, "  bad-ma  : baseline ordering (generated matrices are randomly relabelled)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --matrix=banded|powerlaw|random|<file.mtx>   sparsity pattern (default powerlaw)\n");
+    fprintf(stderr, "  --nnz-per-row=K                              target non-zeros per row (default 16)\n");
+    fprintf(stderr, "  --iters=N                                    SpMV repetitions (default 20)\n");
+    fprintf(stderr, "  --cache=STATE                                cache state the SpMV starts from: none, warm,\n");
+    fprintf(stderr, "                                               cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=none|populate|touch               fault the permuted matrix and the vectors in before they\n");
+    fprintf(stderr, "                                               are filled (default none)\n");
+    fprintf(stderr, "  --backend=openmp|pthread|pool                runtime that runs the SpMV (default openmp)\n");
+    fprintf(stderr, "size is the number of rows (ignored when a file is given).\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    if (strcmp(mode, "good") != 0 && strcmp(mode, "bad-ma") != 0) {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    const char *matrix = "powerlaw";
+    unsigned long nnz_per_row = 16;
+    int iters = 20;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--matrix=", 9) == 0) {
+            matrix = argv[i] + 9;
+        } else if (strncmp(argv[i], "--nnz-per-row=", 14) == 0) {
+            nnz_per_row = atol(argv[i] + 14);
+        } else if (strncmp(argv[i], "--iters=", 8) == 0) {
+            iters = atoi(argv[i] + 8);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    int generated = strcmp(matrix, "banded") == 0 || strcmp(matrix, "powerlaw") == 0 || strcmp(matrix, "random") == 0;
+
+    // Validate size, threads and options
+    if (size == 0 && generated) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (size > 0xFFFFFFFFUL) {
+        fprintf(stderr, "Error: Size must fit in 32-bit column indices.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (nnz_per_row == 0 || iters <= 0) {
+        fprintf(stderr, "Error: --nnz-per-row and --iters must be positive integers.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    // Build or load the baseline matrix
+    CSRMatrix base;
+    if (generated) {
+        CSRMatrix natural;
+        generate_matrix(&natural, matrix, size, nnz_per_row);
+
+        // Generators emit a naturally ordered matrix; relabel it randomly so the baseline
+        // looks like an unordered mesh or graph as delivered by an upstream tool
+        unsigned long *perm = (unsigned long *) malloc(natural.n * sizeof(unsigned long));
+        if (!perm) {
+            fprintf(stderr, "Memory allocation failed for the permutation.\n");
+            return EXIT_FAILURE;
+        }
+        for (unsigned long i = 0; i < natural.n; i++) perm[i] = i;
+        shuffle_indices(perm, natural.n);
+        permute_csr(&base, &natural, perm, prefault, num_threads, backend);
+        free(perm);
+        free_csr(&natural);
+    } else if (load_matrix_market(&base, matrix) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    // Both modes build the RCM-reordered copy, so the profiled process does the same setup work
+    // in each; good runs on the copy, bad-ma discards it and runs on the baseline
+    CSRMatrix *A = &base;
+    CSRMatrix reordered;
+    double t0 = omp_get_wtime();
+    unsigned long *perm = (unsigned long *) malloc(base.n * sizeof(unsigned long));
+    if (!perm) {
+        fprintf(stderr, "Memory allocation failed for the RCM permutation.\n");
+        return EXIT_FAILURE;
+    }
+    rcm_order(&base, perm);
+    permute_csr(&reordered, &base, perm, prefault, num_threads, backend);
+    free(perm);
+    double reorder_time = omp_get_wtime() - t0;
+    if (strcmp(mode, "good") == 0) {
+        free_csr(&base);
+        A = &reordered;
+    } else {
+        free_csr(&reordered);
+    }
+
+    double *x = (double *) malloc(A->n * sizeof(double));
+    double *y = (double *) malloc(A->n * sizeof(double));
+    if (!x || !y) {
+        fprintf(stderr, "Memory allocation failed for the vectors.\n");
+        return EXIT_FAILURE;
+    }
+    prefault_range(prefault, x, A->n, sizeof(double), 1, num_threads, PARTITION_LINE, backend);
+    prefault_range(prefault, y, A->n, sizeof(double), 1, num_threads, PARTITION_LINE, backend);
+    SpmvContext init_ctx = { A, x, y };
+    backend_run(backend, num_threads, init_vectors_body, &init_ctx);
+
+    unsigned long bandwidth;
+    double mean_distance;
+    matrix_profile(A, &bandwidth, &mean_distance);
+
+    // Put the matrix and both vectors in the requested cache state
+    CacheRegion regions[] = { { A->row_ptr, A->n + 1, sizeof(unsigned long), 0 },
+                              { A->col_idx, A->nnz, sizeof(unsigned int), 0 },
+                              { A->values, A->nnz, sizeof(double), 0 },
+                              { x, A->n, sizeof(double), 0 },
+                              { y, A->n, sizeof(double), 1 } };
+    cache_state_prepare(cache, regions, 5, num_threads, PARTITION_LINE, backend);
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+
+    double elapsed = spmv(A, x, y, iters, num_threads, backend);
+    fault_phase_report(&faults, "kernel");
+
+    double checksum = 0.0;
+    for (unsigned long i = 0; i < A->n; i++) checksum += y[i];
+
+    // Minimum traffic per SpMV: values + column indices + row pointers + x once + y once
+    double bytes = (double) A->nnz * (sizeof(double) + sizeof(unsigned int))
+                 + (double) (A->n + 1) * sizeof(unsigned long)
+                 + 2.0 * (double) A->n * sizeof(double);
+
+    printf("Mode: %s (%s matrix, %s ordering)\n", mode, matrix, strcmp(mode, "good") == 0 ? "RCM" : "baseline");
+    printf("Rows: %lu\n", A->n);
+    printf("Non-zeros: %lu\n", A->nnz);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Matrix Bandwidth: %lu (mean |i-j| %.1f)\n", bandwidth, mean_distance);
+    printf("RCM Reorder Time: %f seconds\n", reorder_time);
+    printf("Checksum: %f\n", checksum);
+    printf("GFLOP/s: %.3f\n", 2.0 * (double) A->nnz * iters / elapsed / 1e9);
+    printf("Effective Bandwidth: %.3f GB/s\n", bytes * iters / elapsed / 1e9);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(x);
+    free(y);
+    free_csr(A);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,403 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "cache_state.h"
+#include "prefault.h"
+#include "thread_backend.h"
+
+// This program demonstrates:
+// - Statistics counters updated on every operation, K counters per operation
+// - A single shared struct of atomics, per-thread packed structs, per-thread padded structs
+//   and per-CPU slots selected through sched_getcpu()
+// - A reader thread that aggregates all counters at a configurable rate
+// - Reporting ops/s, the interval between the reader's snapshots and how stale each snapshot is
+
+// Define cache line size for padding (typically 64 bytes)
+#define CACHE_LINE_SIZE 64
+
+// Counter layouts
+typedef enum {
+    LAYOUT_SHARED,  // one struct of atomics shared by every thread
+    LAYOUT_PACKED,  // one struct per thread, structs back-to-back
+    LAYOUT_PADDED,  // one struct per thread, each starting on its own cache line
+    LAYOUT_PERCPU   // one padded struct per CPU, selected with sched_getcpu()
+} CounterLayout;
+
+// Counter slots: slot s starts at base + s * stride and holds num_counters counters
+typedef struct {
+    char *base;
+    size_t stride;
+    int num_slots;
+    int num_counters;
+    CounterLayout layout;
+} CounterTable;
+
+// Operations a writer has completed, published after each operation on the writer's own line
+typedef struct {
+    _Atomic unsigned long ops;
+} __attribute__((aligned(CACHE_LINE_SIZE))) WriterProgress;
+
+// Reader statistics
+typedef struct {
+    CounterTable *table;
+    WriterProgress *progress;
+    int num_writers;
+    atomic_int *done;
+    unsigned long read_hz;
+    unsigned long snapshots;
+    double total_read_time;
+    double total_interval;
+    double max_interval;
+    unsigned long last_running_total;
+    unsigned long running_snapshots;
+    double total_staleness;
+    unsigned long max_staleness;
+} ReaderState;
+
+static inline _Atomic unsigned long *slot_counters(CounterTable *table, int slot) {
+    return (_Atomic unsigned long *) (table->base + (size_t) slot * table->stride);
+}
+
+// Function to allocate the counter table in the requested layout, prefaulted as requested
+void init_counter_table(CounterTable *table, CounterLayout layout, int num_threads, int num_counters,
+                        PrefaultMode prefault, ThreadBackend backend) {
+    size_t struct_bytes = (size_t) num_counters * sizeof(unsigned long);
+    size_t padded_bytes = (struct_bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    table->layout = layout;
+    table->num_counters = num_counters;
+
+    switch (layout) {
+    case LAYOUT_SHARED:
+        table->num_slots = 1;
+        table->stride = padded_bytes;
+        break;
+    case LAYOUT_PACKED:
+        table->num_slots = num_threads;
+        table->stride = struct_bytes;
+        break;
+    case LAYOUT_PADDED:
+        table->num_slots = num_threads;
+        table->stride = padded_bytes;
+        break;
+    case LAYOUT_PERCPU:
+        table->num_slots = (int) sysconf(_SC_NPROCESSORS_CONF);
+        if (table->num_slots <= 0) table->num_slots = 1;
+        table->stride = padded_bytes;
+        break;
+    }
+
+    size_t bytes = (size_t) table->num_slots * table->stride;
+    void *ptr = NULL;
+    if (layout == LAYOUT_PACKED) {
+        // Plain malloc, as a per-thread stats array typically is
+        ptr = malloc(bytes);
+    } else if (posix_memalign(&ptr, CACHE_LINE_SIZE, bytes) != 0) {
+        ptr = NULL;
+    }
+    if (!ptr) {
+        fprintf(stderr, "Memory allocation failed for counters.\n");
+        exit(EXIT_FAILURE);
+    }
+    prefault_range(prefault, ptr, bytes, 1, 1, num_threads, PARTITION_LINE, backend);
+    memset(ptr, 0, bytes);
+    table->base = (char *) ptr;
+}
+
+// Function to sum every counter of every slot
+unsigned long aggregate_counters(CounterTable *table) {
+    unsigned long total = 0;
+    for (int s = 0; s < table->num_slots; s++) {
+        _Atomic unsigned long *counters = slot_counters(table, s);
+        for (int k = 0; k < table->num_counters; k++) {
+            total += atomic_load_explicit(&counters[k], memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+// Function to count the increments the writers had completed: published operations times K
+unsigned long published_counts(WriterProgress *progress, int num_writers, int num_counters) {
+    unsigned long ops = 0;
+    for (int t = 0; t < num_writers; t++) {
+        ops += atomic_load_explicit(&progress[t].ops, memory_order_acquire);
+    }
+    return ops * (unsigned long) num_counters;
+}
+
+// Reader thread: aggregate the counters read_hz times per second until the writers finish.
+// After each snapshot taken while the writers run, the writers' published progress is read;
+// the increments it covers that the snapshot missed are that snapshot's staleness.
+void *reader_main(void *arg) {
+    ReaderState *state = (ReaderState *) arg;
+    struct timespec period;
+    period.tv_sec = (time_t) (1 / state->read_hz);
+    period.tv_nsec = (long) ((1000000000UL / state->read_hz) % 1000000000UL);
+
+    double prev_end = omp_get_wtime();
+    for (;;) {
+        int finished = atomic_load_explicit(state->done, memory_order_acquire);
+
+        double read_start = omp_get_wtime();
+        unsigned long total = aggregate_counters(state->table);
+        double read_end = omp_get_wtime();
+
+        double interval = read_end - prev_end;
+        state->snapshots++;
+        state->total_read_time += read_end - read_start;
+        state->total_interval += interval;
+        if (interval > state->max_interval) state->max_interval = interval;
+        if (!finished) {
+            unsigned long published = published_counts(state->progress, state->num_writers,
+                                                       state->table->num_counters);
+            unsigned long staleness = published > total ? published - total : 0;
+            state->last_running_total = total;
+            state->running_snapshots++;
+            state->total_staleness += (double) staleness;
+            if (staleness > state->max_staleness) state->max_staleness = staleness;
+        }
+        prev_end = read_end;
+
+        if (finished) break;
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+// Shared state of the writers, handed to the per-thread body on every backend
+typedef struct {
+    CounterTable *table;
+    WriterProgress *progress;
+    unsigned long size;
+} WriterContext;
+
+// Per-thread body: 'size' operations, each bumping every counter once and then publishing
+// the thread's operation count
+void writer_body(int tid, int num_threads, void *arg) {
+    (void) num_threads;
+    WriterContext *ctx = (WriterContext *) arg;
+    CounterTable *table = ctx->table;
+    _Atomic unsigned long *progress = &ctx->progress[tid].ops;
+    unsigned long size = ctx->size;
+    int num_counters = table->num_counters;
+
+    if (table->layout == LAYOUT_SHARED) {
+        _Atomic unsigned long *counters = slot_counters(table, 0);
+        for (unsigned long i = 0; i < size; i++) {
+            for (int k = 0; k < num_counters; k++) {
+                atomic_fetch_add_explicit(&counters[k], 1, memory_order_relaxed);
+            }
+            atomic_store_explicit(progress, i + 1, memory_order_release);
+        }
+    } else if (table->layout == LAYOUT_PERCPU) {
+        // sched_getcpu() is a vDSO call; the thread may migrate between the lookup and the
+        // updates, so slots are still updated atomically (rseq would allow plain stores)
+        for (unsigned long i = 0; i < size; i++) {
+            int cpu = sched_getcpu();
+            if (cpu < 0 || cpu >= table->num_slots) cpu = 0;
+            _Atomic unsigned long *counters = slot_counters(table, cpu);
+            for (int k = 0; k < num_counters; k++) {
+                atomic_fetch_add_explicit(&counters[k], 1, memory_order_relaxed);
+            }
+            atomic_store_explicit(progress, i + 1, memory_order_release);
+        }
+    } else {
+        // Single writer per slot: relaxed load + store, no locked RMW needed
+        _Atomic unsigned long *counters = slot_counters(table, tid);
+        for (unsigned long i = 0; i < size; i++) {
+            for (int k = 0; k < num_counters; k++) {
+                unsigned long v = atomic_load_explicit(&counters[k], memory_order_relaxed);
+                atomic_store_explicit(&counters[k], v + 1, memory_order_relaxed);
+            }
+            atomic_store_explicit(progress, i + 1, memory_order_release);
+        }
+    }
+}
+
+// Function to run the writers: each thread performs 'size' operations, each bumping every counter once
+double run_writers(CounterTable *table, WriterProgress *progress, unsigned long size, int num_threads,
+                   ThreadBackend backend) {
+    WriterContext ctx = { table, progress, size };
+    double start_time = omp_get_wtime();
+    backend_run(backend, num_threads, writer_body, &ctx);
+    return omp_get_wtime() - start_time;
+}
+
+const char *layout_name(CounterLayout layout) {
+    switch (layout) {
+    case LAYOUT_SHARED: return "shared";
+    case LAYOUT_PACKED: return "packed";
+    case LAYOUT_PADDED: return "padded";
+    case LAYOUT_PERCPU: return "percpu";
+    }
+    return "unknown";
+}
+
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [good|bad-fs|shared|percpu] [size] [threads] [options]\n", prog);
+    fprintf(stderr, "Modes:\n");
+    fprintf(stderr, "  good    : per-thread counter structs padded to cache lines\n");
+    fprintf(stderr, "  bad-fs  : per-thread counter structs packed back-to-back (false sharing)\n");
+    fprintf(stderr, "  shared  : one shared struct of atomic counters\n");
+    fprintf(stderr, "  percpu  : per-CPU padded slots selected with sched_getcpu()\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --counters=K    counters incremented per operation (default 2, so four threads' packed structs share a line)\n");
+    fprintf(stderr, "  --read-hz=N     reader aggregation rate in Hz (default 1000)\n");
+    fprintf(stderr, "  --cache=STATE   cache state the writers start from: none, warm, cold-stream, cold-flush or mixed (default none)\n");
+    fprintf(stderr, "  --prefault=M    fault the counter table in before initialisation: none, populate or touch (default none)\n");
+    fprintf(stderr, "  --backend=B     runtime that runs the writers: openmp, pthread or pool (default openmp)\n");
+    fprintf(stderr, "size is the number of operations per thread.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse command-line arguments
+    char *mode = argv[1];
+    unsigned long size = atol(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    // Validate mode
+    CounterLayout layout;
+    if (strcmp(mode, "good") == 0) {
+        layout = LAYOUT_PADDED;
+    } else if (strcmp(mode, "bad-fs") == 0) {
+        layout = LAYOUT_PACKED;
+    } else if (strcmp(mode, "shared") == 0) {
+        layout = LAYOUT_SHARED;
+    } else if (strcmp(mode, "percpu") == 0) {
+        layout = LAYOUT_PERCPU;
+    } else {
+        fprintf(stderr, "Invalid mode: %s\n", mode);
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Parse optional arguments
+    int num_counters = 2;
+    unsigned long read_hz = 1000;
+    CacheState cache = CACHE_NONE;
+    PrefaultMode prefault = PREFAULT_NONE;
+    ThreadBackend backend = BACKEND_OPENMP;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--counters=", 11) == 0) {
+            num_counters = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--read-hz=", 10) == 0) {
+            read_hz = atol(argv[i] + 10);
+        } else {
+            int parsed = cache_state_parse_option(argv[i], &cache);
+            if (parsed == 0) parsed = prefault_parse_option(argv[i], &prefault);
+            if (parsed == 0) parsed = backend_parse_option(argv[i], &backend);
+            if (parsed == 0) {
+                fprintf(stderr, "Invalid option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (parsed < 0) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Validate size, threads and options
+    if (size == 0) {
+        fprintf(stderr, "Error: Size must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads <= 0) {
+        fprintf(stderr, "Error: Number of threads must be a positive integer.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_counters <= 0 || read_hz == 0) {
+        fprintf(stderr, "Error: --counters and --read-hz must be positive integers.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set the number of threads for OpenMP
+    omp_set_num_threads(num_threads);
+
+    FaultPhase faults;
+    fault_phase_begin(&faults);
+
+    CounterTable table;
+    init_counter_table(&table, layout, num_threads, num_counters, prefault, backend);
+
+    // Put the counter table in the requested cache state
+    CacheRegion region = { table.base, (unsigned long) table.num_slots, table.stride, 1 };
+    cache_state_prepare(cache, &region, 1, num_threads, PARTITION_LINE, backend);
+
+    // One progress line per writer, read by the reader after each snapshot
+    WriterProgress *progress = NULL;
+    if (posix_memalign((void **) &progress, CACHE_LINE_SIZE, (size_t) num_threads * sizeof(WriterProgress)) != 0) {
+        fprintf(stderr, "Memory allocation failed for writer progress.\n");
+        free(table.base);
+        return EXIT_FAILURE;
+    }
+    memset(progress, 0, (size_t) num_threads * sizeof(WriterProgress));
+
+    // Start the reader before the writers
+    atomic_int done = 0;
+    ReaderState reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.table = &table;
+    reader.progress = progress;
+    reader.num_writers = num_threads;
+    reader.done = &done;
+    reader.read_hz = read_hz;
+
+    pthread_t reader_thread;
+    if (pthread_create(&reader_thread, NULL, reader_main, &reader) != 0) {
+        fprintf(stderr, "Failed to start the reader thread.\n");
+        free(progress);
+        free(table.base);
+        return EXIT_FAILURE;
+    }
+
+    fault_phase_report(&faults, "setup");
+    fault_phase_begin(&faults);
+
+    double elapsed = run_writers(&table, progress, size, num_threads, backend);
+    fault_phase_report(&faults, "kernel");
+
+    atomic_store_explicit(&done, 1, memory_order_release);
+    pthread_join(reader_thread, NULL);
+
+    unsigned long expected = (unsigned long) num_threads * size * (unsigned long) num_counters;
+    unsigned long total = aggregate_counters(&table);
+    unsigned long ops = (unsigned long) num_threads * size;
+
+    printf("Mode: %s (layout %s, %d counters per op, reader at %lu Hz)\n", mode, layout_name(layout), num_counters, read_hz);
+    printf("Size: %lu\n", size);
+    printf("Threads: %d\n", num_threads);
+    printf("Backend: %s\n", backend_name(backend));
+    cache_state_report(cache);
+    prefault_report(prefault);
+    printf("Counter Total: %lu (%s)\n", total, total == expected ? "ok" : "MISMATCH");
+    printf("Ops/s: %.0f\n", ops / elapsed);
+    printf("Reader Snapshots: %lu\n", reader.snapshots);
+    printf("Reader Aggregation Time (mean): %.3f us\n", 1e6 * reader.total_read_time / reader.snapshots);
+    printf("Reader Snapshot Interval (mean/max): %.3f / %.3f ms\n",
+           1e3 * reader.total_interval / reader.snapshots, 1e3 * reader.max_interval);
+    // Counts are converted to time at the writers' measured aggregate increment rate
+    double counts_per_ms = (double) expected / elapsed / 1e3;
+    double mean_staleness = reader.running_snapshots > 0 ? reader.total_staleness / reader.running_snapshots : 0.0;
+    printf("Reader Staleness (mean/max): %.1f / %lu counts, %.6f / %.6f ms\n", mean_staleness, reader.max_staleness,
+           mean_staleness / counts_per_ms, reader.max_staleness / counts_per_ms);
+    printf("Reader Lag at Finish: %lu counts not yet seen by the last in-flight snapshot\n", expected - reader.last_running_total);
+    printf("Execution Time: %f seconds\n", elapsed);
+
+    free(progress);
+    free(table.base);
+
+    return total == expected ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+#ifndef TASKING_H
+#define TASKING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+// Task-parallel variants of the hand-split kernels.
+//
+// The range [0, size) is cut into tasks of 'grain' units. Each task writes its result into its
+// own slot of a shared results array, packed (adjacent slots share cache lines) or padded (one
+// slot per line). Tasks are created with a taskloop or by recursive halving, so which thread
+// runs which task, and therefore which neighbouring slots are written concurrently, is decided
+// by the runtime rather than by a static tid-based split.
+
+// Define cache line size used to pad result slots
+#define TASKING_LINE_SIZE 64
+
+typedef enum {
+    TASKING_NONE,       // original parallel-for / tid split
+    TASKING_TASKLOOP,   // one taskloop over all tasks
+    TASKING_RECURSIVE   // recursive halving of the task range, one task per half
+} TaskingMode;
+
+typedef struct {
+    TaskingMode mode;
+    unsigned long grain;    // units per task; 0 = program default
+} TaskingConfig;
+
+// Per-task result slots: slot t is at base + t * stride. The thread that ran task t is recorded
+// next to the result in a padded slot, so the good modes share no line through it either, and in
+// the packed owner[] array otherwise.
+typedef struct {
+    char *base;
+    size_t stride;
+    unsigned long count;
+    int *owner;             // NULL for padded slots
+} TaskSlots;
+
+typedef void (*TaskBody)(unsigned long task, unsigned long start, unsigned long end, void *ctx);
+
+static inline const char *tasking_mode_name(TaskingMode mode) {
+    switch (mode) {
+    case TASKING_NONE: return "none";
+    case TASKING_TASKLOOP: return "taskloop";
+    case TASKING_RECURSIVE: return "recursive";
+    }
+    return "unknown";
+}
+
+// Function to parse --tasking=none|taskloop|recursive and --grain=N.
+// Returns 1 if the argument was consumed, 0 if it is not a tasking option, -1 if invalid.
+static inline int tasking_parse_option(const char *arg, TaskingConfig *cfg) {
+    if (strncmp(arg, "--grain=", 8) == 0) {
+        long grain = atol(arg + 8);
+        if (grain <= 0) {
+            fprintf(stderr, "Invalid grain: %s (expected a positive integer)\n", arg + 8);
+            return -1;
+        }
+        cfg->grain = (unsigned long) grain;
+        return 1;
+    }
+    if (strncmp(arg, "--tasking=", 10) != 0) return 0;
+    const char *value = arg + 10;
+    if (strcmp(value, "none") == 0) cfg->mode = TASKING_NONE;
+    else if (strcmp(value, "taskloop") == 0) cfg->mode = TASKING_TASKLOOP;
+    else if (strcmp(value, "recursive") == 0) cfg->mode = TASKING_RECURSIVE;
+    else {
+        fprintf(stderr, "Invalid tasking mode: %s (expected none, taskloop or recursive)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+static inline unsigned long tasking_num_tasks(const TaskingConfig *cfg, unsigned long size) {
+    return (size + cfg->grain - 1) / cfg->grain;
+}
+
+// Function to allocate zeroed result slots, packed back-to-back or one per cache line
+static inline void task_slots_init(TaskSlots *slots, unsigned long count, int padded) {
+    slots->count = count;
+    slots->stride = padded ? TASKING_LINE_SIZE : sizeof(unsigned long);
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, TASKING_LINE_SIZE, count * slots->stride) != 0) ptr = NULL;
+    slots->base = (char *) ptr;
+    slots->owner = padded ? NULL : (int *) malloc(count * sizeof(int));
+    if (!slots->base || (!padded && !slots->owner)) {
+        fprintf(stderr, "Memory allocation failed for %lu task slots.\n", count);
+        exit(EXIT_FAILURE);
+    }
+    memset(slots->base, 0, count * slots->stride);
+}
+
+static inline unsigned long *task_slot(const TaskSlots *slots, unsigned long task) {
+    return (unsigned long *) (slots->base + task * slots->stride);
+}
+
+static inline int *task_owner(const TaskSlots *slots, unsigned long task) {
+    if (slots->owner) return &slots->owner[task];
+    return (int *) (slots->base + task * slots->stride + sizeof(unsigned long));
+}
+
+static inline unsigned long task_slots_sum(const TaskSlots *slots) {
+    unsigned long total = 0;
+    for (unsigned long t = 0; t < slots->count; t++) total += *task_slot(slots, t);
+    return total;
+}
+
+// Fraction of neighbouring task pairs that ran on different threads: the share of adjacent
+// slots that could be written concurrently (0 for a static split with one task per thread)
+static inline double task_slots_owner_switches(const TaskSlots *slots) {
+    if (slots->count < 2) return 0.0;
+    unsigned long switches = 0;
+    for (unsigned long t = 1; t < slots->count; t++) {
+        if (*task_owner(slots, t) != *task_owner(slots, t - 1)) switches++;
+    }
+    return (double) switches / (double) (slots->count - 1);
+}
+
+static inline void task_slots_free(TaskSlots *slots) {
+    free(slots->base);
+    free(slots->owner);
+}
+
+static inline void tasking_run_task(const TaskingConfig *cfg, unsigned long size, TaskSlots *slots,
+                                    TaskBody body, void *ctx, unsigned long t) {
+    unsigned long start = t * cfg->grain;
+    unsigned long end = (start + cfg->grain < size) ? start + cfg->grain : size;
+    *task_owner(slots, t) = omp_get_thread_num();
+    body(t, start, end, ctx);
+}
+
+static inline void tasking_recurse(const TaskingConfig *cfg, unsigned long size, TaskSlots *slots,
+                                   TaskBody body, void *ctx, unsigned long t0, unsigned long t1) {
+    if (t1 - t0 == 1) {
+        tasking_run_task(cfg, size, slots, body, ctx, t0);
+        return;
+    }
+    unsigned long mid = t0 + (t1 - t0) / 2;
+    #pragma omp task
+    tasking_recurse(cfg, size, slots, body, ctx, t0, mid);
+    tasking_recurse(cfg, size, slots, body, ctx, mid, t1);
+    #pragma omp taskwait
+}
+
+// Function to run 'body' over [0, size) as tasks of cfg->grain units; one slot per task
+static inline void tasking_run(const TaskingConfig *cfg, unsigned long size, TaskSlots *slots,
+                               TaskBody body, void *ctx) {
+    unsigned long num_tasks = slots->count;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            if (cfg->mode == TASKING_TASKLOOP) {
+                #pragma omp taskloop grainsize(1)
+                for (unsigned long t = 0; t < num_tasks; t++) {
+                    tasking_run_task(cfg, size, slots, body, ctx, t);
+                }
+            } else if (num_tasks > 0) {
+                tasking_recurse(cfg, size, slots, body, ctx, 0, num_tasks);
+            }
+        }
+    }
+}
+
+#endif // TASKING_H
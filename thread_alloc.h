@@ -0,0 +1,124 @@
+#ifndef THREAD_ALLOC_H
+#define THREAD_ALLOC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <malloc.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// Per-thread accumulators allocated by the threads themselves.
+//
+// In the bad-fs-alloc modes each thread mallocs its own small accumulator inside a parallel
+// region, as per-thread state often is. With one malloc arena (forced here with M_ARENA_MAX=1,
+// the usual setting in containers and under MALLOC_ARENA_MAX) the small chunks are carved out
+// next to each other, so several threads' accumulators land on one cache line. The good-alloc
+// fix asks the allocator for a whole, line-aligned line per thread instead. The report shows
+// where each accumulator landed relative to line boundaries.
+//
+// glibc allocates a thread's tcache (about 0x290 bytes) from the arena on that thread's first
+// malloc. If that happened inside the allocation region, every accumulator would be followed by
+// the next thread's tcache and no two would share a line, so each thread first warms its tcache
+// and all threads wait for each other before allocating.
+
+// Define cache line size used for the aligned allocations and the report
+#define THREAD_ALLOC_LINE_SIZE 64
+// Size of the warm-up allocation: above the tcache range, so freeing it returns it to the arena
+// rather than caching it for reuse by the accumulator
+#define THREAD_ALLOC_WARM_SIZE 4096
+
+typedef struct {
+    unsigned long **slots;   // slots[t]: accumulator allocated by thread t
+    int count;
+    int aligned;             // 0: malloc(sizeof(unsigned long)), 1: posix_memalign of one line
+    atomic_int warmed;       // threads whose tcache is set up
+} ThreadAllocs;
+
+// Function to restrict malloc to a single arena so per-thread allocations share it.
+// Must run before the first parallel allocation; a no-op where M_ARENA_MAX is unavailable.
+static inline void thread_alloc_single_arena(void) {
+#ifdef M_ARENA_MAX
+    mallopt(M_ARENA_MAX, 1);
+#endif
+}
+
+static inline void thread_allocs_init(ThreadAllocs *allocs, int count, int aligned) {
+    allocs->count = count;
+    allocs->aligned = aligned;
+    atomic_init(&allocs->warmed, 0);
+    allocs->slots = (unsigned long **) calloc(count, sizeof(unsigned long *));
+    if (!allocs->slots) {
+        fprintf(stderr, "Memory allocation failed for %d accumulator pointers.\n", count);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function run by every thread 'tid' of one parallel region (any backend): allocate and zero its
+// own accumulator once all threads have warmed their tcache
+static inline void thread_alloc_slot(ThreadAllocs *allocs, int tid) {
+    free(malloc(THREAD_ALLOC_WARM_SIZE));
+    atomic_fetch_add(&allocs->warmed, 1);
+    while (atomic_load(&allocs->warmed) < allocs->count) sched_yield();
+
+    void *ptr = NULL;
+    if (allocs->aligned) {
+        if (posix_memalign(&ptr, THREAD_ALLOC_LINE_SIZE, THREAD_ALLOC_LINE_SIZE) != 0) ptr = NULL;
+    } else {
+        ptr = malloc(sizeof(unsigned long));
+    }
+    if (!ptr) {
+        fprintf(stderr, "Memory allocation failed for the accumulator of thread %d.\n", tid);
+        exit(EXIT_FAILURE);
+    }
+    *(unsigned long *) ptr = 0;
+    allocs->slots[tid] = (unsigned long *) ptr;
+}
+
+static inline unsigned long thread_allocs_sum(const ThreadAllocs *allocs) {
+    unsigned long total = 0;
+    for (int t = 0; t < allocs->count; t++) total += *allocs->slots[t];
+    return total;
+}
+
+// Function to print each accumulator's address, offset within its line and line relative to the
+// lowest one, followed by how many accumulators share a line with another thread's.
+// Returns -1 (with an error) when the malloc'd accumulators of several threads share no line,
+// i.e. bad-fs-alloc produced no false sharing on this allocator, 0 otherwise.
+static inline int thread_allocs_report(const ThreadAllocs *allocs) {
+    uintptr_t first_line = UINTPTR_MAX;
+    for (int t = 0; t < allocs->count; t++) {
+        uintptr_t line = (uintptr_t) allocs->slots[t] / THREAD_ALLOC_LINE_SIZE;
+        if (line < first_line) first_line = line;
+    }
+
+    printf("Allocator: %s, single arena\n",
+           allocs->aligned ? "posix_memalign(64, 64) per thread" : "malloc(sizeof(unsigned long)) per thread");
+    int sharing = 0;
+    for (int t = 0; t < allocs->count; t++) {
+        uintptr_t addr = (uintptr_t) allocs->slots[t];
+        uintptr_t line = addr / THREAD_ALLOC_LINE_SIZE;
+        int shared = 0;
+        for (int u = 0; u < allocs->count; u++) {
+            if (u != t && (uintptr_t) allocs->slots[u] / THREAD_ALLOC_LINE_SIZE == line) shared = 1;
+        }
+        sharing += shared;
+        printf("Accumulator %d: %p, line offset %lu, line +%lu%s\n", t, (void *) allocs->slots[t],
+               (unsigned long) (addr % THREAD_ALLOC_LINE_SIZE), (unsigned long) (line - first_line),
+               shared ? " (shared)" : "");
+    }
+    printf("Accumulators Sharing a Line: %d of %d\n", sharing, allocs->count);
+    if (!allocs->aligned && allocs->count > 1 && sharing == 0) {
+        fprintf(stderr, "Error: no two malloc'd accumulators share a cache line, so the run has no false sharing.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static inline void thread_allocs_free(ThreadAllocs *allocs) {
+    for (int t = 0; t < allocs->count; t++) free(allocs->slots[t]);
+    free(allocs->slots);
+}
+
+#endif // THREAD_ALLOC_H
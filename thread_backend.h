@@ -0,0 +1,230 @@
+#ifndef THREAD_BACKEND_H
+#define THREAD_BACKEND_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <omp.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Selectable threading backend for the kernels' parallel regions.
+//
+// A kernel's parallel region is written once as a body function body(tid, num_threads, ctx)
+// and started with backend_run(), which runs it on one of:
+//   openmp  - a libgomp parallel region (libgomp's thread pool and spinning barriers)
+//   pthread - fresh pthreads created and joined on every call (fork-join per region)
+//   pool    - a persistent pool of pthreads woken and joined through futex barriers
+// so runtime artefacts (context switches, barrier spinning) can be told apart from the
+// memory behaviour of the body, which is identical on every backend.
+
+typedef enum {
+    BACKEND_OPENMP,
+    BACKEND_PTHREAD,
+    BACKEND_POOL
+} ThreadBackend;
+
+typedef void (*BackendBody)(int tid, int num_threads, void *ctx);
+
+static inline const char *backend_name(ThreadBackend backend) {
+    switch (backend) {
+    case BACKEND_OPENMP: return "openmp";
+    case BACKEND_PTHREAD: return "pthread";
+    case BACKEND_POOL: return "pool";
+    }
+    return "unknown";
+}
+
+// Function to parse a --backend=<name> argument.
+// Returns 1 if the argument was consumed, 0 if it is not a backend option, -1 if invalid.
+static inline int backend_parse_option(const char *arg, ThreadBackend *backend) {
+    if (strncmp(arg, "--backend=", 10) != 0) return 0;
+    const char *value = arg + 10;
+    if (strcmp(value, "openmp") == 0) *backend = BACKEND_OPENMP;
+    else if (strcmp(value, "pthread") == 0) *backend = BACKEND_PTHREAD;
+    else if (strcmp(value, "pool") == 0) *backend = BACKEND_POOL;
+    else {
+        fprintf(stderr, "Invalid backend: %s (expected openmp, pthread or pool)\n", value);
+        return -1;
+    }
+    return 1;
+}
+
+// Function to compute the iterations [start, end) of thread 'tid' the way schedule(static) does:
+// contiguous blocks, the first (count % num_threads) threads taking one extra iteration
+static inline void backend_static_range(unsigned long count, int num_threads, int tid,
+                                        unsigned long *start, unsigned long *end) {
+    unsigned long q = count / num_threads;
+    unsigned long r = count % num_threads;
+    unsigned long t = (unsigned long) tid;
+    *start = t * q + (t < r ? t : r);
+    *end = *start + q + (t < r ? 1 : 0);
+}
+
+// Sense-free barrier: waiters sleep on the generation word until the last arrival bumps it
+typedef struct {
+    atomic_int arrived;
+    atomic_int generation;
+    int count;
+} FutexBarrier;
+
+static inline void futex_barrier_wait(FutexBarrier *barrier) {
+    int gen = atomic_load_explicit(&barrier->generation, memory_order_acquire);
+    if (atomic_fetch_add_explicit(&barrier->arrived, 1, memory_order_acq_rel) == barrier->count - 1) {
+        atomic_store_explicit(&barrier->arrived, 0, memory_order_relaxed);
+        atomic_fetch_add_explicit(&barrier->generation, 1, memory_order_release);
+        syscall(SYS_futex, &barrier->generation, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+        return;
+    }
+    while (atomic_load_explicit(&barrier->generation, memory_order_acquire) == gen) {
+        syscall(SYS_futex, &barrier->generation, FUTEX_WAIT_PRIVATE, gen, NULL, NULL, 0);
+    }
+}
+
+typedef struct {
+    BackendBody body;
+    void *ctx;
+    int tid;
+    int num_threads;
+} BackendTask;
+
+// Persistent pool state: workers 1..num_threads-1, the caller acts as worker 0
+static struct {
+    int num_threads;
+    pthread_t *threads;
+    BackendTask *tasks;
+    FutexBarrier start;
+    FutexBarrier done;
+    BackendBody body;
+    void *ctx;
+    int shutdown;
+} backend_pool;
+
+static void *backend_pool_worker(void *arg) {
+    BackendTask *task = (BackendTask *) arg;
+    for (;;) {
+        futex_barrier_wait(&backend_pool.start);
+        if (backend_pool.shutdown) break;
+        backend_pool.body(task->tid, task->num_threads, backend_pool.ctx);
+        futex_barrier_wait(&backend_pool.done);
+    }
+    return NULL;
+}
+
+static void backend_pool_shutdown(void) {
+    if (backend_pool.num_threads == 0) return;
+    backend_pool.shutdown = 1;
+    futex_barrier_wait(&backend_pool.start);
+    for (int t = 1; t < backend_pool.num_threads; t++) {
+        pthread_join(backend_pool.threads[t], NULL);
+    }
+    free(backend_pool.threads);
+    free(backend_pool.tasks);
+    backend_pool.num_threads = 0;
+}
+
+static void backend_pool_start(int num_threads) {
+    static int registered = 0;
+    if (!registered) {
+        atexit(backend_pool_shutdown);
+        registered = 1;
+    }
+
+    backend_pool.num_threads = num_threads;
+    backend_pool.shutdown = 0;
+    backend_pool.start.count = num_threads;
+    backend_pool.done.count = num_threads;
+    atomic_init(&backend_pool.start.arrived, 0);
+    atomic_init(&backend_pool.start.generation, 0);
+    atomic_init(&backend_pool.done.arrived, 0);
+    atomic_init(&backend_pool.done.generation, 0);
+    backend_pool.threads = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+    backend_pool.tasks = (BackendTask *) malloc(num_threads * sizeof(BackendTask));
+    if (!backend_pool.threads || !backend_pool.tasks) {
+        fprintf(stderr, "Memory allocation failed for the thread pool.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 1; t < num_threads; t++) {
+        backend_pool.tasks[t].tid = t;
+        backend_pool.tasks[t].num_threads = num_threads;
+        if (pthread_create(&backend_pool.threads[t], NULL, backend_pool_worker, &backend_pool.tasks[t]) != 0) {
+            fprintf(stderr, "Failed to start pool thread %d.\n", t);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void *backend_pthread_main(void *arg) {
+    BackendTask *task = (BackendTask *) arg;
+    task->body(task->tid, task->num_threads, task->ctx);
+    return NULL;
+}
+
+// Function to run body(tid, num_threads, ctx) for tid = 0..num_threads-1 on the given backend
+// and return once every thread has finished. The bodies split their work (and size their
+// per-thread results) by num_threads, so an OpenMP team smaller than requested (OMP_THREAD_LIMIT,
+// OMP_DYNAMIC, a nested region) would skip the missing threads' chunks; that is an error.
+static inline void backend_run(ThreadBackend backend, int num_threads, BackendBody body, void *ctx) {
+    if (backend == BACKEND_OPENMP) {
+        int team_size = num_threads;
+        #pragma omp parallel num_threads(num_threads)
+        {
+            if (omp_get_num_threads() == num_threads) {
+                body(omp_get_thread_num(), num_threads, ctx);
+            } else if (omp_get_thread_num() == 0) {
+                team_size = omp_get_num_threads();
+            }
+        }
+        if (team_size != num_threads) {
+            fprintf(stderr, "Error: OpenMP started %d of %d threads (check OMP_THREAD_LIMIT, OMP_DYNAMIC and nesting).\n",
+                    team_size, num_threads);
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+
+    if (backend == BACKEND_POOL) {
+        if (backend_pool.num_threads != num_threads) {
+            backend_pool_shutdown();
+            backend_pool_start(num_threads);
+        }
+        backend_pool.body = body;
+        backend_pool.ctx = ctx;
+        futex_barrier_wait(&backend_pool.start);
+        body(0, num_threads, ctx);
+        futex_barrier_wait(&backend_pool.done);
+        return;
+    }
+
+    // Fork-join: one new thread per worker on every call
+    pthread_t *threads = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+    BackendTask *tasks = (BackendTask *) malloc(num_threads * sizeof(BackendTask));
+    if (!threads || !tasks) {
+        fprintf(stderr, "Memory allocation failed for %d threads.\n", num_threads);
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        tasks[t].body = body;
+        tasks[t].ctx = ctx;
+        tasks[t].tid = t;
+        tasks[t].num_threads = num_threads;
+    }
+    for (int t = 1; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, backend_pthread_main, &tasks[t]) != 0) {
+            fprintf(stderr, "Failed to start thread %d.\n", t);
+            exit(EXIT_FAILURE);
+        }
+    }
+    body(0, num_threads, ctx);
+    for (int t = 1; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    free(tasks);
+}
+
+#endif // THREAD_BACKEND_H